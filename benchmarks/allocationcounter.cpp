@@ -0,0 +1,43 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "allocationcounter.hpp"
+
+
+namespace
+{
+
+
+std::atomic<long> numAllocations{0};
+
+
+} // unnamed namespace end
+
+
+long numHeapAllocations()
+{
+	return numAllocations;
+}
+
+
+// The other forms of operator new and delete end up calling these.
+
+void * operator new(std::size_t size)
+{
+	++numAllocations;
+	if (void *ptr = std::malloc((size > 0) ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
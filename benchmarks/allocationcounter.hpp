@@ -0,0 +1,20 @@
+#ifndef ALLOCATIONCOUNTER_HPP
+#define ALLOCATIONCOUNTER_HPP
+
+
+/*
+	Counts the heap allocations of the whole process. Linking
+	allocationcounter.cpp into a benchmark replaces the global
+	operator new for this purpose.
+*/
+
+
+/*!
+	\fn numHeapAllocations()
+
+	Returns the number of times operator new was called so far.
+*/
+long numHeapAllocations();
+
+
+#endif // ALLOCATIONCOUNTER_HPP
@@ -0,0 +1,294 @@
+// Headless frame time benchmark for BGTimeSeriesView.
+//
+// The view is rendered with QQuickRenderControl and the software scene
+// graph backend, so this runs on machines without GPU and without a
+// display. For a number of series sizes, item widths and update patterns,
+// the time spent per frame in updatePolish(), in updatePaintNode(), in
+// synchronizing the scene graph (which includes updatePaintNode()) and in
+// rendering is measured, and the median and mean are printed.
+//
+// Usage: bench_bgtimeseriesview [--frames <number of frames per scenario>]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QImage>
+#include <QPointF>
+#include <QQuickRenderControl>
+#include <QQuickWindow>
+#include <QSGRendererInterface>
+#include <QStringList>
+#include <QVariant>
+#include "bgtimeseriesview.hpp"
+
+
+namespace
+{
+
+
+enum class UpdatePattern
+{
+	// A completely new series is assigned every frame.
+	FULL_REPLACE,
+	// The series is shifted by one reading every frame, like
+	// when a new reading arrives and the oldest one is dropped.
+	APPEND,
+	// The series stays the same, but the item width changes
+	// every frame, like during a resize animation.
+	RESIZE_ANIMATION
+};
+
+
+char const * updatePatternName(UpdatePattern pattern)
+{
+	switch (pattern)
+	{
+		case UpdatePattern::FULL_REPLACE: return "replace";
+		case UpdatePattern::APPEND: return "append";
+		case UpdatePattern::RESIZE_ANIMATION: return "resize";
+	}
+
+	return "";
+}
+
+
+class TimedBGTimeSeriesView
+	: public BGTimeSeriesView
+{
+public:
+	qint64 m_polishNsecs = 0;
+	qint64 m_updatePaintNodeNsecs = 0;
+
+protected:
+	void updatePolish() override
+	{
+		QElapsedTimer timer;
+		timer.start();
+		BGTimeSeriesView::updatePolish();
+		m_polishNsecs += timer.nsecsElapsed();
+	}
+
+	QSGNode* updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *updatePaintNodeData) override
+	{
+		QElapsedTimer timer;
+		timer.start();
+		QSGNode *node = BGTimeSeriesView::updatePaintNode(oldNode, updatePaintNodeData);
+		m_updatePaintNodeNsecs += timer.nsecsElapsed();
+		return node;
+	}
+};
+
+
+// Produces a random walk of BG readings in 5 minute intervals, with values
+// in the normalized 0..1 range the BGDataReceiver time series use.
+std::vector<float> generateBGValues(std::size_t numValues, unsigned int seed)
+{
+	std::mt19937 randomEngine(seed);
+	std::normal_distribution<float> stepDistribution(0.0f, 0.015f);
+
+	std::vector<float> values(numValues);
+	float value = 0.4f;
+	for (auto & v : values)
+	{
+		value = std::clamp(value + stepDistribution(randomEngine), 0.05f, 0.95f);
+		v = value;
+	}
+
+	return values;
+}
+
+
+QVariantList toTimeSeries(std::vector<float> const &values, std::size_t offset, std::size_t numPoints)
+{
+	QVariantList timeSeries;
+	timeSeries.reserve(int(numPoints));
+	for (std::size_t i = 0; i < numPoints; ++i)
+	{
+		qreal x = (numPoints > 1) ? (qreal(i) / qreal(numPoints - 1)) : 0.0;
+		timeSeries.append(QPointF(x, values[offset + i]));
+	}
+
+	return timeSeries;
+}
+
+
+struct Statistics
+{
+	double m_medianUsecs;
+	double m_meanUsecs;
+};
+
+
+Statistics computeStatistics(std::vector<qint64> nsecs)
+{
+	if (nsecs.empty())
+		return { 0.0, 0.0 };
+
+	std::sort(nsecs.begin(), nsecs.end());
+	std::size_t middle = nsecs.size() / 2;
+	double median = ((nsecs.size() % 2) != 0) ? nsecs[middle] : ((nsecs[middle - 1] + nsecs[middle]) / 2.0);
+	double mean = std::accumulate(nsecs.begin(), nsecs.end(), 0.0) / nsecs.size();
+
+	return { median / 1000.0, mean / 1000.0 };
+}
+
+
+void runScenario(std::size_t numPoints, int itemWidth, UpdatePattern pattern, int numFrames)
+{
+	int const itemHeight = 200;
+	// The first frames set up the nodes and textures, and are
+	// therefore not representative. They are not measured.
+	int const numWarmupFrames = 2;
+	int const numTotalFrames = numWarmupFrames + numFrames;
+
+	QQuickRenderControl renderControl;
+	QQuickWindow window(&renderControl);
+	window.resize(itemWidth, itemHeight);
+
+	TimedBGTimeSeriesView view;
+	view.setParentItem(window.contentItem());
+	view.setSize(QSizeF(itemWidth, itemHeight));
+	view.setColor(Qt::black);
+
+	renderControl.initialize(nullptr);
+
+	// Generate all series up front, so that the time needed for
+	// that does not end up in the measurements.
+	std::vector<float> values = generateBGValues(numPoints + numTotalFrames, 1234);
+	std::vector<QVariantList> replacementSeries;
+	if (pattern == UpdatePattern::FULL_REPLACE)
+	{
+		std::vector<float> otherValues = generateBGValues(numPoints, 5678);
+		replacementSeries.push_back(toTimeSeries(values, 0, numPoints));
+		replacementSeries.push_back(toTimeSeries(otherValues, 0, numPoints));
+	}
+
+	view.setBGTimeSeries(toTimeSeries(values, 0, numPoints));
+
+	std::vector<qint64> polishNsecs, updatePaintNodeNsecs, syncNsecs, renderNsecs;
+
+	for (int frame = 0; frame < numTotalFrames; ++frame)
+	{
+		switch (pattern)
+		{
+			case UpdatePattern::FULL_REPLACE:
+				view.setBGTimeSeries(replacementSeries[frame % replacementSeries.size()]);
+				break;
+
+			case UpdatePattern::APPEND:
+				view.setBGTimeSeries(toTimeSeries(values, frame + 1, numPoints));
+				break;
+
+			case UpdatePattern::RESIZE_ANIMATION:
+			{
+				// Shrink to 75% of the width and grow back again over 30 frames.
+				double phase = std::cos(2.0 * M_PI * frame / 30.0);
+				view.setWidth(std::round(itemWidth * (0.875 + 0.125 * phase)));
+				break;
+			}
+		}
+
+		view.m_polishNsecs = 0;
+		view.m_updatePaintNodeNsecs = 0;
+
+		QElapsedTimer timer;
+
+		renderControl.polishItems();
+
+		timer.start();
+		renderControl.sync();
+		qint64 syncTime = timer.nsecsElapsed();
+
+		// With the software backend, grab() renders the scene into
+		// an image, which is what render() needs as its paint device.
+		timer.start();
+		QImage image = renderControl.grab();
+		qint64 renderTime = timer.nsecsElapsed();
+
+		if (image.isNull())
+		{
+			std::fprintf(stderr, "Could not render the scene\n");
+			std::exit(1);
+		}
+
+		if (frame < numWarmupFrames)
+			continue;
+
+		polishNsecs.push_back(view.m_polishNsecs);
+		updatePaintNodeNsecs.push_back(view.m_updatePaintNodeNsecs);
+		syncNsecs.push_back(syncTime);
+		renderNsecs.push_back(renderTime);
+	}
+
+	Statistics polish = computeStatistics(polishNsecs);
+	Statistics updatePaintNode = computeStatistics(updatePaintNodeNsecs);
+	Statistics sync = computeStatistics(syncNsecs);
+	Statistics render = computeStatistics(renderNsecs);
+
+	std::printf(
+		"%7zu %6d %-8s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+		numPoints, itemWidth, updatePatternName(pattern),
+		polish.m_medianUsecs, polish.m_meanUsecs,
+		updatePaintNode.m_medianUsecs, updatePaintNode.m_meanUsecs,
+		sync.m_medianUsecs, sync.m_meanUsecs,
+		render.m_medianUsecs, render.m_meanUsecs
+	);
+	std::fflush(stdout);
+}
+
+
+} // unnamed namespace end
+
+
+int main(int argc, char *argv[])
+{
+	// Run headless unless a platform is explicitly requested.
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QQuickWindow::setSceneGraphBackend(QSGRendererInterface::Software);
+
+	QGuiApplication application(argc, argv);
+
+	int numFrames = 100;
+	QStringList arguments = application.arguments();
+	int framesArgIndex = arguments.indexOf(QStringLiteral("--frames"));
+	if (framesArgIndex >= 0)
+	{
+		bool ok = false;
+		numFrames = (framesArgIndex + 1 < arguments.size()) ? arguments[framesArgIndex + 1].toInt(&ok) : 0;
+		if (!ok || (numFrames < 1))
+		{
+			std::fprintf(stderr, "Usage: %s [--frames <number of frames per scenario>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::printf("Frame times in microseconds (median / mean over %d frames); sync includes updatePaintNode\n\n", numFrames);
+	std::printf(
+		"%7s %6s %-8s %21s %21s %21s %21s\n",
+		"points", "width", "pattern",
+		"polish", "updatePaintNode", "sync", "render"
+	);
+
+	std::size_t const seriesSizes[] = { 1000, 10000, 100000 };
+	int const itemWidths[] = { 320, 1280 };
+	UpdatePattern const patterns[] = { UpdatePattern::FULL_REPLACE, UpdatePattern::APPEND, UpdatePattern::RESIZE_ANIMATION };
+
+	for (std::size_t numPoints : seriesSizes)
+	{
+		for (int itemWidth : itemWidths)
+		{
+			for (UpdatePattern pattern : patterns)
+				runScenario(numPoints, itemWidth, pattern, numFrames);
+		}
+	}
+
+	return 0;
+}
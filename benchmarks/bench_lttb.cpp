@@ -0,0 +1,260 @@
+// Compares the LTTB implementation of TimeSeriesSimplifier with the
+// original one of BGTimeSeriesView, which copied the points into
+// per-bucket vectors and recomputed each bucket average by iterating
+// over its points.
+//
+// For 1k, 10k and 100k points, the median time per simplification and
+// the number of heap allocations per simplification are printed. The
+// original version is copied below unchanged. It reads the points from
+// the QVariantList that BGTimeSeriesView used to keep; the view now
+// converts them once when the series is assigned, so that conversion
+// is part of the "original" numbers, but not of the new ones.
+//
+// Usage: bench_lttb [--repetitions <number of repetitions>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <QPointF>
+#include <QVariant>
+#include "allocationcounter.hpp"
+#include "timeseriessimplifier.hpp"
+
+
+namespace
+{
+
+
+// The original implementation from BGTimeSeriesView.
+void simplifyTimeSeries(QVariantList const &sourceSeries, std::vector<QPointF> &destSeries, int minBucketWidth, int viewWidth)
+{
+	// This implements Sveinn Steinarsson’s Largest-Triangle-Three-Buckets (LTTB) algorithm
+	// for downsampling time series data. Source: https://github.com/sveinn-steinarsson/flot-downsample
+	// The MSc thesis with a description of LTTB is found at: http://hdl.handle.net/1946/15343
+	//
+	// The number of buckets is chosen based on the width of the QML item and the
+	// desired minimum bucket with in pixels.
+	// TODO: Currently, the "dynamic" variant of LTTB is not implemented. It could yield
+	// better visual results and is worth investigating.
+
+	// Calculate the number of buckets by rounding the viewWidth/minBucketWidth result.
+	int numBuckets = ((viewWidth + (minBucketWidth -1)) / minBucketWidth);
+
+	// Check for the special case where the view width is large enough to accomodate
+	// for all source series data points. If so, then just return all source points.
+	if (numBuckets > sourceSeries.size())
+	{
+		destSeries.resize(sourceSeries.size());
+		for (int i = 0; i < sourceSeries.size(); ++i)
+			destSeries[i] = sourceSeries[i].toPointF();
+		return;
+	}
+
+	struct Bucket
+	{
+		std::vector<QPointF> m_points;
+		int m_selectedPointIndex;
+	};
+
+	std::vector<Bucket> buckets;
+
+	// Step 1: Initialize the buckets and assign each source series
+	// point to an appropriate bucket. As per the definiton of LTTB,
+	// the first and last source data points are placed in the first
+	// and last buckets, respectively. Those buckets only contain
+	// those single points. The remaining source series data points
+	// are assigned to the remaining buckets based on the index
+	// of the source data point in the source series to produce
+	// buckets with approximately the same number of points in them.
+
+	buckets.resize(numBuckets);
+
+	buckets.front().m_points.push_back(sourceSeries.front().toPointF());
+	buckets.back().m_points.push_back(sourceSeries.back().toPointF());
+
+	// For each bucket, one of its points becomes "selected" (more
+	// on that below). In the first and last buckets, since there is
+	// exactly one point, only that single point can be the selected
+	// point of those buckets.
+	buckets.front().m_selectedPointIndex = 0;
+	buckets.back().m_selectedPointIndex = 0;
+
+	for (int sourcePointIndex = 1; sourcePointIndex < (sourceSeries.size() - 1); ++sourcePointIndex)
+	{
+		QPointF sourcePoint = sourceSeries[sourcePointIndex].toPointF();
+		int bucketIndex = (sourcePointIndex - 1) * (numBuckets - 2) / (sourceSeries.size() - 2) + 1;
+
+		buckets[bucketIndex].m_points.push_back(sourcePoint);
+	}
+
+	// Step 2: Rank the points in each bucket by going over each of
+	// them and calculating the are of the triangle that is described
+	// by the previous bucket's selected point, the current point
+	// that is being evaluated, and the average of all of the next
+	// bucket's points. The current bucket's point with the largest
+	// triangle area gets the highest rank and thus "wins", becoming
+	// the bucket's selected point.
+
+	for (int bucketIndex = 1; bucketIndex < (numBuckets - 1); ++bucketIndex)
+	{
+		Bucket const &previousBucket = buckets[bucketIndex - 1];
+		Bucket &currentBucket = buckets[bucketIndex];
+		Bucket const &nextBucket = buckets[bucketIndex + 1];
+
+		QPointF const &prevSelectedPoint = previousBucket.m_points[previousBucket.m_selectedPointIndex];
+
+		QPointF nextAveragePoint(0.0f, 0.0f);
+		for (auto const &nextBucketPoint : nextBucket.m_points)
+			nextAveragePoint += nextBucketPoint;
+		nextAveragePoint /= nextBucket.m_points.size();
+
+		float currentBestRank = 0;
+		int currentBestPointIndex = 0;
+
+		float x1 = prevSelectedPoint.x();
+		float y1 = prevSelectedPoint.y();
+		float x3 = nextAveragePoint.x();
+		float y3 = nextAveragePoint.y();
+
+		for (std::size_t bucketPointIndex = 0; bucketPointIndex < currentBucket.m_points.size(); ++bucketPointIndex)
+		{
+			float x2 = currentBucket.m_points[bucketPointIndex].x();
+			float y2 = currentBucket.m_points[bucketPointIndex].y();
+
+			// The correct triangle area formulat is:
+			//
+			//   (x1 * (y2 - y3) + x2 * (y3 - y1) + x3 * (y1 - y2)) * 0.5
+			//
+			// However, since we only need the area values for comparison purposes
+			// to find the "best" point, we omit the "* 0.5" as a small optimization,
+			// hence getting the "doubleTriangleArea" instead.
+			float doubleTriangleArea = (x1 * (y2 - y3) + x2 * (y3 - y1) + x3 * (y1 - y2));
+
+			if (doubleTriangleArea > currentBestRank)
+			{
+				currentBestRank = doubleTriangleArea;
+				currentBestPointIndex = bucketPointIndex;
+			}
+		}
+
+		currentBucket.m_selectedPointIndex = currentBestPointIndex;
+	}
+
+	// Step 3: Produce a new time series out of the selected points of each bucket.
+
+	destSeries.resize(numBuckets);
+	for (int bucketIndex = 0; bucketIndex < numBuckets; ++bucketIndex)
+	{
+		Bucket const &bucket = buckets[bucketIndex];
+		destSeries[bucketIndex] = bucket.m_points[bucket.m_selectedPointIndex];
+	}
+}
+
+std::vector<QPointF> generateRandomWalk(int numPoints)
+{
+	std::mt19937 randomEngine(42);
+	std::normal_distribution<double> stepDistribution(0.0, 0.01);
+
+	std::vector<QPointF> points(numPoints);
+	double value = 0.5;
+	for (int i = 0; i < numPoints; ++i)
+	{
+		value = std::clamp(value + stepDistribution(randomEngine), 0.0, 1.0);
+		points[i] = QPointF(double(i) / (numPoints - 1), value);
+	}
+
+	return points;
+}
+
+
+struct Result
+{
+	double m_medianUsecs;
+	double m_allocationsPerCall;
+};
+
+
+template<typename Function>
+Result measure(int numRepetitions, Function const &function)
+{
+	// One call up front, which lets the new implementation
+	// grow its scratch buffers, like after the first frame.
+	function();
+
+	std::vector<double> usecs;
+	usecs.reserve(numRepetitions);
+	long allocationsBefore = numHeapAllocations();
+
+	for (int repetition = 0; repetition < numRepetitions; ++repetition)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		auto end = std::chrono::steady_clock::now();
+		usecs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+	}
+
+	long allocations = numHeapAllocations() - allocationsBefore;
+
+	std::sort(usecs.begin(), usecs.end());
+	return { usecs[usecs.size() / 2], double(allocations) / numRepetitions };
+}
+
+
+} // unnamed namespace end
+
+
+int main(int argc, char *argv[])
+{
+	int numRepetitions = 101;
+	if ((argc == 3) && (std::strcmp(argv[1], "--repetitions") == 0))
+		numRepetitions = std::max(std::atoi(argv[2]), 1);
+	else if (argc != 1)
+	{
+		std::fprintf(stderr, "Usage: %s [--repetitions <number of repetitions>]\n", argv[0]);
+		return 1;
+	}
+
+	// A view that is 400 pixels wide, with the default
+	// minimum bucket width of 2 pixels.
+	int const viewWidth = 400;
+	int const minBucketWidth = 2;
+	int const numBuckets = (viewWidth + (minBucketWidth - 1)) / minBucketWidth;
+
+	std::printf("Median time per simplification to %d points over %d repetitions, and heap allocations per simplification\n\n", numBuckets, numRepetitions);
+	std::printf("%7s %14s %14s %8s %14s %14s\n", "points", "original (us)", "allocations", "speedup", "new (us)", "allocations");
+
+	for (int numPoints : { 1000, 10000, 100000 })
+	{
+		std::vector<QPointF> points = generateRandomWalk(numPoints);
+		QVariantList variantPoints;
+		for (QPointF const &point : points)
+			variantPoints.append(point);
+
+		std::vector<QPointF> originalDestPoints;
+		Result original = measure(numRepetitions, [&]() {
+			simplifyTimeSeries(variantPoints, originalDestPoints, minBucketWidth, viewWidth);
+		});
+
+		TimeSeriesSimplifier simplifier;
+		// Compare against the single-threaded selection, like the original.
+		simplifier.setMaxNumThreads(1);
+		std::vector<QPointF> newDestPoints;
+		Result current = measure(numRepetitions, [&]() {
+			simplifier.simplifyLTTB(points.data(), numPoints, numBuckets, newDestPoints);
+		});
+
+		std::printf(
+			"%7d %14.1f %14.1f %7.1fx %14.1f %14.1f\n",
+			numPoints,
+			original.m_medianUsecs, original.m_allocationsPerCall,
+			original.m_medianUsecs / current.m_medianUsecs,
+			current.m_medianUsecs, current.m_allocationsPerCall
+		);
+	}
+
+	return 0;
+}
@@ -0,0 +1,129 @@
+// Thread scaling benchmark for the parallel LTTB point selection.
+//
+// Simplifies long random walks with 1 to 8 threads (see
+// TimeSeriesSimplifier::setMaxNumThreads()) and prints the median time
+// per call along with the speedup over the single-threaded selection.
+// The global QThreadPool is resized to 8 threads, so the numbers show
+// how the selection scales with the available cores, not with the
+// pool's default size.
+//
+// Usage: bench_lttbthreads [--repetitions <number of repetitions>]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <QPointF>
+#include <QThreadPool>
+#include "timeseriessimplifier.hpp"
+
+
+namespace
+{
+
+
+int const MAX_NUM_THREADS = 8;
+
+
+std::vector<QPointF> generateRandomWalk(int numPoints)
+{
+	std::mt19937 randomEngine(42);
+	std::normal_distribution<double> stepDistribution(0.0, 0.01);
+
+	std::vector<QPointF> points(numPoints);
+	double value = 0.5;
+	for (int i = 0; i < numPoints; ++i)
+	{
+		value = std::clamp(value + stepDistribution(randomEngine), 0.0, 1.0);
+		points[i] = QPointF(double(i) / (numPoints - 1), value);
+	}
+
+	return points;
+}
+
+
+double medianMsecs(std::vector<double> msecs)
+{
+	std::sort(msecs.begin(), msecs.end());
+	std::size_t middle = msecs.size() / 2;
+	return ((msecs.size() % 2) != 0) ? msecs[middle] : ((msecs[middle - 1] + msecs[middle]) / 2.0);
+}
+
+
+} // unnamed namespace end
+
+
+int main(int argc, char *argv[])
+{
+	int numRepetitions = 21;
+	if ((argc == 3) && (std::strcmp(argv[1], "--repetitions") == 0))
+		numRepetitions = std::max(std::atoi(argv[2]), 1);
+	else if (argc != 1)
+	{
+		std::fprintf(stderr, "Usage: %s [--repetitions <number of repetitions>]\n", argv[0]);
+		return 1;
+	}
+
+	QThreadPool::globalInstance()->setMaxThreadCount(MAX_NUM_THREADS);
+
+	std::printf("Median time per simplification in milliseconds over %d repetitions (speedup over 1 thread)\n\n", numRepetitions);
+	std::printf("%8s %7s %-12s", "points", "buckets", "mode");
+	for (int numThreads = 1; numThreads <= MAX_NUM_THREADS; ++numThreads)
+		std::printf(" %14d", numThreads);
+	std::printf("\n");
+
+	int const seriesSizes[] = { 100000, 1000000, 4000000 };
+	int const bucketCounts[] = { 1000, 10000 };
+
+	for (int numPoints : seriesSizes)
+	{
+		std::vector<QPointF> sourcePoints = generateRandomWalk(numPoints);
+
+		for (int numBuckets : bucketCounts)
+		{
+			for (bool dynamic : { false, true })
+			{
+				std::printf("%8d %7d %-12s", numPoints, numBuckets, dynamic ? "dynamic LTTB" : "LTTB");
+
+				double singleThreadMsecs = 0.0;
+
+				for (int numThreads = 1; numThreads <= MAX_NUM_THREADS; ++numThreads)
+				{
+					TimeSeriesSimplifier simplifier;
+					simplifier.setMaxNumThreads(numThreads);
+					std::vector<QPointF> destPoints;
+					std::vector<double> msecs;
+
+					// One extra call up front, which grows the scratch buffers.
+					for (int repetition = 0; repetition <= numRepetitions; ++repetition)
+					{
+						auto start = std::chrono::steady_clock::now();
+						if (dynamic)
+							simplifier.simplifyDynamicLTTB(sourcePoints.data(), numPoints, numBuckets, destPoints);
+						else
+							simplifier.simplifyLTTB(sourcePoints.data(), numPoints, numBuckets, destPoints);
+						auto end = std::chrono::steady_clock::now();
+
+						if (repetition > 0)
+							msecs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+					}
+
+					double median = medianMsecs(msecs);
+					if (numThreads == 1)
+						singleThreadMsecs = median;
+
+					std::printf(" %7.2f (%4.2fx)", median, singleThreadMsecs / median);
+				}
+
+				std::printf("\n");
+				std::fflush(stdout);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,110 @@
+// Counts the heap allocations per read of the BGDataReceiver properties
+// that QML bindings typically use.
+//
+// "before" is what each read cost when the getters created a new QVariant
+// with QVariant::fromValue() every time. "after" reads the property through
+// its QMetaProperty, like the QML engine does, which now only copies the
+// QVariant that the receiver built when the value changed. The receiver is
+// filled with generateTestQuantities(), so none of the properties are null.
+//
+// Usage: bench_propertygetters [--reads <number of reads per property>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <QCoreApplication>
+#include <QMetaProperty>
+#include <QVariant>
+#include "allocationcounter.hpp"
+#include "bgdatareceiver.hpp"
+
+
+namespace
+{
+
+
+struct Result
+{
+	double m_allocationsPerRead;
+	double m_nsecsPerRead;
+};
+
+
+template<typename Function>
+Result measure(int numReads, Function const &function)
+{
+	long allocationsBefore = numHeapAllocations();
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < numReads; ++i)
+		function();
+
+	auto end = std::chrono::steady_clock::now();
+	long allocations = numHeapAllocations() - allocationsBefore;
+
+	return {
+		double(allocations) / numReads,
+		double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / numReads
+	};
+}
+
+
+template<typename T>
+void measureProperty(BGDataReceiver &receiver, char const *propertyName, int numReads)
+{
+	QMetaObject const *metaObject = receiver.metaObject();
+	QMetaProperty property = metaObject->property(metaObject->indexOfProperty(propertyName));
+
+	T value = property.read(&receiver).value<T>();
+
+	Result before = measure(numReads, [&]() {
+		QVariant variant = QVariant::fromValue(value);
+		Q_UNUSED(variant);
+	});
+
+	Result after = measure(numReads, [&]() {
+		QVariant variant = property.read(&receiver);
+		Q_UNUSED(variant);
+	});
+
+	std::printf(
+		"%-16s %18.2f %12.1f %18.2f %12.1f\n",
+		propertyName,
+		before.m_allocationsPerRead, before.m_nsecsPerRead,
+		after.m_allocationsPerRead, after.m_nsecsPerRead
+	);
+}
+
+
+} // unnamed namespace end
+
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication application(argc, argv);
+
+	int numReads = 100000;
+	if ((argc == 3) && (std::strcmp(argv[1], "--reads") == 0))
+		numReads = std::max(std::atoi(argv[2]), 1);
+	else if (argc != 1)
+	{
+		std::fprintf(stderr, "Usage: %s [--reads <number of reads per property>]\n", argv[0]);
+		return 1;
+	}
+
+	BGDataReceiver receiver;
+	receiver.generateTestQuantities();
+
+	std::printf("Heap allocations and nanoseconds per property read, averaged over %d reads\n\n", numReads);
+	std::printf("%-16s %18s %12s %18s %12s\n", "property", "before: allocs", "ns", "after: allocs", "ns");
+
+	measureProperty<BGDataReceiver::Unit>(receiver, "unit", numReads);
+	measureProperty<BGStatus>(receiver, "bgStatus", numReads);
+	measureProperty<InsulinOnBoard>(receiver, "insulinOnBoard", numReads);
+	measureProperty<CarbsOnBoard>(receiver, "carbsOnBoard", numReads);
+	measureProperty<BasalRate>(receiver, "basalRate", numReads);
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+// Throughput benchmark for the SIMD kernels.
+//
+// Like the test, this is built once per instruction set (see
+// benchmarks/CMakeLists.txt), so the variants can be compared by running
+// all bench_simdkernels_* executables. The time per element is printed
+// for each kernel; the minimum over all repetitions is used, since it is
+// the least affected by other activity on the machine.
+//
+// Usage: bench_simdkernels_<variant> [--repetitions <number of repetitions>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include <QPointF>
+#include "simdkernels.hpp"
+
+
+namespace
+{
+
+
+// Keeps the compiler from optimizing away the benchmarked calls.
+volatile double sink;
+
+
+template<typename Function>
+double measureMinNsecsPerElement(int numRepetitions, int numElements, Function const &function)
+{
+	double minNsecs = std::numeric_limits<double>::max();
+
+	for (int repetition = 0; repetition < numRepetitions; ++repetition)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		auto end = std::chrono::steady_clock::now();
+		minNsecs = std::min(minNsecs, double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+	}
+
+	return minNsecs / numElements;
+}
+
+
+} // unnamed namespace end
+
+
+int main(int argc, char *argv[])
+{
+	int numRepetitions = 200;
+	if ((argc == 3) && (std::strcmp(argv[1], "--repetitions") == 0))
+		numRepetitions = std::max(std::atoi(argv[2]), 1);
+	else if (argc != 1)
+	{
+		std::fprintf(stderr, "Usage: %s [--repetitions <number of repetitions>]\n", argv[0]);
+		return 1;
+	}
+
+	int const numPoints = 100000;
+	// The typical LTTB bucket size when 100k points are drawn on a
+	// watch display that is a few hundred pixels wide.
+	int const bucketSize = 250;
+
+	std::mt19937 randomEngine(42);
+	std::uniform_int_distribution<int> byteDistribution(0, 255);
+	std::uniform_real_distribution<double> coordinateDistribution(0.0, 1.0);
+
+	std::vector<char> data(numPoints * 4);
+	for (auto & byte : data)
+		byte = char(byteDistribution(randomEngine));
+
+	std::vector<QPointF> points(numPoints);
+	for (auto & point : points)
+		point = QPointF(coordinateDistribution(randomEngine), coordinateDistribution(randomEngine));
+
+	std::vector<QPointF> results(numPoints + 1);
+
+	double unpackNsecs = measureMinNsecsPerElement(numRepetitions, numPoints, [&]() {
+		unpackNormalizedInt16Pairs(data.data(), numPoints, results.data());
+		sink = results[numPoints - 1].x();
+	});
+
+	double prefixSumsNsecs = measureMinNsecsPerElement(numRepetitions, numPoints, [&]() {
+		computePrefixSums(points.data(), numPoints, results.data());
+		sink = results[numPoints].x();
+	});
+
+	// Go through the points bucket by bucket, like LTTB does.
+	double largestTriangleNsecs = measureMinNsecsPerElement(numRepetitions, numPoints, [&]() {
+		int indexSum = 0;
+		for (int begin = 0; begin < numPoints; begin += bucketSize)
+			indexSum += findLargestTriangle(points.data(), begin, std::min(begin + bucketSize, numPoints), QPointF(0.0, 0.5), QPointF(1.0, 0.5));
+		sink = indexSum;
+	});
+
+	std::printf("Instruction set: %s\n", simdInstructionSet());
+	std::printf("Nanoseconds per point (minimum of %d repetitions over %d points):\n", numRepetitions, numPoints);
+	std::printf("  unpackNormalizedInt16Pairs  %6.3f\n", unpackNsecs);
+	std::printf("  computePrefixSums           %6.3f\n", prefixSumsNsecs);
+	std::printf("  findLargestTriangle         %6.3f\n", largestTriangleNsecs);
+
+	return 0;
+}
@@ -0,0 +1,284 @@
+// Compares the cost and the visual error of the simplification modes
+// of BGTimeSeriesView.
+//
+// A random walk with occasional short dips (like brief lows) is simplified
+// with each mode and drawn with the hairline rasterizer at the size of a
+// typical view. The images are then compared with the image of the full,
+// unsimplified series, which is what SimplificationMode.NONE draws. Two
+// errors are printed:
+//
+// - The pixel error is the summed absolute difference of the coverage
+//   (alpha) values, relative to the summed coverage of the reference
+//   image. 0% means that the graphs look identical.
+// - The envelope error is the largest vertical distance (in pixels)
+//   between the lowest or highest point of the graph within a bucket
+//   wide column and that of the full series. This shows whether extreme
+//   values such as lows are lost. It is computed from the polylines
+//   themselves, since the antialiased coverage of a steep, subpixel
+//   wide dip depends too much on where exactly its points lie.
+//
+// The cost is the median time per simplification, with single-threaded
+// point selection.
+//
+// Usage: bench_simplificationmodes [--repetitions <number of repetitions>]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include <QColor>
+#include <QImage>
+#include <QPointF>
+#include "graphrasterizer.hpp"
+#include "timeseriessimplifier.hpp"
+
+
+namespace
+{
+
+
+int const VIEW_WIDTH = 400;
+int const VIEW_HEIGHT = 200;
+
+
+enum class Mode
+{
+	LTTB,
+	DYNAMIC_LTTB,
+	MIN_MAX,
+	NONE
+};
+
+
+char const * modeName(Mode mode)
+{
+	switch (mode)
+	{
+		case Mode::LTTB: return "LTTB";
+		case Mode::DYNAMIC_LTTB: return "DYNAMIC_LTTB";
+		case Mode::MIN_MAX: return "MIN_MAX";
+		case Mode::NONE: return "NONE";
+	}
+
+	return "";
+}
+
+
+std::vector<QPointF> generateSeries(int numPoints)
+{
+	std::mt19937 randomEngine(42);
+	std::normal_distribution<double> stepDistribution(0.0, 0.01);
+	std::uniform_int_distribution<int> dipDistribution(0, 2999);
+
+	std::vector<QPointF> points(numPoints);
+	double value = 0.5;
+	int numRemainingDipPoints = 0;
+	for (int i = 0; i < numPoints; ++i)
+	{
+		value = std::clamp(value + stepDistribution(randomEngine), 0.2, 0.9);
+		double y = value;
+
+		// Every few thousand readings, a dip that lasts for 3 readings.
+		if ((numRemainingDipPoints == 0) && (dipDistribution(randomEngine) == 0))
+			numRemainingDipPoints = 3;
+		if (numRemainingDipPoints > 0)
+		{
+			y = 0.05;
+			--numRemainingDipPoints;
+		}
+
+		points[i] = QPointF(double(i) / (numPoints - 1), y);
+	}
+
+	return points;
+}
+
+
+// Maps the normalized points to pixels. The pixel columns
+// then match the columns of the MIN_MAX mode.
+std::vector<QPointF> toViewPoints(std::vector<QPointF> const &points)
+{
+	std::vector<QPointF> viewPoints(points.size());
+	for (std::size_t i = 0; i < points.size(); ++i)
+		viewPoints[i] = QPointF(points[i].x() * VIEW_WIDTH, (1.0 - points[i].y()) * (VIEW_HEIGHT - 1));
+	return viewPoints;
+}
+
+
+QImage drawGraph(std::vector<QPointF> const &viewPoints)
+{
+	QImage image(VIEW_WIDTH, VIEW_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+	rasterizeHairlinePolyline(viewPoints.data(), int(viewPoints.size()), QColor(Qt::black), 1.0f, image);
+	return image;
+}
+
+
+int coverageAt(QImage const &image, int x, int y)
+{
+	return qAlpha(reinterpret_cast<QRgb const *>(image.constScanLine(y))[x]);
+}
+
+
+double pixelError(QImage const &reference, QImage const &image)
+{
+	qint64 referenceCoverage = 0;
+	qint64 coverageDifference = 0;
+
+	for (int y = 0; y < reference.height(); ++y)
+	{
+		for (int x = 0; x < reference.width(); ++x)
+		{
+			referenceCoverage += coverageAt(reference, x, y);
+			coverageDifference += std::abs(coverageAt(reference, x, y) - coverageAt(image, x, y));
+		}
+	}
+
+	return 100.0 * coverageDifference / std::max(referenceCoverage, qint64(1));
+}
+
+
+// Lowest and highest y coordinate of the polyline within each pixel column.
+struct Envelope
+{
+	std::vector<double> m_minY = std::vector<double>(VIEW_WIDTH, std::numeric_limits<double>::max());
+	std::vector<double> m_maxY = std::vector<double>(VIEW_WIDTH, std::numeric_limits<double>::lowest());
+};
+
+
+Envelope computeEnvelope(std::vector<QPointF> const &viewPoints)
+{
+	Envelope envelope;
+
+	auto addPoint = [&](int column, double y) {
+		column = std::clamp(column, 0, VIEW_WIDTH - 1);
+		envelope.m_minY[column] = std::min(envelope.m_minY[column], y);
+		envelope.m_maxY[column] = std::max(envelope.m_maxY[column], y);
+	};
+
+	for (std::size_t i = 0; i + 1 < viewPoints.size(); ++i)
+	{
+		QPointF const &start = viewPoints[i];
+		QPointF const &end = viewPoints[i + 1];
+		double slope = (end.x() > start.x()) ? ((end.y() - start.y()) / (end.x() - start.x())) : 0.0;
+
+		// Clip the segment to each column it crosses. Since it is
+		// straight, its extremes within a column lie at the ends.
+		int firstColumn = int(std::floor(start.x()));
+		int lastColumn = int(std::floor(end.x()));
+		for (int column = firstColumn; column <= lastColumn; ++column)
+		{
+			double clippedStartX = std::max(start.x(), double(column));
+			double clippedEndX = std::min(end.x(), double(column + 1));
+			addPoint(column, start.y() + (clippedStartX - start.x()) * slope);
+			addPoint(column, (column == lastColumn) ? end.y() : (start.y() + (clippedEndX - start.x()) * slope));
+		}
+	}
+
+	return envelope;
+}
+
+
+// Compares the envelopes over groups of columns that are as wide as
+// the buckets. Within a bucket, the simplified graph cannot be expected
+// to follow the series, but its extremes should match.
+double envelopeError(Envelope const &reference, Envelope const &envelope, int groupWidth)
+{
+	double error = 0.0;
+
+	for (int groupBegin = 0; groupBegin < VIEW_WIDTH; groupBegin += groupWidth)
+	{
+		int groupEnd = std::min(groupBegin + groupWidth, VIEW_WIDTH);
+		auto groupMin = [&](Envelope const &e) { return *std::min_element(e.m_minY.begin() + groupBegin, e.m_minY.begin() + groupEnd); };
+		auto groupMax = [&](Envelope const &e) { return *std::max_element(e.m_maxY.begin() + groupBegin, e.m_maxY.begin() + groupEnd); };
+
+		if (groupMin(reference) > groupMax(reference))
+			continue;
+
+		error = std::max(error, std::abs(groupMin(reference) - groupMin(envelope)));
+		error = std::max(error, std::abs(groupMax(reference) - groupMax(envelope)));
+	}
+
+	return error;
+}
+
+
+} // unnamed namespace end
+
+
+int main(int argc, char *argv[])
+{
+	int numRepetitions = 51;
+	if ((argc == 3) && (std::strcmp(argv[1], "--repetitions") == 0))
+		numRepetitions = std::max(std::atoi(argv[2]), 1);
+	else if (argc != 1)
+	{
+		std::fprintf(stderr, "Usage: %s [--repetitions <number of repetitions>]\n", argv[0]);
+		return 1;
+	}
+
+	std::printf("%dx%d pixel view; median time per simplification over %d repetitions\n\n", VIEW_WIDTH, VIEW_HEIGHT, numRepetitions);
+	std::printf("%7s %13s %-13s %8s %10s %12s %14s\n", "points", "bucket width", "mode", "points", "time (us)", "pixel error", "envelope error");
+
+	Mode const modes[] = { Mode::LTTB, Mode::DYNAMIC_LTTB, Mode::MIN_MAX, Mode::NONE };
+
+	for (int numPoints : { 10000, 100000 })
+	{
+		std::vector<QPointF> sourcePoints = generateSeries(numPoints);
+		std::vector<QPointF> referenceViewPoints = toViewPoints(sourcePoints);
+		QImage referenceImage = drawGraph(referenceViewPoints);
+		Envelope referenceEnvelope = computeEnvelope(referenceViewPoints);
+
+		for (int minBucketWidth : { 1, 3 })
+		{
+			// Same as in BGTimeSeriesView::updatePolish(), with
+			// the normalized timestamps spanning the whole view.
+			int numBuckets = (VIEW_WIDTH + (minBucketWidth - 1)) / minBucketWidth;
+			double columnWidth = double(minBucketWidth) / VIEW_WIDTH;
+
+			for (Mode mode : modes)
+			{
+				TimeSeriesSimplifier simplifier;
+				simplifier.setMaxNumThreads(1);
+				std::vector<QPointF> destPoints;
+				std::vector<double> usecs;
+
+				// One extra call up front, which grows the scratch buffers.
+				for (int repetition = 0; repetition <= numRepetitions; ++repetition)
+				{
+					auto start = std::chrono::steady_clock::now();
+					switch (mode)
+					{
+						case Mode::LTTB: simplifier.simplifyLTTB(sourcePoints.data(), numPoints, numBuckets, destPoints); break;
+						case Mode::DYNAMIC_LTTB: simplifier.simplifyDynamicLTTB(sourcePoints.data(), numPoints, numBuckets, destPoints); break;
+						case Mode::MIN_MAX: simplifier.simplifyMinMax(sourcePoints.data(), numPoints, columnWidth, destPoints); break;
+						case Mode::NONE: destPoints.assign(sourcePoints.begin(), sourcePoints.end()); break;
+					}
+					auto end = std::chrono::steady_clock::now();
+
+					if (repetition > 0)
+						usecs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+				}
+
+				std::sort(usecs.begin(), usecs.end());
+
+				std::vector<QPointF> viewPoints = toViewPoints(destPoints);
+
+				std::printf(
+					"%7d %13d %-13s %8zu %10.1f %11.1f%% %14.1f\n",
+					numPoints, minBucketWidth, modeName(mode), destPoints.size(),
+					usecs[usecs.size() / 2],
+					pixelError(referenceImage, drawGraph(viewPoints)),
+					envelopeError(referenceEnvelope, computeEnvelope(viewPoints), minBucketWidth)
+				);
+			}
+		}
+	}
+
+	return 0;
+}
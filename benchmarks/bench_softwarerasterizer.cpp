@@ -0,0 +1,134 @@
+// Compares the CPU rasterizer that BGTimeSeriesView uses with the software
+// scene graph backend (see graphrasterizer.hpp) with drawing the same
+// polyline with an antialiased QPainter, which is the generic way to draw
+// lines into an image without a GPU.
+//
+// For a number of segment counts and line widths, the median time to draw
+// a random polyline into a 400x200 pixel image is printed. For wide lines,
+// the time of the dedicated path includes the tessellation, since the view
+// tessellates the graph every time it is rasterized again.
+//
+// The view as a whole, rendered by the software backend, is measured
+// by bench_bgtimeseriesview.
+//
+// Usage: bench_softwarerasterizer [--repetitions <number of repetitions>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QPen>
+#include <QPointF>
+#include "graphrasterizer.hpp"
+#include "linetessellator.hpp"
+
+
+namespace
+{
+
+
+int const IMAGE_WIDTH = 400;
+int const IMAGE_HEIGHT = 200;
+
+
+std::vector<QPointF> generatePolyline(int numSegments)
+{
+	std::mt19937 randomEngine(42);
+	std::normal_distribution<double> stepDistribution(0.0, 6.0);
+
+	std::vector<QPointF> points(numSegments + 1);
+	double y = IMAGE_HEIGHT / 2.0;
+	for (int i = 0; i <= numSegments; ++i)
+	{
+		y = std::clamp(y + stepDistribution(randomEngine), 5.0, IMAGE_HEIGHT - 5.0);
+		points[i] = QPointF(double(i) * (IMAGE_WIDTH - 1) / numSegments, y);
+	}
+
+	return points;
+}
+
+
+template<typename Function>
+double medianUsecs(int numRepetitions, QImage &image, Function const &function)
+{
+	std::vector<double> usecs;
+
+	for (int repetition = 0; repetition < numRepetitions; ++repetition)
+	{
+		image.fill(Qt::transparent);
+
+		auto start = std::chrono::steady_clock::now();
+		function();
+		auto end = std::chrono::steady_clock::now();
+
+		usecs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+	}
+
+	std::sort(usecs.begin(), usecs.end());
+	return usecs[usecs.size() / 2];
+}
+
+
+} // unnamed namespace end
+
+
+int main(int argc, char *argv[])
+{
+	int numRepetitions = 201;
+	if ((argc == 3) && (std::strcmp(argv[1], "--repetitions") == 0))
+		numRepetitions = std::max(std::atoi(argv[2]), 1);
+	else if (argc != 1)
+	{
+		std::fprintf(stderr, "Usage: %s [--repetitions <number of repetitions>]\n", argv[0]);
+		return 1;
+	}
+
+	QColor const color(Qt::black);
+	QImage image(IMAGE_WIDTH, IMAGE_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+	std::vector<QSGGeometry::ColoredPoint2D> vertices;
+
+	std::printf("Median time per polyline in microseconds over %d repetitions (%dx%d pixel image)\n\n", numRepetitions, IMAGE_WIDTH, IMAGE_HEIGHT);
+	std::printf("%8s %10s %14s %14s %8s\n", "segments", "line width", "rasterizer", "QPainter", "speedup");
+
+	for (int numSegments : { 100, 500, 2000 })
+	{
+		std::vector<QPointF> points = generatePolyline(numSegments);
+		int numPoints = int(points.size());
+
+		for (float lineWidth : { 1.0f, 3.0f })
+		{
+			double rasterizerUsecs = medianUsecs(numRepetitions, image, [&]() {
+				if (lineWidth <= 1.0f)
+				{
+					rasterizeHairlinePolyline(points.data(), numPoints, color, 1.0f, image);
+				}
+				else
+				{
+					vertices.clear();
+					appendThickPolyline(points.data(), numPoints, lineWidth, color, vertices);
+					rasterizeTriangleStrip(vertices.data(), int(vertices.size()), 1.0f, image);
+				}
+			});
+
+			double painterUsecs = medianUsecs(numRepetitions, image, [&]() {
+				QPainter painter(&image);
+				painter.setRenderHint(QPainter::Antialiasing);
+				painter.setPen(QPen(color, lineWidth));
+				painter.drawPolyline(points.data(), numPoints);
+			});
+
+			std::printf(
+				"%8d %10.0f %14.1f %14.1f %7.1fx\n",
+				numSegments, double(lineWidth), rasterizerUsecs, painterUsecs, painterUsecs / rasterizerUsecs
+			);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,140 @@
+#include <cmath>
+#include "bgalertevaluator.hpp"
+
+
+namespace
+{
+
+
+// Fast drop/rise alerts are cleared once the rate
+// falls below this fraction of the alert rate.
+float const RATE_HYSTERESIS_FACTOR = 2.0f / 3.0f;
+
+
+} // unnamed namespace end
+
+
+BGAlertEvaluator::BGAlertEvaluator()
+{
+	m_conditionsMet.fill(false);
+	m_raised.fill(false);
+	m_snoozeEnds.fill(0);
+}
+
+
+BGAlertEvaluator::Settings const & BGAlertEvaluator::settings() const
+{
+	return m_settings;
+}
+
+
+void BGAlertEvaluator::setSettings(Settings newSettings)
+{
+	m_settings = std::move(newSettings);
+}
+
+
+void BGAlertEvaluator::evaluate(Input const &input, qint64 now, std::vector<Transition> &transitions)
+{
+	transitions.clear();
+
+	for (int alertIndex = 0; alertIndex < NUM_ALERTS; ++alertIndex)
+	{
+		Alert alert = Alert(alertIndex);
+
+		m_conditionsMet[alertIndex] = evaluateCondition(alert, input, now);
+
+		bool isSnoozed = (now < m_snoozeEnds[alertIndex]);
+		bool raised = m_conditionsMet[alertIndex] && !isSnoozed;
+
+		if (raised != m_raised[alertIndex])
+		{
+			m_raised[alertIndex] = raised;
+			transitions.push_back({ alert, raised });
+		}
+	}
+}
+
+
+std::optional<qint64> BGAlertEvaluator::nextEvaluationTime(Input const &input, qint64 now) const
+{
+	std::optional<qint64> nextTime;
+
+	auto considerTime = [&](qint64 time) {
+		if ((time > now) && (!nextTime.has_value() || (time < *nextTime)))
+			nextTime = time;
+	};
+
+	if ((m_settings.m_staleDataTimeout > 0) && input.m_lastValidBGTimestamp.has_value())
+		considerTime(*input.m_lastValidBGTimestamp + m_settings.m_staleDataTimeout * 60);
+
+	for (qint64 snoozeEnd : m_snoozeEnds)
+		considerTime(snoozeEnd);
+
+	return nextTime;
+}
+
+
+void BGAlertEvaluator::snooze(Alert alert, qint64 snoozeEnd)
+{
+	m_snoozeEnds[int(alert)] = snoozeEnd;
+}
+
+
+bool BGAlertEvaluator::isRaised(Alert alert) const
+{
+	return m_raised[int(alert)];
+}
+
+
+bool BGAlertEvaluator::evaluateCondition(Alert alert, Input const &input, qint64 now) const
+{
+	// With hysteresis, the condition for staying in the "met" state
+	// is weaker than the condition for entering it. This prevents
+	// alerts from flapping when the BG value hovers around a threshold.
+	bool wasMet = m_conditionsMet[int(alert)];
+
+	switch (alert)
+	{
+		case Alert::LOW:
+		{
+			if (!input.m_hasBGValue || (m_settings.m_lowThreshold <= 0.0f))
+				return false;
+			float threshold = m_settings.m_lowThreshold + (wasMet ? m_settings.m_hysteresis : 0.0f);
+			return input.m_bgValue < threshold;
+		}
+
+		case Alert::HIGH:
+		{
+			if (!input.m_hasBGValue || (m_settings.m_highThreshold <= 0.0f))
+				return false;
+			float threshold = m_settings.m_highThreshold - (wasMet ? m_settings.m_hysteresis : 0.0f);
+			return input.m_bgValue > threshold;
+		}
+
+		case Alert::FAST_DROP:
+		{
+			if (std::isnan(input.m_rate) || (m_settings.m_fastDropRate <= 0.0f))
+				return false;
+			float rate = m_settings.m_fastDropRate * (wasMet ? RATE_HYSTERESIS_FACTOR : 1.0f);
+			return input.m_rate < -rate;
+		}
+
+		case Alert::FAST_RISE:
+		{
+			if (std::isnan(input.m_rate) || (m_settings.m_fastRiseRate <= 0.0f))
+				return false;
+			float rate = m_settings.m_fastRiseRate * (wasMet ? RATE_HYSTERESIS_FACTOR : 1.0f);
+			return input.m_rate > rate;
+		}
+
+		case Alert::STALE_DATA:
+		{
+			if (!input.m_lastValidBGTimestamp.has_value() || (m_settings.m_staleDataTimeout <= 0))
+				return false;
+			return (now - *input.m_lastValidBGTimestamp) >= (qint64(m_settings.m_staleDataTimeout) * 60);
+		}
+	}
+
+	return false;
+}
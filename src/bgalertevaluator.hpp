@@ -0,0 +1,136 @@
+#ifndef BGALERTEVALUATOR_HPP
+#define BGALERTEVALUATOR_HPP
+
+#include <array>
+#include <limits>
+#include <optional>
+#include <vector>
+#include <QObject>
+
+
+/*!
+	\class BGAlertEvaluator
+	\brief State machine that decides when BG alerts are raised and cleared.
+
+	\c BGDataReceiver uses this to evaluate its alerts. The evaluator
+	keeps track of which alerts are currently raised, and reports only
+	the transitions between the raised and cleared states. All BG
+	quantities passed to the evaluator are in mg/dL.
+
+	These alerts exist:
+
+	\list
+		\li LOW : Raised when the BG value falls below the low threshold.
+			Cleared when the BG value rises to or above the low threshold
+			plus the hysteresis.
+		\li HIGH : Raised when the BG value rises above the high threshold.
+			Cleared when the BG value falls to or below the high threshold
+			minus the hysteresis.
+		\li FAST_DROP : Raised when the BG value falls faster than the
+			fast drop rate. Cleared when it falls slower than two thirds
+			of that rate.
+		\li FAST_RISE : Like FAST_DROP, except for rising BG values.
+		\li STALE_DATA : Raised when the last valid BG reading is older than
+			the stale data timeout. Cleared when a newer valid reading arrives.
+	\endlist
+
+	Alerts can be snoozed. A snoozed alert is not raised until the snooze
+	ends, even if its condition is met. Snoozing a raised alert clears it.
+	Setting a threshold, rate or timeout to 0 disables the associated alert.
+*/
+class BGAlertEvaluator
+{
+	Q_GADGET
+
+public:
+	enum class Alert
+	{
+		LOW,
+		HIGH,
+		FAST_DROP,
+		FAST_RISE,
+		STALE_DATA
+	};
+	Q_ENUM(Alert)
+
+	static int const NUM_ALERTS = 5;
+
+	struct Settings
+	{
+		// Thresholds and hysteresis in mg/dL.
+		float m_lowThreshold = 70.0f;
+		float m_highThreshold = 180.0f;
+		float m_hysteresis = 10.0f;
+		// Rates in mg/dL per minute.
+		float m_fastDropRate = 3.0f;
+		float m_fastRiseRate = 3.0f;
+		// Timeout in minutes.
+		int m_staleDataTimeout = 20;
+	};
+
+	struct Input
+	{
+		bool m_hasBGValue = false;
+		float m_bgValue = 0.0f;
+		// Rate of change of the BG value in mg/dL per minute.
+		// NaN if the rate is not known.
+		float m_rate = std::numeric_limits<float>::quiet_NaN();
+		// Timestamp of the last valid BG reading, in seconds since the
+		// epoch. If no reading was received yet, this should be the time
+		// when waiting for readings started, so that missing data is
+		// considered stale once the timeout has passed since then.
+		std::optional<qint64> m_lastValidBGTimestamp;
+	};
+
+	struct Transition
+	{
+		Alert m_alert;
+		bool m_isRaised;
+	};
+
+	BGAlertEvaluator();
+
+	Settings const & settings() const;
+	void setSettings(Settings newSettings);
+
+	/*!
+		\fn BGAlertEvaluator::evaluate(Input const &input, qint64 now, std::vector<Transition> &transitions)
+
+		Evaluates all alerts based on the given input and the current time
+		(in seconds since the epoch). \c transitions is filled with the alerts
+		whose raised state changed. If no state changed, it is empty.
+	*/
+	void evaluate(Input const &input, qint64 now, std::vector<Transition> &transitions);
+
+	/*!
+		\fn BGAlertEvaluator::nextEvaluationTime(Input const &input, qint64 now) const
+
+		Returns the time (in seconds since the epoch) at which alert states
+		may change even if the input does not change. This is the case when
+		data becomes stale or when a snooze ends. If there is no such time,
+		this returns \c std::nullopt.
+	*/
+	std::optional<qint64> nextEvaluationTime(Input const &input, qint64 now) const;
+
+	/*!
+		\fn BGAlertEvaluator::snooze(Alert alert, qint64 snoozeEnd)
+
+		Snoozes the alert until \c snoozeEnd (in seconds since the epoch).
+		A snoozeEnd value that lies in the past ends any active snooze.
+		The new state takes effect with the next \c evaluate() call.
+	*/
+	void snooze(Alert alert, qint64 snoozeEnd);
+
+	bool isRaised(Alert alert) const;
+
+private:
+	bool evaluateCondition(Alert alert, Input const &input, qint64 now) const;
+
+	Settings m_settings;
+	std::array<bool, NUM_ALERTS> m_conditionsMet;
+	std::array<bool, NUM_ALERTS> m_raised;
+	std::array<qint64, NUM_ALERTS> m_snoozeEnds;
+};
+
+
+#endif // BGALERTEVALUATOR_HPP
@@ -0,0 +1,528 @@
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <QDebug>
+#include <QImage>
+#include <QLoggingCategory>
+#include <QQuickWindow>
+#include <QSGGeometry>
+#include <QSGGeometryNode>
+#include <QSGRendererInterface>
+#include <QSGSimpleTextureNode>
+#include "bgbasaltimeseriesview.hpp"
+#include "graphrasterizer.hpp"
+#include "scenegraphhelpers.hpp"
+#include "timeseriesmaterial.hpp"
+
+
+Q_DECLARE_LOGGING_CATEGORY(lcQmlBgData)
+
+
+namespace
+{
+
+
+// Opacity of the basal area, relative to the opacity of the view's color.
+float const BASAL_AREA_OPACITY = 0.5f;
+
+
+typedef std::vector<TimeSeriesMaterial::Vertex> StepVertices;
+
+
+// Calls the given function for each step of the series with the
+// start and end timestamp and the level of the step. The last step
+// ends at the current time, which has the normalized timestamp 1.
+template<typename Function>
+void forEachStep(std::vector<QPointF> const &points, Function const &function)
+{
+	for (std::size_t i = 0; i < points.size(); ++i)
+	{
+		double stepStart = points[i].x();
+		double stepEnd = ((i + 1) < points.size()) ? points[i + 1].x() : std::max(stepStart, 1.0);
+		function(stepStart, stepEnd, points[i].y());
+	}
+}
+
+
+void generateStepAreaVertices(std::vector<QPointF> const &points, StepVertices &stripVertices)
+{
+	// The area is one triangle strip. Each step contributes 4 vertices:
+	// the bottom and top at its start, and the bottom and top at its end.
+	// The triangles that connect one step to the next lie on the vertical
+	// line at the step boundary and have zero area.
+
+	stripVertices.clear();
+	stripVertices.reserve(points.size() * 4);
+
+	forEachStep(points, [&](double stepStart, double stepEnd, double level) {
+		stripVertices.push_back(TimeSeriesMaterial::Vertex::fromNormalizedPoint(QPointF(stepStart, 0.0)));
+		stripVertices.push_back(TimeSeriesMaterial::Vertex::fromNormalizedPoint(QPointF(stepStart, level)));
+		stripVertices.push_back(TimeSeriesMaterial::Vertex::fromNormalizedPoint(QPointF(stepEnd, 0.0)));
+		stripVertices.push_back(TimeSeriesMaterial::Vertex::fromNormalizedPoint(QPointF(stepEnd, level)));
+	});
+}
+
+
+void generateStepOutlineVertices(std::vector<QPointF> const &points, StepVertices &lineStripVertices)
+{
+	// The outline is one line strip. Each step contributes its
+	// start and end at its level. The vertical lines between
+	// the steps are formed by consecutive steps' vertices.
+
+	lineStripVertices.clear();
+	lineStripVertices.reserve(points.size() * 2);
+
+	forEachStep(points, [&](double stepStart, double stepEnd, double level) {
+		lineStripVertices.push_back(TimeSeriesMaterial::Vertex::fromNormalizedPoint(QPointF(stepStart, level)));
+		lineStripVertices.push_back(TimeSeriesMaterial::Vertex::fromNormalizedPoint(QPointF(stepEnd, level)));
+	});
+}
+
+
+// Maps a normalized point to item coordinates, the same
+// way TimeSeriesMaterial's vertex shader maps the vertices.
+QPointF toItemPoint(double x, double y, QSizeF const &itemSize)
+{
+	return QPointF(x * itemSize.width(), (1.0 - y) * itemSize.height());
+}
+
+
+void rasterizeStepArea(std::vector<QPointF> const &points, QSizeF const &itemSize, QColor const &color, float scale, QImage &image)
+{
+	// Same strip as in generateStepAreaVertices(), in item coordinates.
+	// The zero-area triangles between the steps are skipped by the
+	// rasterizer, so the step boundaries are not drawn twice.
+
+	// The rasterizer expects vertex colors to be premultiplied.
+	float alpha = color.alphaF();
+	uchar r = uchar(color.redF() * alpha * 255.0f);
+	uchar g = uchar(color.greenF() * alpha * 255.0f);
+	uchar b = uchar(color.blueF() * alpha * 255.0f);
+	uchar a = uchar(alpha * 255.0f);
+
+	std::vector<QSGGeometry::ColoredPoint2D> stripVertices;
+	stripVertices.reserve(points.size() * 4);
+
+	auto addVertex = [&](double x, double y) {
+		QPointF itemPoint = toItemPoint(x, y, itemSize);
+		QSGGeometry::ColoredPoint2D vertex;
+		vertex.set(itemPoint.x(), itemPoint.y(), r, g, b, a);
+		stripVertices.push_back(vertex);
+	};
+
+	forEachStep(points, [&](double stepStart, double stepEnd, double level) {
+		addVertex(stepStart, 0.0);
+		addVertex(stepStart, level);
+		addVertex(stepEnd, 0.0);
+		addVertex(stepEnd, level);
+	});
+
+	rasterizeTriangleStrip(stripVertices.data(), stripVertices.size(), scale, image);
+}
+
+
+void rasterizeStepOutline(std::vector<QPointF> const &points, QSizeF const &itemSize, QColor const &color, float scale, QImage &image)
+{
+	// Same line strip as in generateStepOutlineVertices(), in item coordinates.
+
+	std::vector<QPointF> linePoints;
+	linePoints.reserve(points.size() * 2);
+
+	forEachStep(points, [&](double stepStart, double stepEnd, double level) {
+		linePoints.push_back(toItemPoint(stepStart, level, itemSize));
+		linePoints.push_back(toItemPoint(stepEnd, level, itemSize));
+	});
+
+	rasterizeHairlinePolyline(linePoints.data(), linePoints.size(), color, scale, image);
+}
+
+
+} // unnamed namespace end
+
+
+// Everything the render thread needs to update the QSG nodes.
+// See BGTimeSeriesRenderData for how instances are shared.
+struct BGBasalTimeSeriesRenderData
+{
+	using Vertices = std::shared_ptr<StepVertices const>;
+
+	QColor m_color;
+	QSizeF m_itemSize;
+	Vertices m_basalAreaVertices;
+	Vertices m_baseBasalOutlineVertices;
+	// If set, the steps were rasterized into this image, which is then
+	// drawn instead of the vertices above. This is only done with the
+	// software backend, which cannot draw TimeSeriesMaterial geometry.
+	std::shared_ptr<QImage const> m_cachedImage;
+};
+
+
+namespace
+{
+
+
+// Root node of the view. The basal area is drawn first,
+// so the base basal outline is drawn on top of it.
+class BGBasalTimeSeriesNode
+	: public QSGNode
+{
+public:
+	BGBasalTimeSeriesNode()
+	{
+		m_basalAreaNode = createGeometryNode(new TimeSeriesMaterial, TimeSeriesMaterial::attributes(), QSGGeometry::DrawTriangleStrip, 1.0f);
+		appendChildNode(m_basalAreaNode);
+
+		m_baseBasalOutlineNode = createGeometryNode(new TimeSeriesMaterial, TimeSeriesMaterial::attributes(), QSGGeometry::DrawLineStrip, 1.0f);
+		appendChildNode(m_baseBasalOutlineNode);
+	}
+
+	void setRenderData(std::shared_ptr<BGBasalTimeSeriesRenderData const> renderData)
+	{
+		BGBasalTimeSeriesRenderData const *previous = m_renderData.get();
+
+		TimeSeriesMaterial *areaMaterial = static_cast<TimeSeriesMaterial *>(m_basalAreaNode->material());
+		TimeSeriesMaterial *outlineMaterial = static_cast<TimeSeriesMaterial *>(m_baseBasalOutlineNode->material());
+
+		if ((previous == nullptr) || (previous->m_color != renderData->m_color))
+		{
+			QColor areaColor = renderData->m_color;
+			areaColor.setAlphaF(areaColor.alphaF() * BASAL_AREA_OPACITY);
+
+			areaMaterial->setColor(areaColor);
+			outlineMaterial->setColor(renderData->m_color);
+			m_basalAreaNode->markDirty(QSGNode::DirtyMaterial);
+			m_baseBasalOutlineNode->markDirty(QSGNode::DirtyMaterial);
+		}
+
+		// The vertices are raw int16 values, so resizing
+		// the item only changes the materials' uniforms.
+		if ((previous == nullptr) || (previous->m_itemSize != renderData->m_itemSize))
+		{
+			areaMaterial->setItemSize(renderData->m_itemSize);
+			outlineMaterial->setItemSize(renderData->m_itemSize);
+			m_basalAreaNode->markDirty(QSGNode::DirtyMaterial);
+			m_baseBasalOutlineNode->markDirty(QSGNode::DirtyMaterial);
+		}
+
+		if ((previous == nullptr) || (previous->m_basalAreaVertices != renderData->m_basalAreaVertices))
+			uploadVertices(*(renderData->m_basalAreaVertices), m_basalAreaNode);
+
+		if ((previous == nullptr) || (previous->m_baseBasalOutlineVertices != renderData->m_baseBasalOutlineVertices))
+			uploadVertices(*(renderData->m_baseBasalOutlineVertices), m_baseBasalOutlineNode);
+
+		m_renderData = std::move(renderData);
+	}
+
+private:
+	QSGGeometryNode *m_basalAreaNode;
+	QSGGeometryNode *m_baseBasalOutlineNode;
+
+	std::shared_ptr<BGBasalTimeSeriesRenderData const> m_renderData;
+};
+
+
+// Root node of the view when the steps are drawn from a cached image.
+// See BGTimeSeriesTextureNode.
+class BGBasalTimeSeriesTextureNode
+	: public QSGSimpleTextureNode
+{
+public:
+	BGBasalTimeSeriesTextureNode()
+	{
+		setOwnsTexture(true);
+	}
+
+	void setRenderData(std::shared_ptr<BGBasalTimeSeriesRenderData const> renderData, QQuickWindow *window)
+	{
+		if ((m_renderData == nullptr) || (m_renderData->m_cachedImage != renderData->m_cachedImage))
+		{
+			QImage const &image = *(renderData->m_cachedImage);
+			setTexture(window->createTextureFromImage(image, QQuickWindow::TextureHasAlphaChannel));
+			setRect(0, 0, image.width() / image.devicePixelRatio(), image.height() / image.devicePixelRatio());
+		}
+
+		m_renderData = std::move(renderData);
+	}
+
+private:
+	std::shared_ptr<BGBasalTimeSeriesRenderData const> m_renderData;
+};
+
+
+} // unnamed namespace end
+
+
+BGBasalTimeSeriesView::BGBasalTimeSeriesView(QQuickItem *parent)
+	: QQuickItem(parent)
+	, m_color(Qt::black)
+	, m_numSimplificationColumns(0)
+{
+	setFlag(QQuickItem::ItemHasContents, true);
+
+	auto renderData = std::make_shared<BGBasalTimeSeriesRenderData>();
+	renderData->m_color = m_color;
+	renderData->m_basalAreaVertices = std::make_shared<StepVertices>();
+	renderData->m_baseBasalOutlineVertices = std::make_shared<StepVertices>();
+	m_renderData = std::move(renderData);
+
+	// The number of simplification columns depends on the width. The
+	// item size in general only affects the uniforms of the materials.
+	connect(this, &QQuickItem::widthChanged, [this](){ polish(); });
+	connect(this, &QQuickItem::heightChanged, [this](){ polish(); });
+	// The new window may use a different scene graph backend.
+	connect(this, &QQuickItem::windowChanged, [this](){ polish(); });
+}
+
+
+BGBasalTimeSeriesView::~BGBasalTimeSeriesView()
+{
+}
+
+
+QColor const & BGBasalTimeSeriesView::color() const
+{
+	return m_color;
+}
+
+
+void BGBasalTimeSeriesView::setColor(QColor newColor)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new basal color " << newColor;
+
+	m_color = std::move(newColor);
+
+	polish();
+}
+
+
+QVariantList const & BGBasalTimeSeriesView::basalTimeSeries() const
+{
+	return m_basal.m_timeSeries;
+}
+
+
+void BGBasalTimeSeriesView::setBasalTimeSeries(QVariantList newBasalTimeSeries)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Got new basal time series with " << newBasalTimeSeries.size()
+		<< " item(s); will recreate basal area vertices";
+
+	setStepSeries(m_basal, std::move(newBasalTimeSeries));
+}
+
+
+QVariantList const & BGBasalTimeSeriesView::baseBasalTimeSeries() const
+{
+	return m_baseBasal.m_timeSeries;
+}
+
+
+void BGBasalTimeSeriesView::setBaseBasalTimeSeries(QVariantList newBaseBasalTimeSeries)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Got new base basal time series with " << newBaseBasalTimeSeries.size()
+		<< " item(s); will recreate base basal outline vertices";
+
+	setStepSeries(m_baseBasal, std::move(newBaseBasalTimeSeries));
+}
+
+
+QPolygonF const & BGBasalTimeSeriesView::basalTimeSeriesPoints() const
+{
+	return m_basal.m_packedTimeSeries;
+}
+
+
+void BGBasalTimeSeriesView::setBasalTimeSeriesPoints(QPolygonF newBasalTimeSeriesPoints)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Got new packed basal time series with " << newBasalTimeSeriesPoints.size()
+		<< " point(s); will recreate basal area vertices";
+
+	setStepSeries(m_basal, std::move(newBasalTimeSeriesPoints));
+}
+
+
+QPolygonF const & BGBasalTimeSeriesView::baseBasalTimeSeriesPoints() const
+{
+	return m_baseBasal.m_packedTimeSeries;
+}
+
+
+void BGBasalTimeSeriesView::setBaseBasalTimeSeriesPoints(QPolygonF newBaseBasalTimeSeriesPoints)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Got new packed base basal time series with " << newBaseBasalTimeSeriesPoints.size()
+		<< " point(s); will recreate base basal outline vertices";
+
+	setStepSeries(m_baseBasal, std::move(newBaseBasalTimeSeriesPoints));
+}
+
+
+void BGBasalTimeSeriesView::setStepSeries(StepSeries &stepSeries, QVariantList newTimeSeries)
+{
+	stepSeries.m_timeSeries = std::move(newTimeSeries);
+	stepSeries.m_packedTimeSeries = QPolygonF();
+
+	stepSeries.m_points.resize(stepSeries.m_timeSeries.size());
+	for (int i = 0; i < stepSeries.m_timeSeries.size(); ++i)
+		stepSeries.m_points[i] = stepSeries.m_timeSeries[i].toPointF();
+
+	stepSeries.m_mustSimplify = true;
+
+	polish();
+}
+
+
+void BGBasalTimeSeriesView::setStepSeries(StepSeries &stepSeries, QPolygonF newPackedTimeSeries)
+{
+	stepSeries.m_packedTimeSeries = std::move(newPackedTimeSeries);
+	stepSeries.m_timeSeries = QVariantList();
+
+	stepSeries.m_points.assign(stepSeries.m_packedTimeSeries.begin(), stepSeries.m_packedTimeSeries.end());
+
+	stepSeries.m_mustSimplify = true;
+
+	polish();
+}
+
+
+bool BGBasalTimeSeriesView::simplifyStepSeries(StepSeries &stepSeries, int numColumns)
+{
+	int numPoints = stepSeries.m_points.size();
+
+	// Steps only have to be simplified again if the series changed, or if
+	// it has more points than there were or are columns. Otherwise, the
+	// series was, and still is, used as it is.
+	bool columnsChanged = (numColumns != m_numSimplificationColumns);
+	if (!stepSeries.m_mustSimplify && !(columnsChanged && (numPoints > std::min(numColumns, m_numSimplificationColumns))))
+		return false;
+
+	// Min-max downsampling keeps the lowest and highest level in each
+	// column. This way, short TBRs (such as zero temps) stay visible
+	// even if they are narrower than a pixel.
+	if (numPoints > numColumns)
+		m_simplifier.simplifyMinMax(stepSeries.m_points.data(), numPoints, 1.0 / numColumns, stepSeries.m_simplifiedPoints);
+	else
+		stepSeries.m_simplifiedPoints.assign(stepSeries.m_points.begin(), stepSeries.m_points.end());
+
+	stepSeries.m_mustSimplify = false;
+
+	return true;
+}
+
+
+bool BGBasalTimeSeriesView::isSoftwareRendererUsed() const
+{
+	return (window() != nullptr) && (window()->rendererInterface()->graphicsApi() == QSGRendererInterface::Software);
+}
+
+
+void BGBasalTimeSeriesView::updatePolish()
+{
+	std::shared_ptr<BGBasalTimeSeriesRenderData const> previousRenderData = std::atomic_load(&m_renderData);
+	auto renderData = std::make_shared<BGBasalTimeSeriesRenderData>(*previousRenderData);
+	renderData->m_color = m_color;
+
+	qreal currentWidth = width();
+	qreal currentHeight = height();
+	renderData->m_itemSize = QSizeF(currentWidth, currentHeight);
+
+	if (currentWidth > 0)
+	{
+		// A partially covered column is still a column.
+		int numColumns = std::ceil(currentWidth);
+
+		if (simplifyStepSeries(m_basal, numColumns))
+		{
+			auto basalAreaVertices = std::make_shared<StepVertices>();
+			generateStepAreaVertices(m_basal.m_simplifiedPoints, *basalAreaVertices);
+			renderData->m_basalAreaVertices = std::move(basalAreaVertices);
+		}
+
+		if (simplifyStepSeries(m_baseBasal, numColumns))
+		{
+			auto baseBasalOutlineVertices = std::make_shared<StepVertices>();
+			generateStepOutlineVertices(m_baseBasal.m_simplifiedPoints, *baseBasalOutlineVertices);
+			renderData->m_baseBasalOutlineVertices = std::move(baseBasalOutlineVertices);
+		}
+
+		m_numSimplificationColumns = numColumns;
+	}
+
+	if (!isSoftwareRendererUsed())
+	{
+		renderData->m_cachedImage = nullptr;
+	}
+	else if ((currentWidth > 0) && (currentHeight > 0))
+	{
+		// Only rasterize the steps again if anything that is drawn changed.
+		qreal devicePixelRatio = window()->effectiveDevicePixelRatio();
+		QSize imageSize(std::ceil(currentWidth * devicePixelRatio), std::ceil(currentHeight * devicePixelRatio));
+
+		bool mustRasterize = (renderData->m_cachedImage == nullptr)
+		                  || (renderData->m_cachedImage->size() != imageSize)
+		                  || (renderData->m_color != previousRenderData->m_color)
+		                  || (renderData->m_basalAreaVertices != previousRenderData->m_basalAreaVertices)
+		                  || (renderData->m_baseBasalOutlineVertices != previousRenderData->m_baseBasalOutlineVertices);
+
+		if (mustRasterize)
+		{
+			qCDebug(lcQmlBgData).nospace().noquote()
+				<< "Rasterizing basal steps into " << imageSize.width() << "x" << imageSize.height() << " image";
+
+			auto image = std::make_shared<QImage>(imageSize, QImage::Format_ARGB32_Premultiplied);
+			image->setDevicePixelRatio(devicePixelRatio);
+			image->fill(Qt::transparent);
+
+			// Same order as the nodes in BGBasalTimeSeriesNode.
+			QColor areaColor = m_color;
+			areaColor.setAlphaF(areaColor.alphaF() * BASAL_AREA_OPACITY);
+			rasterizeStepArea(m_basal.m_simplifiedPoints, renderData->m_itemSize, areaColor, devicePixelRatio, *image);
+			rasterizeStepOutline(m_baseBasal.m_simplifiedPoints, renderData->m_itemSize, m_color, devicePixelRatio, *image);
+
+			renderData->m_cachedImage = std::move(image);
+		}
+	}
+
+	std::atomic_store(&m_renderData, std::shared_ptr<BGBasalTimeSeriesRenderData const>(std::move(renderData)));
+
+	// Schedule a call to updatePaintNode() to pick up the new render data.
+	update();
+}
+
+
+QSGNode* BGBasalTimeSeriesView::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+{
+	std::shared_ptr<BGBasalTimeSeriesRenderData const> renderData = std::atomic_load(&m_renderData);
+
+	// Like in BGTimeSeriesView, the root node type depends on whether the
+	// steps are drawn from the vertices or from the cached image.
+	if (renderData->m_cachedImage != nullptr)
+	{
+		BGBasalTimeSeriesTextureNode *textureNode = dynamic_cast<BGBasalTimeSeriesTextureNode *>(oldNode);
+		if (textureNode == nullptr)
+		{
+			qCDebug(lcQmlBgData) << "Creating new QSG basal time series texture node";
+			delete oldNode;
+			textureNode = new BGBasalTimeSeriesTextureNode();
+		}
+
+		textureNode->setRenderData(std::move(renderData), window());
+		return textureNode;
+	}
+	else
+	{
+		BGBasalTimeSeriesNode *geometryNode = dynamic_cast<BGBasalTimeSeriesNode *>(oldNode);
+		if (geometryNode == nullptr)
+		{
+			qCDebug(lcQmlBgData) << "Creating new QSG basal time series node";
+			delete oldNode;
+			geometryNode = new BGBasalTimeSeriesNode();
+		}
+
+		geometryNode->setRenderData(std::move(renderData));
+		return geometryNode;
+	}
+}
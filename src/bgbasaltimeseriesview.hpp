@@ -0,0 +1,155 @@
+#ifndef BGBASALTIMESERIESVIEW_HPP
+#define BGBASALTIMESERIESVIEW_HPP
+
+#include <memory>
+#include <vector>
+#include <QPolygonF>
+#include <QQuickItem>
+#include <QVariant>
+#include "timeseriessimplifier.hpp"
+
+
+struct BGBasalTimeSeriesRenderData;
+
+
+/*!
+	\class BGBasalTimeSeriesView
+	\brief Graphical Quick item for drawing basal time series data coming from \c BGDataReceiver.
+
+	Basal time series are step data: each point sets the basal level at its
+	timestamp, and that level holds until the timestamp of the next point.
+	The level of the last point holds until the current time, which is the
+	right edge of the item.
+
+	The actual basal rate (\c basalTimeSeries), which includes TBRs, is drawn
+	as a filled area. The base basal rate (\c baseBasalTimeSeries), which is
+	the basal profile programmed in the pump, is drawn as an outline on top
+	of it. This way, TBRs show up as the difference between the area and
+	the outline.
+
+	To use, assign the values of \c {BGDataReceiver.basalTimeSeriesPoints} and
+	\c {BGDataReceiver.baseBasalTimeSeriesPoints} to this item's properties
+	every time new data becomes available:
+
+	\qml
+		BGDataReceiver {
+			onNewDataReceived: {
+				basalTimeSeriesView.basalTimeSeriesPoints = basalTimeSeriesPoints;
+				basalTimeSeriesView.baseBasalTimeSeriesPoints = baseBasalTimeSeriesPoints;
+			}
+		}
+
+		BGBasalTimeSeriesView {
+			id: basalTimeSeriesView
+		}
+	\endqml
+
+	Like the graph in \c BGTimeSeriesView, the steps are simplified (with
+	min-max downsampling) if there are more of them than the item is wide.
+
+	The software backend of Qt Quick cannot draw the custom geometry that
+	is used for the steps. With that backend, the steps are rasterized on
+	the CPU into an image instead, which is drawn as a texture. This is
+	done again every time the steps, the color, or the size change.
+
+	The item does not render any background.
+*/
+class BGBasalTimeSeriesView
+	: public QQuickItem
+{
+	Q_OBJECT
+
+	/*!
+		\property BGBasalTimeSeriesView::color
+		\brief Color of the base basal outline.
+
+		The basal area is filled with this color at reduced opacity.
+		The default color is black. The alpha channel is supported.
+	*/
+	Q_PROPERTY(QColor color READ color WRITE setColor)
+
+	/*!
+		\property BGBasalTimeSeriesView::basalTimeSeries
+		\brief The basal time series (including TBRs) to render as a filled area.
+	*/
+	Q_PROPERTY(QVariantList basalTimeSeries READ basalTimeSeries WRITE setBasalTimeSeries)
+
+	/*!
+		\property BGBasalTimeSeriesView::baseBasalTimeSeries
+		\brief The base basal time series to render as an outline.
+	*/
+	Q_PROPERTY(QVariantList baseBasalTimeSeries READ baseBasalTimeSeries WRITE setBaseBasalTimeSeries)
+
+	/*!
+		\property BGBasalTimeSeriesView::basalTimeSeriesPoints
+		\brief \c basalTimeSeries as an array of points.
+
+		Like \c {BGTimeSeriesView.bgTimeSeriesPoints}, this avoids converting
+		individual points. Setting this clears \c basalTimeSeries and vice versa.
+	*/
+	Q_PROPERTY(QPolygonF basalTimeSeriesPoints READ basalTimeSeriesPoints WRITE setBasalTimeSeriesPoints)
+
+	/*!
+		\property BGBasalTimeSeriesView::baseBasalTimeSeriesPoints
+		\brief \c baseBasalTimeSeries as an array of points.
+
+		Setting this clears \c baseBasalTimeSeries and vice versa.
+	*/
+	Q_PROPERTY(QPolygonF baseBasalTimeSeriesPoints READ baseBasalTimeSeriesPoints WRITE setBaseBasalTimeSeriesPoints)
+
+public:
+	explicit BGBasalTimeSeriesView(QQuickItem *parent = nullptr);
+	~BGBasalTimeSeriesView() override;
+
+	QColor const & color() const;
+	void setColor(QColor newColor);
+
+	QVariantList const & basalTimeSeries() const;
+	void setBasalTimeSeries(QVariantList newBasalTimeSeries);
+
+	QVariantList const & baseBasalTimeSeries() const;
+	void setBaseBasalTimeSeries(QVariantList newBaseBasalTimeSeries);
+
+	QPolygonF const & basalTimeSeriesPoints() const;
+	void setBasalTimeSeriesPoints(QPolygonF newBasalTimeSeriesPoints);
+
+	QPolygonF const & baseBasalTimeSeriesPoints() const;
+	void setBaseBasalTimeSeriesPoints(QPolygonF newBaseBasalTimeSeriesPoints);
+
+protected:
+	void updatePolish() override;
+	QSGNode* updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *updatePaintNodeData);
+
+private:
+	// State of one of the two step series.
+	struct StepSeries
+	{
+		QVariantList m_timeSeries;
+		QPolygonF m_packedTimeSeries;
+		std::vector<QPointF> m_points;
+		std::vector<QPointF> m_simplifiedPoints;
+		// Set when the series changes.
+		bool m_mustSimplify = false;
+	};
+
+	void setStepSeries(StepSeries &stepSeries, QVariantList newTimeSeries);
+	void setStepSeries(StepSeries &stepSeries, QPolygonF newPackedTimeSeries);
+	bool simplifyStepSeries(StepSeries &stepSeries, int numColumns);
+	bool isSoftwareRendererUsed() const;
+
+	// These states are only accessed by the GUI thread. This includes
+	// updatePolish(), which is where the vertices are generated.
+	QColor m_color;
+	StepSeries m_basal;
+	StepSeries m_baseBasal;
+	TimeSeriesSimplifier m_simplifier;
+	int m_numSimplificationColumns;
+
+	// Immutable snapshot of the generated vertices and the material
+	// states, handed over to the render thread the same way as in
+	// BGTimeSeriesView.
+	std::shared_ptr<BGBasalTimeSeriesRenderData const> m_renderData;
+};
+
+
+#endif // BGBASALTIMESERIESVIEW_HPP
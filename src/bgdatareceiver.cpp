@@ -1,11 +1,18 @@
 #include <QDebug>
 #include <QDBusConnection>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QLoggingCategory>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <random>
+#include <vector>
 
 #include "bgdatareceiver.hpp"
+#include "simdkernels.hpp"
 #include "extappmsgreceiverifaceadaptor.h"
 
 
@@ -27,12 +34,104 @@ unsigned int const FLAG_BG_STATUS_PRESENT               = (1u << 2);
 unsigned int const FLAG_LAST_LOOP_RUN_TIMESTAMP_PRESENT = (1u << 3);
 unsigned int const FLAG_MUST_CLEAR_ALL_DATA             = (1u << 4);
 
+// Typical interval between CGM readings, in minutes.
+int const CGM_READING_INTERVAL = 5;
+
+float const MG_DL_PER_MMOL_L = 18.0182f;
+
+// Forecast parameters, in minutes. The weight time constant determines
+// how quickly older BG values lose influence on the fitted trend.
+// The damping time constant limits how far that trend is continued.
+// If two BG values are further apart than the max gap, the older
+// values are not used for the trend.
+double const FORECAST_WEIGHT_TIME_CONSTANT = 15.0;
+double const FORECAST_TREND_DAMPING_TIME_CONSTANT = 20.0;
+double const FORECAST_MAX_GAP = 20.0;
+int const MIN_FORECAST_HORIZON = 5;
+int const MAX_FORECAST_HORIZON = 60;
+int const DEFAULT_FORECAST_HORIZON = 30;
+
+// How many of the most recent bgTimeSeries points to use
+// for computing the bgForecastTimeSeries.
+int const NUM_FORECAST_TIME_SERIES_TAIL_POINTS = 7;
+
+QString const PERCENTILE_BANDS_FILENAME = "bg-percentile-bands.bin";
+
+// The percentile bands statistics are not saved after every single
+// reading to limit flash wear. With the usual CGM reading interval,
+// this saves them about once per hour (and when the receiver is
+// destroyed).
+int const PERCENTILE_BANDS_SAVE_INTERVAL = 12;
+
+// Longest interval of the alert timer, in seconds.
+qint64 const MAX_ALERT_TIMER_INTERVAL = 24 * 60 * 60;
+
+std::vector<float> const PERCENTILES = { 0.05f, 0.25f, 0.5f, 0.75f, 0.95f };
+
 template<typename T>
 QVariant toQVariant(std::optional<T> const &optValue)
 {
 	return optValue.has_value() ? QVariant::fromValue(*optValue) : QVariant();
 }
 
+// The delta is expected to be given in mg/dL per 5 minutes.
+BGStatus::TrendArrow trendArrowFromDelta(float delta)
+{
+	if (std::isnan(delta))
+		return BGStatus::TrendArrow::NONE;
+	else if (delta < -25)
+		return BGStatus::TrendArrow::TRIPLE_DOWN;
+	else if (delta < -18)
+		return BGStatus::TrendArrow::DOUBLE_DOWN;
+	else if (delta < -10)
+		return BGStatus::TrendArrow::SINGLE_DOWN;
+	else if (delta < -5)
+		return BGStatus::TrendArrow::FORTY_FIVE_DOWN;
+	else if (delta > +25)
+		return BGStatus::TrendArrow::TRIPLE_UP;
+	else if (delta > +18)
+		return BGStatus::TrendArrow::DOUBLE_UP;
+	else if (delta > +10)
+		return BGStatus::TrendArrow::SINGLE_UP;
+	else if (delta > +5)
+		return BGStatus::TrendArrow::FORTY_FIVE_UP;
+	else
+		return BGStatus::TrendArrow::FLAT;
+}
+
+QVariantList toPercentileBandsVariantList(BGPercentileBands const &percentileBandsStatistics)
+{
+	if (percentileBandsStatistics.isEmpty())
+		return QVariantList();
+
+	std::vector<std::array<float, BGPercentileBands::NUM_TIME_BINS>> percentileValues;
+	percentileBandsStatistics.computePercentiles(PERCENTILES, percentileValues);
+
+	float const valueRange = BGPercentileBands::MAX_VALUE - BGPercentileBands::MIN_VALUE;
+
+	QVariantList percentileBands;
+
+	for (auto const &values : percentileValues)
+	{
+		QVariantList band;
+
+		for (int timeBin = 0; timeBin < BGPercentileBands::NUM_TIME_BINS; ++timeBin)
+		{
+			if (std::isnan(values[timeBin]))
+				continue;
+
+			band.append(QPointF(
+				(timeBin + 0.5) / BGPercentileBands::NUM_TIME_BINS,
+				(values[timeBin] - BGPercentileBands::MIN_VALUE) / valueRange
+			));
+		}
+
+		percentileBands.append(QVariant(band));
+	}
+
+	return percentileBands;
+}
+
 // NOTE: These bytes -> numeric converters assume
 // that the values are stored in little-endian order.
 
@@ -63,25 +162,43 @@ qint16 int16From(QByteArray const &bytes, int &offset)
 	if (int(offset + sizeof(qint16)) > bytes.size())
 		throw std::out_of_range(QString("attempted to read int16 at offset %1").arg(offset).toStdString());
 
-	auto ret = (qint16(bytes[offset + 0]) << 0)
-	         | (qint16(bytes[offset + 1]) << 8);
+	auto ret = qint16((quint16(quint8(bytes[offset + 0])) << 0)
+	                | (quint16(quint8(bytes[offset + 1])) << 8));
 	offset += sizeof(qint16);
 	return ret;
 }
 
+QPolygonF timeSeriesFrom(QByteArray const &bytes, int &offset, int numDataPoints)
+{
+	// Each data point is made of 2 int16 values: the timestamp and the value.
+	int const dataPointSize = 2 * sizeof(qint16);
+
+	numDataPoints = std::max(numDataPoints, 0);
+	if ((offset + numDataPoints * dataPointSize) > bytes.size())
+		throw std::out_of_range(QString("attempted to read time series with %1 point(s) at offset %2").arg(numDataPoints).arg(offset).toStdString());
+
+	// The points are unpacked right into the array that is handed over to
+	// QML, so there is only one allocation per series, not one per point.
+	QPolygonF points(numDataPoints);
+	unpackNormalizedInt16Pairs(bytes.constData() + offset, numDataPoints, points.data());
+	offset += numDataPoints * dataPointSize;
+
+	return points;
+}
+
 qint64 int64From(QByteArray const &bytes, int &offset)
 {
 	if (int(offset + sizeof(qint64)) > bytes.size())
 		throw std::out_of_range(QString("attempted to read int64 at offset %1").arg(offset).toStdString());
 
-	auto ret = (qint64(bytes[offset + 0]) << 0)
-	         | (qint64(bytes[offset + 1]) << 8)
-	         | (qint64(bytes[offset + 2]) << 16)
-	         | (qint64(bytes[offset + 3]) << 24)
-	         | (qint64(bytes[offset + 4]) << 32)
-	         | (qint64(bytes[offset + 5]) << 40)
-	         | (qint64(bytes[offset + 6]) << 48)
-	         | (qint64(bytes[offset + 7]) << 56);
+	auto ret = qint64((quint64(quint8(bytes[offset + 0])) << 0)
+	                | (quint64(quint8(bytes[offset + 1])) << 8)
+	                | (quint64(quint8(bytes[offset + 2])) << 16)
+	                | (quint64(quint8(bytes[offset + 3])) << 24)
+	                | (quint64(quint8(bytes[offset + 4])) << 32)
+	                | (quint64(quint8(bytes[offset + 5])) << 40)
+	                | (quint64(quint8(bytes[offset + 6])) << 48)
+	                | (quint64(quint8(bytes[offset + 7])) << 56));
 	offset += sizeof(qint64);
 	return ret;
 }
@@ -91,7 +208,26 @@ qint64 int64From(QByteArray const &bytes, int &offset)
 
 BGDataReceiver::BGDataReceiver(QObject *parent)
 	: QObject(parent)
+	, m_bgForecaster(FORECAST_WEIGHT_TIME_CONSTANT, FORECAST_TREND_DAMPING_TIME_CONSTANT, FORECAST_MAX_GAP)
+	, m_forecastHorizon(DEFAULT_FORECAST_HORIZON)
+	, m_numUnsavedPercentileBandsReadings(0)
+	, m_lastValidBGTimestamp(QDateTime::currentSecsSinceEpoch())
 {
+	// This timer is only used for events that happen without new
+	// data arriving, like data becoming stale. Minute accuracy
+	// is sufficient for these, so use a very coarse timer.
+	m_alertTimer.setSingleShot(true);
+	m_alertTimer.setTimerType(Qt::VeryCoarseTimer);
+	connect(&m_alertTimer, &QTimer::timeout, this, &BGDataReceiver::evaluateAlerts);
+
+	// This timer is scheduled to fire exactly when the next minute
+	// boundary is reached. A precise timer is used, since a coarse
+	// one might fire a little early, before the minute count changed,
+	// which would cause an extra wakeup.
+	m_minutesSinceTimer.setSingleShot(true);
+	m_minutesSinceTimer.setTimerType(Qt::PreciseTimer);
+	connect(&m_minutesSinceTimer, &QTimer::timeout, this, &BGDataReceiver::updateMinutesSince);
+
 	// The adaptor is automatically destroyed by the QObject destructor.
 	// For more, see: https://doc.qt.io/qt-5/objecttrees.html
 	new ReceiverAdaptor(this);
@@ -113,30 +249,42 @@ BGDataReceiver::BGDataReceiver(QObject *parent)
 	}
 
 	clearAllQuantities();
+
+	loadPercentileBands();
+
+	// Schedule the STALE_DATA alert for the case that no data arrives.
+	evaluateAlerts();
 }
 
 
-QVariant BGDataReceiver::unit() const
+BGDataReceiver::~BGDataReceiver()
 {
-	return toQVariant(m_unit);
+	if (m_numUnsavedPercentileBandsReadings > 0)
+		savePercentileBands();
 }
 
 
-QVariant BGDataReceiver::bgStatus() const
+QVariant const & BGDataReceiver::unit() const
 {
-	return toQVariant(m_bgStatus);
+	return m_unitVariant;
 }
 
 
-QVariant BGDataReceiver::insulinOnBoard() const
+QVariant const & BGDataReceiver::bgStatus() const
 {
-	return toQVariant(m_iob);
+	return m_bgStatusVariant;
 }
 
 
-QVariant BGDataReceiver::carbsOnBoard() const
+QVariant const & BGDataReceiver::insulinOnBoard() const
 {
-	return toQVariant(m_cob);
+	return m_iobVariant;
+}
+
+
+QVariant const & BGDataReceiver::carbsOnBoard() const
+{
+	return m_cobVariant;
 }
 
 
@@ -146,27 +294,229 @@ QDateTime const & BGDataReceiver::lastLoopRunTimestamp() const
 }
 
 
-QVariant BGDataReceiver::basalRate() const
+QVariant const & BGDataReceiver::basalRate() const
+{
+	return m_basalRateVariant;
+}
+
+
+void BGDataReceiver::TimeSeries::setPoints(QPolygonF points)
+{
+	m_points = std::move(points);
+	m_variantList = QVariantList();
+	m_variantListIsStale = !m_points.isEmpty();
+}
+
+
+QVariantList const & BGDataReceiver::TimeSeries::variantList() const
 {
-	return toQVariant(m_basalRate);
+	if (m_variantListIsStale)
+	{
+		m_variantList.reserve(m_points.size());
+		for (QPointF const &point : m_points)
+			m_variantList.append(point);
+		m_variantListIsStale = false;
+	}
+
+	return m_variantList;
 }
 
 
 QVariantList const & BGDataReceiver::bgTimeSeries() const
 {
-	return m_bgTimeSeries;
+	return m_bgTimeSeries.variantList();
 }
 
 
 QVariantList const & BGDataReceiver::basalTimeSeries() const
 {
-	return m_basalTimeSeries;
+	return m_basalTimeSeries.variantList();
 }
 
 
 QVariantList const & BGDataReceiver::baseBasalTimeSeries() const
 {
-	return m_baseBasalTimeSeries;
+	return m_baseBasalTimeSeries.variantList();
+}
+
+
+QPolygonF const & BGDataReceiver::bgTimeSeriesPoints() const
+{
+	return m_bgTimeSeries.m_points;
+}
+
+
+QPolygonF const & BGDataReceiver::basalTimeSeriesPoints() const
+{
+	return m_basalTimeSeries.m_points;
+}
+
+
+QPolygonF const & BGDataReceiver::baseBasalTimeSeriesPoints() const
+{
+	return m_baseBasalTimeSeries.m_points;
+}
+
+
+int BGDataReceiver::forecastHorizon() const
+{
+	return m_forecastHorizon;
+}
+
+
+void BGDataReceiver::setForecastHorizon(int newForecastHorizon)
+{
+	newForecastHorizon = std::clamp(newForecastHorizon, MIN_FORECAST_HORIZON, MAX_FORECAST_HORIZON);
+	if (newForecastHorizon == m_forecastHorizon)
+		return;
+
+	qCDebug(lcQmlBgData) << "Using new forecast horizon" << newForecastHorizon;
+
+	m_forecastHorizon = newForecastHorizon;
+	emit forecastHorizonChanged();
+
+	updateForecasts();
+}
+
+
+QVariantList const & BGDataReceiver::bgForecast() const
+{
+	return m_bgForecast;
+}
+
+
+QVariantList const & BGDataReceiver::bgForecastTimeSeries() const
+{
+	return m_bgForecastTimeSeries;
+}
+
+
+QVariantList const & BGDataReceiver::percentileBands() const
+{
+	return m_percentileBands;
+}
+
+
+float BGDataReceiver::lowAlertThreshold() const
+{
+	return m_alertEvaluator.settings().m_lowThreshold;
+}
+
+
+void BGDataReceiver::setLowAlertThreshold(float newLowAlertThreshold)
+{
+	if (setAlertSetting(&BGAlertEvaluator::Settings::m_lowThreshold, newLowAlertThreshold))
+	{
+		emit lowAlertThresholdChanged();
+		evaluateAlerts();
+	}
+}
+
+
+float BGDataReceiver::highAlertThreshold() const
+{
+	return m_alertEvaluator.settings().m_highThreshold;
+}
+
+
+void BGDataReceiver::setHighAlertThreshold(float newHighAlertThreshold)
+{
+	if (setAlertSetting(&BGAlertEvaluator::Settings::m_highThreshold, newHighAlertThreshold))
+	{
+		emit highAlertThresholdChanged();
+		evaluateAlerts();
+	}
+}
+
+
+float BGDataReceiver::alertHysteresis() const
+{
+	return m_alertEvaluator.settings().m_hysteresis;
+}
+
+
+void BGDataReceiver::setAlertHysteresis(float newAlertHysteresis)
+{
+	if (setAlertSetting(&BGAlertEvaluator::Settings::m_hysteresis, newAlertHysteresis))
+	{
+		emit alertHysteresisChanged();
+		evaluateAlerts();
+	}
+}
+
+
+float BGDataReceiver::fastDropAlertRate() const
+{
+	return m_alertEvaluator.settings().m_fastDropRate;
+}
+
+
+void BGDataReceiver::setFastDropAlertRate(float newFastDropAlertRate)
+{
+	if (setAlertSetting(&BGAlertEvaluator::Settings::m_fastDropRate, newFastDropAlertRate))
+	{
+		emit fastDropAlertRateChanged();
+		evaluateAlerts();
+	}
+}
+
+
+float BGDataReceiver::fastRiseAlertRate() const
+{
+	return m_alertEvaluator.settings().m_fastRiseRate;
+}
+
+
+void BGDataReceiver::setFastRiseAlertRate(float newFastRiseAlertRate)
+{
+	if (setAlertSetting(&BGAlertEvaluator::Settings::m_fastRiseRate, newFastRiseAlertRate))
+	{
+		emit fastRiseAlertRateChanged();
+		evaluateAlerts();
+	}
+}
+
+
+int BGDataReceiver::staleDataAlertTimeout() const
+{
+	return m_alertEvaluator.settings().m_staleDataTimeout;
+}
+
+
+void BGDataReceiver::setStaleDataAlertTimeout(int newStaleDataAlertTimeout)
+{
+	if (setAlertSetting(&BGAlertEvaluator::Settings::m_staleDataTimeout, newStaleDataAlertTimeout))
+	{
+		emit staleDataAlertTimeoutChanged();
+		evaluateAlerts();
+	}
+}
+
+
+QVariant BGDataReceiver::minutesSinceBgStatus() const
+{
+	return toQVariant(m_minutesSinceBgStatus);
+}
+
+
+QVariant BGDataReceiver::minutesSinceLastLoop() const
+{
+	return toQVariant(m_minutesSinceLastLoop);
+}
+
+
+QVariantList BGDataReceiver::activeAlerts() const
+{
+	QVariantList alerts;
+
+	for (int alertIndex = 0; alertIndex < BGAlertEvaluator::NUM_ALERTS; ++alertIndex)
+	{
+		auto alert = BGAlertEvaluator::Alert(alertIndex);
+		if (m_alertEvaluator.isRaised(alert))
+			alerts.append(QVariant::fromValue(alert));
+	}
+
+	return alerts;
 }
 
 
@@ -195,28 +545,9 @@ void BGDataReceiver::generateTestQuantities()
 	bgStatus.m_delta = std::isnan(delta) ? QVariant() : QVariant::fromValue(delta);
 	bgStatus.m_isValid = isValidBgDistribution(randomNumberGenerator);
 	bgStatus.m_timestamp = QDateTime::currentDateTime();
-	if (std::isnan(delta))
-		bgStatus.m_trendArrow = BGStatus::TrendArrow::NONE;
-	else if (delta < -25)
-		bgStatus.m_trendArrow = BGStatus::TrendArrow::TRIPLE_DOWN;
-	else if (delta < -18)
-		bgStatus.m_trendArrow = BGStatus::TrendArrow::DOUBLE_DOWN;
-	else if (delta < -10)
-		bgStatus.m_trendArrow = BGStatus::TrendArrow::SINGLE_DOWN;
-	else if (delta < -5)
-		bgStatus.m_trendArrow = BGStatus::TrendArrow::FORTY_FIVE_DOWN;
-	else if (delta > +25)
-		bgStatus.m_trendArrow = BGStatus::TrendArrow::TRIPLE_UP;
-	else if (delta > +18)
-		bgStatus.m_trendArrow = BGStatus::TrendArrow::DOUBLE_UP;
-	else if (delta > +10)
-		bgStatus.m_trendArrow = BGStatus::TrendArrow::SINGLE_UP;
-	else if (delta > +5)
-		bgStatus.m_trendArrow = BGStatus::TrendArrow::FORTY_FIVE_UP;
-	else
-		bgStatus.m_trendArrow = BGStatus::TrendArrow::FLAT;
+	bgStatus.m_trendArrow = trendArrowFromDelta(delta);
 
-	QVariantList bgTimeSeries;
+	QPolygonF bgTimeSeries;
 	int bgTimeSeriesValue = bgTimeSeriesStartDistribution(randomNumberGenerator);
 	for (int i = 0; i < 100; ++i)
 	{
@@ -245,12 +576,44 @@ void BGDataReceiver::generateTestQuantities()
 	QDateTime lastLoopRunTimestamp = QDateTime::currentDateTime();
 
 	m_unit = glucoseUnitDistribution(randomNumberGenerator) ? Unit::MG_DL : Unit::MMOL_L;
+	if (bgStatus.m_isValid)
+		m_lastValidBGTimestamp = bgStatus.m_timestamp.toSecsSinceEpoch();
+
 	m_bgStatus = std::move(bgStatus);
 	m_iob = std::move(iob);
 	m_cob = std::move(cob);
 	m_lastLoopRunTimestamp = std::move(lastLoopRunTimestamp);
 	m_basalRate = std::move(basalRate);
-	m_bgTimeSeries = std::move(bgTimeSeries);
+	m_bgTimeSeries.setPoints(std::move(bgTimeSeries));
+
+	// Feed the forecaster with a short BG history that
+	// matches the generated delta to get a test forecast.
+	double bgStatusTime = m_bgStatus->m_timestamp.toSecsSinceEpoch() / 60.0;
+	for (int i = 2; i >= 0; --i)
+	{
+		m_bgForecaster.addPoint(
+			bgStatusTime - i * CGM_READING_INTERVAL,
+			m_bgStatus->m_bgValue - i * m_bgStatus->m_delta.toFloat()
+		);
+	}
+	updateForecasts();
+
+	// Generate test percentile bands out of 14 days of BG values
+	// that follow a daily pattern. These are kept separate from
+	// the persistent statistics to not pollute them with test data.
+	BGPercentileBands testPercentileBandsStatistics;
+	std::normal_distribution<float> percentileBandsNoiseDistribution(0.0f, 25.0f);
+	qint64 numTestReadings = BGPercentileBands::NUM_DAYS * 24 * 60 / CGM_READING_INTERVAL;
+	for (qint64 readingIndex = numTestReadings - 1; readingIndex >= 0; --readingIndex)
+	{
+		QDateTime timestamp = m_bgStatus->m_timestamp.addSecs(-readingIndex * CGM_READING_INTERVAL * 60);
+		float phase = timestamp.toLocalTime().time().hour() / 24.0f * 2.0f * float(M_PI);
+		float bgValue = 140.0f + 40.0f * std::sin(phase) + percentileBandsNoiseDistribution(randomNumberGenerator);
+		testPercentileBandsStatistics.addReading(timestamp, bgValue);
+	}
+	m_percentileBands = toPercentileBandsVariantList(testPercentileBandsStatistics);
+
+	updatePropertyVariants();
 
 	emit unitChanged();
 	emit bgStatusChanged();
@@ -258,8 +621,14 @@ void BGDataReceiver::generateTestQuantities()
 	emit carbsOnBoardChanged();
 	emit lastLoopRunTimestampChanged();
 	emit basalRateChanged();
+	emit bgForecastChanged();
+	emit bgForecastTimeSeriesChanged();
+	emit percentileBandsChanged();
 
 	emit newDataReceived();
+
+	evaluateAlerts();
+	updateMinutesSince();
 }
 
 
@@ -285,6 +654,15 @@ QVariant BGDataReceiver::getTimespansSince(QDateTime now)
 }
 
 
+void BGDataReceiver::snoozeAlert(BGAlertEvaluator::Alert alert, int minutes)
+{
+	qCDebug(lcQmlBgData) << "Snoozing alert" << alert << "for" << minutes << "minute(s)";
+
+	m_alertEvaluator.snooze(alert, QDateTime::currentSecsSinceEpoch() + qint64(std::max(minutes, 0)) * 60);
+	evaluateAlerts();
+}
+
+
 void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 {
 	qCDebug(lcQmlBgData).nospace().noquote() << "Got message; source: " << source;
@@ -340,9 +718,14 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 			emit carbsOnBoardChanged();
 			emit lastLoopRunTimestampChanged();
 			emit basalRateChanged();
+			emit bgForecastChanged();
+			emit bgForecastTimeSeriesChanged();
 
 			emit newDataReceived();
 
+			evaluateAlerts();
+			updateMinutesSince();
+
 			return;
 		}
 
@@ -377,7 +760,11 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 		auto newUnit = (flags & FLAG_UNIT_IS_MG_DL) ? Unit::MG_DL : Unit::MMOL_L;
 		if (!m_unit.has_value() || (m_unit != newUnit))
 		{
+			// BG values in different units cannot be mixed in a forecast.
+			m_bgForecaster.reset();
+
 			m_unit = newUnit;
+			m_unitVariant = toQVariant(m_unit);
 			emit unitChanged();
 		}
 
@@ -404,6 +791,11 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 			changed = changed || (m_basalRate->m_tbrPercentage != tbrPercentage);
 			m_basalRate->m_tbrPercentage = tbrPercentage;
 
+			// The variant is also rebuilt if nothing changed, since changes
+			// that are smaller than the epsilon are still stored. This still
+			// happens at most once per message.
+			m_basalRateVariant = toQVariant(m_basalRate);
+
 			if (changed)
 			{
 				qCDebug(lcQmlBgData) << "Basal rate changed:"
@@ -419,8 +811,6 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 		{
 			bool changed = false;
 
-			m_bgStatus->m_isValid = !!(flags & FLAG_BG_VALUE_IS_VALID);
-
 			// Create new BGStatus instance on demand.
 			if (!m_bgStatus.has_value())
 			{
@@ -428,6 +818,10 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 				m_bgStatus = BGStatus();
 			}
 
+			bool isValid = !!(flags & FLAG_BG_VALUE_IS_VALID);
+			changed = changed || (m_bgStatus->m_isValid != isValid);
+			m_bgStatus->m_isValid = isValid;
+
 			float bgValue = floatFrom(payload, offset);
 			changed = changed || (std::abs(m_bgStatus->m_bgValue - bgValue) >= bgValueEpsilon);
 			m_bgStatus->m_bgValue = bgValue;
@@ -474,14 +868,44 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 					break;
 			}
 
+			// Feed the forecaster before looking at the trend arrow, since
+			// a locally derived arrow must take the new BG value into account.
+			// Invalid BG values are excluded, like from the percentile bands,
+			// since they would distort the fitted trend.
+			if (isValid)
+			{
+				m_bgForecaster.addPoint(timestamp.toSecsSinceEpoch() / 60.0, bgValue);
+				if (timestamp.isValid())
+					m_lastValidBGTimestamp = timestamp.toSecsSinceEpoch();
+			}
+
+			bool isTrendArrowEstimated = false;
+			if ((trendArrow == BGStatus::TrendArrow::NONE) && m_bgForecaster.hasTrend())
+			{
+				float deltaPerReading = m_bgForecaster.slope() * CGM_READING_INTERVAL;
+				if (m_unit == Unit::MMOL_L)
+					deltaPerReading *= MG_DL_PER_MMOL_L;
+
+				trendArrow = trendArrowFromDelta(deltaPerReading);
+				isTrendArrowEstimated = true;
+				qCDebug(lcQmlBgData) << "No trend arrow present; estimated trend arrow:" << trendArrow;
+			}
+
 			changed = changed || (m_bgStatus->m_trendArrow != trendArrow);
 			m_bgStatus->m_trendArrow = trendArrow;
 
+			changed = changed || (m_bgStatus->m_isTrendArrowEstimated != isTrendArrowEstimated);
+			m_bgStatus->m_isTrendArrowEstimated = isTrendArrowEstimated;
+
+			m_bgStatusVariant = toQVariant(m_bgStatus);
+
 			if (changed)
 			{
 				qCDebug(lcQmlBgData) << "BG status changed";
 				emit bgStatusChanged();
 			}
+
+			addPercentileBandsReading(*m_bgStatus);
 		}
 
 		// BG time series
@@ -489,20 +913,7 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 			qint16 numDataPoints = int16From(payload, offset);
 			qCDebug(lcQmlBgData) << "BG time series contains" << numDataPoints << "point(s)";
 
-			m_bgTimeSeries = QVariantList();
-
-			for (int dataPointIndex = 0; dataPointIndex < numDataPoints; ++dataPointIndex)
-			{
-				qint16 timestamp = int16From(payload, offset);
-				qint16 bgValue = int16From(payload, offset);
-
-				m_bgTimeSeries.append(
-					QPointF(
-						double(timestamp) / 32767.0,
-						double(bgValue) / 32767.0
-					)
-				);
-			}
+			m_bgTimeSeries.setPoints(timeSeriesFrom(payload, offset, numDataPoints));
 		}
 
 		// Basal time series
@@ -510,20 +921,7 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 			qint16 numDataPoints = int16From(payload, offset);
 			qCDebug(lcQmlBgData) << "Basal time series contains" << numDataPoints << "point(s)";
 
-			m_basalTimeSeries = QVariantList();
-
-			for (int dataPointIndex = 0; dataPointIndex < numDataPoints; ++dataPointIndex)
-			{
-				qint16 timestamp = int16From(payload, offset);
-				qint16 basalValue = int16From(payload, offset);
-
-				m_basalTimeSeries.append(
-					QPointF(
-						double(timestamp) / 32767.0,
-						double(basalValue) / 32767.0
-					)
-				);
-			}
+			m_basalTimeSeries.setPoints(timeSeriesFrom(payload, offset, numDataPoints));
 		}
 
 		// Base basal time series
@@ -531,20 +929,7 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 			qint16 numDataPoints = int16From(payload, offset);
 			qCDebug(lcQmlBgData) << "Base basal time series contains" << numDataPoints << "point(s)";
 
-			m_baseBasalTimeSeries = QVariantList();
-
-			for (int dataPointIndex = 0; dataPointIndex < numDataPoints; ++dataPointIndex)
-			{
-				qint16 timestamp = int16From(payload, offset);
-				qint16 baseBasalValue = int16From(payload, offset);
-
-				m_baseBasalTimeSeries.append(
-					QPointF(
-						double(timestamp) / 32767.0,
-						double(baseBasalValue) / 32767.0
-					)
-				);
-			}
+			m_baseBasalTimeSeries.setPoints(timeSeriesFrom(payload, offset, numDataPoints));
 		}
 
 		// Insulin On Board (IOB)
@@ -568,6 +953,8 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 
 			qCDebug(lcQmlBgData).nospace() << "basal/bolus IOB: " << basal << "/" << bolus;
 
+			m_iobVariant = toQVariant(m_iob);
+
 			if (changed)
 			{
 				qCDebug(lcQmlBgData) << "Insulin On Board (IOB) changed";
@@ -596,6 +983,8 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 
 			qCDebug(lcQmlBgData).nospace() << "current/future IOB: " << current << "/" << future;
 
+			m_cobVariant = toQVariant(m_cob);
+
 			if (changed)
 			{
 				qCDebug(lcQmlBgData) << "Carbs On Board (COB) changed";
@@ -613,9 +1002,17 @@ void BGDataReceiver::pushMessage(QString source, QByteArray payload)
 			m_lastLoopRunTimestamp = lastLoopRunTimestamp;
 
 			qCDebug(lcQmlBgData) << "lastLoopRunTimestamp:" << lastLoopRunTimestamp;
+
+			if (changed)
+				emit lastLoopRunTimestampChanged();
 		}
 
+		updateForecasts();
+
 		emit newDataReceived();
+
+		evaluateAlerts();
+		updateMinutesSince();
 	}
 	catch (std::out_of_range const &e)
 	{
@@ -632,5 +1029,320 @@ void BGDataReceiver::clearAllQuantities()
 	m_cob = std::nullopt;
 	m_lastLoopRunTimestamp = QDateTime();
 	m_basalRate = std::nullopt;
-	m_bgTimeSeries = QVariantList();
+	m_bgTimeSeries.setPoints(QPolygonF());
+	m_bgForecaster.reset();
+	m_bgForecast = QVariantList();
+	m_bgForecastTimeSeries = QVariantList();
+
+	updatePropertyVariants();
+}
+
+
+void BGDataReceiver::updatePropertyVariants()
+{
+	m_unitVariant = toQVariant(m_unit);
+	m_bgStatusVariant = toQVariant(m_bgStatus);
+	m_iobVariant = toQVariant(m_iob);
+	m_cobVariant = toQVariant(m_cob);
+	m_basalRateVariant = toQVariant(m_basalRate);
+}
+
+
+void BGDataReceiver::addPercentileBandsReading(BGStatus const &bgStatus)
+{
+	if (!bgStatus.m_isValid)
+		return;
+
+	// The statistics always use mg/dL.
+	float bgValue = bgStatus.m_bgValue;
+	if (m_unit == Unit::MMOL_L)
+		bgValue *= MG_DL_PER_MMOL_L;
+
+	// This returns false if the reading was already added before,
+	// which happens when the BG status block is resent.
+	if (!m_percentileBandsStatistics.addReading(bgStatus.m_timestamp, bgValue))
+		return;
+
+	m_percentileBands = toPercentileBandsVariantList(m_percentileBandsStatistics);
+	emit percentileBandsChanged();
+
+	++m_numUnsavedPercentileBandsReadings;
+	if (m_numUnsavedPercentileBandsReadings >= PERCENTILE_BANDS_SAVE_INTERVAL)
+		savePercentileBands();
+}
+
+
+void BGDataReceiver::loadPercentileBands()
+{
+	QString path = QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath(PERCENTILE_BANDS_FILENAME);
+
+	QFile file(path);
+	if (!file.exists())
+	{
+		qCDebug(lcQmlBgData) << "No percentile bands statistics found at" << path;
+		return;
+	}
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qCWarning(lcQmlBgData) << "Could not open percentile bands statistics file" << path << ":" << file.errorString();
+		return;
+	}
+
+	if (!m_percentileBandsStatistics.deserialize(file.readAll()))
+	{
+		qCWarning(lcQmlBgData) << "Percentile bands statistics file" << path << "is invalid; discarding its contents";
+		m_percentileBandsStatistics.clear();
+		return;
+	}
+
+	qCDebug(lcQmlBgData) << "Loaded percentile bands statistics from" << path;
+
+	m_percentileBands = toPercentileBandsVariantList(m_percentileBandsStatistics);
+}
+
+
+void BGDataReceiver::savePercentileBands()
+{
+	QString directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+	if (!QDir().mkpath(directory))
+	{
+		qCWarning(lcQmlBgData) << "Could not create directory" << directory << "for percentile bands statistics";
+		return;
+	}
+
+	QString path = QDir(directory).filePath(PERCENTILE_BANDS_FILENAME);
+
+	// Using QSaveFile to not corrupt any existing file
+	// if something goes wrong while writing.
+	QSaveFile file(path);
+	if (!file.open(QIODevice::WriteOnly)
+	 || (file.write(m_percentileBandsStatistics.serialize()) < 0)
+	 || !file.commit())
+	{
+		qCWarning(lcQmlBgData) << "Could not save percentile bands statistics to" << path << ":" << file.errorString();
+		return;
+	}
+
+	qCDebug(lcQmlBgData) << "Saved percentile bands statistics to" << path;
+
+	m_numUnsavedPercentileBandsReadings = 0;
+}
+
+
+void BGDataReceiver::evaluateAlerts()
+{
+	BGAlertEvaluator::Input input;
+
+	if (m_bgStatus.has_value())
+	{
+		// The alert evaluator always uses mg/dL.
+		float unitFactor = (m_unit == Unit::MMOL_L) ? MG_DL_PER_MMOL_L : 1.0f;
+
+		input.m_hasBGValue = m_bgStatus->m_isValid;
+		input.m_bgValue = m_bgStatus->m_bgValue * unitFactor;
+
+		// Prefer the delta from the BG data source, since it is based on
+		// the actual CGM readings. Fall back to the forecaster's trend.
+		if (m_bgStatus->m_delta.isValid())
+			input.m_rate = m_bgStatus->m_delta.toFloat() * unitFactor / CGM_READING_INTERVAL;
+		else if (m_bgForecaster.hasTrend())
+			input.m_rate = m_bgForecaster.slope() * unitFactor;
+	}
+
+	input.m_lastValidBGTimestamp = m_lastValidBGTimestamp;
+
+	qint64 now = QDateTime::currentSecsSinceEpoch();
+
+	std::vector<BGAlertEvaluator::Transition> transitions;
+	m_alertEvaluator.evaluate(input, now, transitions);
+
+	for (auto const &transition : transitions)
+	{
+		if (transition.m_isRaised)
+		{
+			qCDebug(lcQmlBgData) << "Alert raised:" << transition.m_alert;
+			emit alertRaised(transition.m_alert);
+		}
+		else
+		{
+			qCDebug(lcQmlBgData) << "Alert cleared:" << transition.m_alert;
+			emit alertCleared(transition.m_alert);
+		}
+	}
+
+	if (!transitions.empty())
+		emit activeAlertsChanged();
+
+	// Schedule the next evaluation for when an alert state may change
+	// without new data arriving. If there is no such point in time,
+	// stop the timer, so no wakeups happen when nothing can change.
+	// The interval is clamped, since QTimer takes it in milliseconds as
+	// an int, which overflows after about 24.8 days (for example with a
+	// long snooze). If the timer fires before the actual time, this
+	// function simply schedules the remaining interval again.
+	std::optional<qint64> nextEvaluationTime = m_alertEvaluator.nextEvaluationTime(input, now);
+	if (nextEvaluationTime.has_value())
+		m_alertTimer.start(int(std::clamp<qint64>(*nextEvaluationTime - now, 1, MAX_ALERT_TIMER_INTERVAL) * 1000));
+	else
+		m_alertTimer.stop();
+}
+
+
+void BGDataReceiver::updateMinutesSince()
+{
+	qint64 const msecsPerMinute = 60 * 1000;
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	std::optional<qint64> nextMinuteBoundary;
+
+	// Computes the minutes since the timestamp, and the time when
+	// that number of minutes will next change. Returns true if
+	// the number of minutes is not the same as before.
+	auto update = [&](QDateTime const &timestamp, std::optional<int> &minutesSince) -> bool {
+		std::optional<int> newMinutesSince;
+
+		if (timestamp.isValid())
+		{
+			qint64 timestampInMSecs = timestamp.toMSecsSinceEpoch();
+			qint64 elapsedMinutes = std::max<qint64>(now - timestampInMSecs, 0) / msecsPerMinute;
+			newMinutesSince = int(elapsedMinutes);
+
+			qint64 boundary = timestampInMSecs + (elapsedMinutes + 1) * msecsPerMinute;
+			if (!nextMinuteBoundary.has_value() || (boundary < *nextMinuteBoundary))
+				nextMinuteBoundary = boundary;
+		}
+
+		if (newMinutesSince == minutesSince)
+			return false;
+
+		minutesSince = newMinutesSince;
+		return true;
+	};
+
+	if (update(m_bgStatus.has_value() ? m_bgStatus->m_timestamp : QDateTime(), m_minutesSinceBgStatus))
+		emit minutesSinceBgStatusChanged();
+
+	if (update(m_lastLoopRunTimestamp, m_minutesSinceLastLoop))
+		emit minutesSinceLastLoopChanged();
+
+	// If there are no timestamps, then there is nothing to count,
+	// so the timer is stopped to avoid needless wakeups. The interval
+	// is capped, since timestamps that lie in the future (due to clock
+	// differences between the BG data source and the watch) can put
+	// the next boundary arbitrarily far away.
+	if (nextMinuteBoundary.has_value())
+		m_minutesSinceTimer.start(int(std::min(*nextMinuteBoundary - now, 60 * msecsPerMinute)));
+	else
+		m_minutesSinceTimer.stop();
+}
+
+
+template<typename T>
+bool BGDataReceiver::setAlertSetting(T BGAlertEvaluator::Settings::*setting, T newValue)
+{
+	BGAlertEvaluator::Settings settings = m_alertEvaluator.settings();
+	if (settings.*setting == newValue)
+		return false;
+
+	settings.*setting = newValue;
+	m_alertEvaluator.setSettings(std::move(settings));
+
+	return true;
+}
+
+
+void BGDataReceiver::updateForecasts()
+{
+	int numForecastSteps = m_forecastHorizon / CGM_READING_INTERVAL;
+
+	// BG value forecast
+
+	QVariantList newBGForecast;
+
+	if (m_bgForecaster.hasTrend())
+	{
+		for (int step = 1; step <= numForecastSteps; ++step)
+		{
+			double forecastTime = m_bgForecaster.latestTime() + step * CGM_READING_INTERVAL;
+			newBGForecast.append(float(m_bgForecaster.predict(forecastTime)));
+		}
+	}
+
+	if (newBGForecast != m_bgForecast)
+	{
+		qCDebug(lcQmlBgData) << "BG forecast changed:" << newBGForecast;
+		m_bgForecast = std::move(newBGForecast);
+		emit bgForecastChanged();
+	}
+
+	// BG time series forecast
+
+	QVariantList newBGForecastTimeSeries = predictBGTimeSeries(numForecastSteps);
+
+	if (newBGForecastTimeSeries != m_bgForecastTimeSeries)
+	{
+		m_bgForecastTimeSeries = std::move(newBGForecastTimeSeries);
+		emit bgForecastTimeSeriesChanged();
+	}
+}
+
+
+QVariantList BGDataReceiver::predictBGTimeSeries(int numForecastSteps) const
+{
+	QVariantList forecastTimeSeries;
+
+	QPolygonF const &bgTimeSeries = m_bgTimeSeries.m_points;
+
+	int numTailPoints = std::min(int(bgTimeSeries.size()), NUM_FORECAST_TIME_SERIES_TAIL_POINTS);
+	if (numTailPoints < 2)
+		return forecastTimeSeries;
+
+	int firstTailPointIndex = bgTimeSeries.size() - numTailPoints;
+
+	// The time series has no absolute timestamps. To be able to use the
+	// forecaster's time constants, which are given in minutes, convert
+	// the normalized timestamps to minutes by assuming that the median
+	// distance between the tail points is one CGM reading interval.
+	std::vector<double> pointDistances;
+	for (int pointIndex = firstTailPointIndex + 1; pointIndex < bgTimeSeries.size(); ++pointIndex)
+	{
+		double distance = bgTimeSeries[pointIndex].x() - bgTimeSeries[pointIndex - 1].x();
+		if (distance > 0.0)
+			pointDistances.push_back(distance);
+	}
+
+	if (pointDistances.empty())
+		return forecastTimeSeries;
+
+	auto medianIter = pointDistances.begin() + pointDistances.size() / 2;
+	std::nth_element(pointDistances.begin(), medianIter, pointDistances.end());
+	double timestampsPerMinute = *medianIter / CGM_READING_INTERVAL;
+
+	BGForecaster timeSeriesForecaster(FORECAST_WEIGHT_TIME_CONSTANT, FORECAST_TREND_DAMPING_TIME_CONSTANT, FORECAST_MAX_GAP);
+	for (int pointIndex = firstTailPointIndex; pointIndex < bgTimeSeries.size(); ++pointIndex)
+	{
+		QPointF const &point = bgTimeSeries[pointIndex];
+		timeSeriesForecaster.addPoint(point.x() / timestampsPerMinute, point.y());
+	}
+
+	if (!timeSeriesForecaster.hasTrend())
+		return forecastTimeSeries;
+
+	QPointF lastPoint = bgTimeSeries.back();
+	forecastTimeSeries.append(lastPoint);
+
+	for (int step = 1; step <= numForecastSteps; ++step)
+	{
+		double minutesAhead = step * CGM_READING_INTERVAL;
+		double forecastValue = timeSeriesForecaster.predict(timeSeriesForecaster.latestTime() + minutesAhead);
+
+		forecastTimeSeries.append(
+			QPointF(
+				lastPoint.x() + minutesAhead * timestampsPerMinute,
+				std::clamp(forecastValue, 0.0, 1.0)
+			)
+		);
+	}
+
+	return forecastTimeSeries;
 }
@@ -6,7 +6,12 @@
 #include <QString>
 #include <QJsonObject>
 #include <QDateTime>
+#include <QPolygonF>
 #include <QVariant>
+#include <QTimer>
+#include "bgalertevaluator.hpp"
+#include "bgforecaster.hpp"
+#include "bgpercentilebands.hpp"
 
 /*!
 	\class BGStatus
@@ -34,7 +39,7 @@
 		when this BG status was updated. This can be invalid (in QML,
 		this means a null value) if no BG status update timestamp is
 		known. Typically, this property is not used. Instead, it is
-		recommended to use \c {BGDataReceiver.getTimespansSince()}.
+		recommended to use \c {BGDataReceiver.minutesSinceBgStatus}.
 	\li trendArrow : Enum indicating the trend of the BG value's
 		change. If no trend is currently known, this is set to
 		\c {TrendArrow.NONE}. Ideally, this should be visualized by
@@ -47,6 +52,14 @@
 		"→". \c {TrendArrow.FORTY_FIVE_UP} and \c {TrendArrow.FORTY_FIVE_DOWN}
 		point upwards/downwards and to the right, like "↗" and
 		"↘", respectively.
+		If the BG data source does not provide a trend arrow,
+		\c BGDataReceiver derives one locally out of the recent BG values
+		(see \c isTrendArrowEstimated).
+	\li isTrendArrowEstimated : True if \c trendArrow was not provided by
+		the BG data source, but was instead derived locally by
+		\c BGDataReceiver out of the recently received BG values. UIs
+		may want to show such an estimated trend arrow in a less
+		prominent style.
 	\endlist
 
 	For bgValue, the recommended number of fractional digits shown
@@ -90,6 +103,7 @@ private:
 	Q_PROPERTY(bool isValid MEMBER m_isValid)
 	Q_PROPERTY(QDateTime timestamp MEMBER m_timestamp)
 	Q_PROPERTY(TrendArrow trendArrow MEMBER m_trendArrow)
+	Q_PROPERTY(bool isTrendArrowEstimated MEMBER m_isTrendArrowEstimated)
 
 public:
 	float m_bgValue = 0;
@@ -97,6 +111,7 @@ public:
 	bool m_isValid = false;
 	QDateTime m_timestamp;
 	TrendArrow m_trendArrow = TrendArrow::NONE;
+	bool m_isTrendArrowEstimated = false;
 };
 
 /*!
@@ -281,7 +296,39 @@ public:
 	is to pass them to the corresponding properties in a \c BGTimeSeriesView. The whole
 	point of these time series is visualization, which \c BGTimeSeriesView takes care of.
 
-	NOTE: The basalTimeSeries and baseBasalTimeSeries properties are currently not in use.
+	Wrapping each point in its own \c QVariant costs one memory allocation per point.
+	For this reason, the time series are also available as \c QPolygonF instances
+	(\c bgTimeSeriesPoints, \c basalTimeSeriesPoints and \c baseBasalTimeSeriesPoints),
+	which are implicitly shared arrays of points. The views have matching properties
+	that take these without converting individual points. The lists of variants are
+	only created when they are read.
+
+	The basalTimeSeries and baseBasalTimeSeries properties are drawn by
+	\c BGBasalTimeSeriesView as a step graph.
+
+	The receiver also computes a short-term forecast of the BG value. This is useful
+	for when the connection to the BG data source is interrupted. The forecast is
+	available in two forms: \c bgForecast contains predicted BG values (in the unit
+	specified by the \c unit property) in 5 minute steps, and \c bgForecastTimeSeries
+	contains the prediction as a continuation of \c bgTimeSeries. The latter can be
+	passed to \c {BGTimeSeriesView.bgForecastTimeSeries}, which draws it as a
+	dashed line. How far the forecast reaches is set by \c forecastHorizon.
+
+	For "typical day" views, the receiver keeps statistics of the BG values of the
+	past 14 days, grouped by time of day. These statistics have a fixed size and
+	are stored on disk, so they survive restarts. \c percentileBands contains the
+	5th, 25th, 50th, 75th and 95th percentiles computed out of these statistics.
+	It can be passed to \c {BGTimeSeriesView.percentileBands} for drawing them.
+
+	Alerts for low and high BG values, fast BG drops and rises, and stale data are
+	evaluated natively by the receiver every time a message is decoded. Stale data
+	and the ends of alert snoozes are detected with one coarse internal timer that
+	only runs when such an event is pending. \c alertRaised and \c alertCleared are
+	only emitted when an alert changes its state, so watchfaces do not need any
+	JavaScript timers or checks in \c bgStatusChanged handlers for this. The alerts
+	are configured with the \c {*Alert*} properties; see \c BGAlertEvaluator for
+	the details about how the alerts behave. Alert thresholds are always given in
+	mg/dL, even if the \c unit is mmol/L.
 
 	When new BG data is received, the class checks which parts of the BG data actually
 	changed. If for example a new BG status is contained in the BG data, but it turns
@@ -303,10 +350,13 @@ public:
 	for that BG data. \c {generateTestQuantities()} can be used to generate random BG data.
 	Doing this will emit all of the \c {*Changed} signals as well as \c newDataReceived.
 
-	\c {getTimespansSince()} is useful for getting a \c Timespans instance that contains
-	the times since the BG data was updated and since the closed-loop system was run.
-	This is needed for "X min ago" information shown on the UI. See the \c Timespans
-	and \c {getTimespansSince()} documentations for details.
+	\c minutesSinceBgStatus and \c minutesSinceLastLoop contain the minutes since the
+	BG data was updated and since the closed-loop system was run. This is needed for
+	"X min ago" information shown on the UI. These properties are updated by the
+	receiver itself exactly when the minute count changes, so UIs can simply bind to
+	them instead of polling with a QML Timer. If second accuracy is needed,
+	\c {getTimespansSince()} can be used to get a \c Timespans instance instead.
+	See the \c Timespans and \c {getTimespansSince()} documentations for details.
 
 	Basic example QML usage:
 
@@ -392,19 +442,182 @@ private:
 	Q_PROPERTY(QVariantList const & bgTimeSeries READ bgTimeSeries)
 	Q_PROPERTY(QVariantList const & basalTimeSeries READ basalTimeSeries)
 	Q_PROPERTY(QVariantList const & baseBasalTimeSeries READ baseBasalTimeSeries)
+	Q_PROPERTY(QPolygonF bgTimeSeriesPoints READ bgTimeSeriesPoints)
+	Q_PROPERTY(QPolygonF basalTimeSeriesPoints READ basalTimeSeriesPoints)
+	Q_PROPERTY(QPolygonF baseBasalTimeSeriesPoints READ baseBasalTimeSeriesPoints)
+
+	/*!
+		\property BGDataReceiver::forecastHorizon
+		\brief How many minutes into the future the BG forecast reaches.
+
+		Valid values are in the 5-60 range. Values outside of that range are
+		clamped. The default value is 30.
+	*/
+	Q_PROPERTY(int forecastHorizon READ forecastHorizon WRITE setForecastHorizon NOTIFY forecastHorizonChanged)
+
+	/*!
+		\property BGDataReceiver::bgForecast
+		\brief Predicted BG values for the next \c forecastHorizon minutes.
+
+		This is a list of numbers, one for every 5 minutes after the
+		timestamp of the current \c bgStatus. The first number is the value
+		predicted for 5 minutes after that timestamp. Their unit is the one
+		specified by the \c unit property. The prediction is derived from the
+		recently received BG status values. If not enough BG status values
+		have been received so far, this list is empty.
+	*/
+	Q_PROPERTY(QVariantList bgForecast READ bgForecast NOTIFY bgForecastChanged)
+
+	/*!
+		\property BGDataReceiver::bgForecastTimeSeries
+		\brief Predicted continuation of \c bgTimeSeries.
+
+		The points use the same normalized coordinates as \c bgTimeSeries.
+		The first point is the last point of \c bgTimeSeries, and the other
+		points lie in the future, meaning that their timestamps are greater
+		than 1. Since the time series does not contain absolute timestamps,
+		the time series points are assumed to be 5 minutes apart, which is
+		the usual CGM reading interval. Just like the other time series,
+		this is updated every time \c newDataReceived is emitted. It is
+		also updated when \c forecastHorizon changes, which does not
+		emit \c newDataReceived. Use the change signal of this property
+		to get notified about both.
+	*/
+	Q_PROPERTY(QVariantList const & bgForecastTimeSeries READ bgForecastTimeSeries NOTIFY bgForecastTimeSeriesChanged)
+
+	/*!
+		\property BGDataReceiver::percentileBands
+		\brief BG percentiles of the past 14 days, by time of day.
+
+		This is a list of 5 time series, containing the 5th, 25th, 50th, 75th
+		and 95th percentile, in that order. In each time series, the timestamps
+		are the time of day, normalized to the 0-1 range, where 0 is midnight
+		and 1 is the next midnight. The BG values are normalized linearly to
+		the 0-1 range, where 0 corresponds to 40 mg/dL and 1 to 400 mg/dL.
+		Times of day with no BG readings are skipped. If there are no BG
+		readings at all, this is an empty list.
+	*/
+	Q_PROPERTY(QVariantList percentileBands READ percentileBands NOTIFY percentileBandsChanged)
+
+	/*!
+		\property BGDataReceiver::lowAlertThreshold
+		\brief BG value below which the LOW alert is raised, in mg/dL.
+
+		The default value is 70. Setting this to 0 disables the alert.
+	*/
+	Q_PROPERTY(float lowAlertThreshold READ lowAlertThreshold WRITE setLowAlertThreshold NOTIFY lowAlertThresholdChanged)
+
+	/*!
+		\property BGDataReceiver::highAlertThreshold
+		\brief BG value above which the HIGH alert is raised, in mg/dL.
+
+		The default value is 180. Setting this to 0 disables the alert.
+	*/
+	Q_PROPERTY(float highAlertThreshold READ highAlertThreshold WRITE setHighAlertThreshold NOTIFY highAlertThresholdChanged)
+
+	/*!
+		\property BGDataReceiver::alertHysteresis
+		\brief How far the BG value has to move back past a threshold to clear the LOW and HIGH alerts, in mg/dL.
+
+		The default value is 10.
+	*/
+	Q_PROPERTY(float alertHysteresis READ alertHysteresis WRITE setAlertHysteresis NOTIFY alertHysteresisChanged)
+
+	/*!
+		\property BGDataReceiver::fastDropAlertRate
+		\brief BG drop rate above which the FAST_DROP alert is raised, in mg/dL per minute.
+
+		The default value is 3. Setting this to 0 disables the alert.
+	*/
+	Q_PROPERTY(float fastDropAlertRate READ fastDropAlertRate WRITE setFastDropAlertRate NOTIFY fastDropAlertRateChanged)
+
+	/*!
+		\property BGDataReceiver::fastRiseAlertRate
+		\brief BG rise rate above which the FAST_RISE alert is raised, in mg/dL per minute.
+
+		The default value is 3. Setting this to 0 disables the alert.
+	*/
+	Q_PROPERTY(float fastRiseAlertRate READ fastRiseAlertRate WRITE setFastRiseAlertRate NOTIFY fastRiseAlertRateChanged)
+
+	/*!
+		\property BGDataReceiver::staleDataAlertTimeout
+		\brief Age of the last valid BG reading after which the STALE_DATA alert is raised, in minutes.
+
+		Messages that clear all data do not reset this age, since they are
+		sent when the BG data source restarts, which is one of the cases
+		this alert is meant to catch. If no valid reading was received at
+		all, the age is counted from when the receiver was created.
+		The default value is 20. Setting this to 0 disables the alert.
+	*/
+	Q_PROPERTY(int staleDataAlertTimeout READ staleDataAlertTimeout WRITE setStaleDataAlertTimeout NOTIFY staleDataAlertTimeoutChanged)
+
+	/*!
+		\property BGDataReceiver::activeAlerts
+		\brief List of the currently raised alerts.
+
+		The items are \c {BGAlertEvaluator.Alert} values.
+	*/
+	Q_PROPERTY(QVariantList activeAlerts READ activeAlerts NOTIFY activeAlertsChanged)
+
+	/*!
+		\property BGDataReceiver::minutesSinceBgStatus
+		\brief Number of full minutes since the timestamp of the current BG status.
+
+		This is null if no BG status (or no BG status timestamp) is known.
+		The receiver updates this property when the number of minutes
+		changes, so no polling is necessary.
+	*/
+	Q_PROPERTY(QVariant minutesSinceBgStatus READ minutesSinceBgStatus NOTIFY minutesSinceBgStatusChanged)
+
+	/*!
+		\property BGDataReceiver::minutesSinceLastLoop
+		\brief Number of full minutes since the closed-loop system was last run.
+
+		This is null if the last loop run timestamp is not known.
+		The receiver updates this property when the number of minutes
+		changes, so no polling is necessary.
+	*/
+	Q_PROPERTY(QVariant minutesSinceLastLoop READ minutesSinceLastLoop NOTIFY minutesSinceLastLoopChanged)
 
 public:
 	explicit BGDataReceiver(QObject *parent = nullptr);
+	~BGDataReceiver() override;
 
-	QVariant unit() const;
-	QVariant bgStatus() const;
-	QVariant insulinOnBoard() const;
-	QVariant carbsOnBoard() const;
+	QVariant const & unit() const;
+	QVariant const & bgStatus() const;
+	QVariant const & insulinOnBoard() const;
+	QVariant const & carbsOnBoard() const;
 	QDateTime const & lastLoopRunTimestamp() const;
-	QVariant basalRate() const;
+	QVariant const & basalRate() const;
 	QVariantList const & bgTimeSeries() const;
 	QVariantList const & basalTimeSeries() const;
 	QVariantList const & baseBasalTimeSeries() const;
+	QPolygonF const & bgTimeSeriesPoints() const;
+	QPolygonF const & basalTimeSeriesPoints() const;
+	QPolygonF const & baseBasalTimeSeriesPoints() const;
+
+	int forecastHorizon() const;
+	void setForecastHorizon(int newForecastHorizon);
+	QVariantList const & bgForecast() const;
+	QVariantList const & bgForecastTimeSeries() const;
+	QVariantList const & percentileBands() const;
+
+	float lowAlertThreshold() const;
+	void setLowAlertThreshold(float newLowAlertThreshold);
+	float highAlertThreshold() const;
+	void setHighAlertThreshold(float newHighAlertThreshold);
+	float alertHysteresis() const;
+	void setAlertHysteresis(float newAlertHysteresis);
+	float fastDropAlertRate() const;
+	void setFastDropAlertRate(float newFastDropAlertRate);
+	float fastRiseAlertRate() const;
+	void setFastRiseAlertRate(float newFastRiseAlertRate);
+	int staleDataAlertTimeout() const;
+	void setStaleDataAlertTimeout(int newStaleDataAlertTimeout);
+	QVariantList activeAlerts() const;
+
+	QVariant minutesSinceBgStatus() const;
+	QVariant minutesSinceLastLoop() const;
 
 	/*!
 		\fn BGDataReceiver::generateTestQuantities()
@@ -437,6 +650,16 @@ public:
 	*/
 	Q_INVOKABLE QVariant getTimespansSince(QDateTime now);
 
+	/*!
+		\fn BGDataReceiver::snoozeAlert(BGAlertEvaluator::Alert alert, int minutes)
+
+		Snoozes the given alert for the given number of minutes. If the alert
+		is currently raised, it is cleared. While snoozed, the alert is not
+		raised, even if its condition is met. A value of 0 for \c minutes
+		ends an ongoing snooze.
+	*/
+	Q_INVOKABLE void snoozeAlert(BGAlertEvaluator::Alert alert, int minutes);
+
 signals:
 	/*!
 		\fn BGDataReceiver::newDataReceived()
@@ -457,6 +680,33 @@ signals:
 	void carbsOnBoardChanged();
 	void lastLoopRunTimestampChanged();
 	void basalRateChanged();
+	void forecastHorizonChanged();
+	void bgForecastChanged();
+	void bgForecastTimeSeriesChanged();
+	void percentileBandsChanged();
+
+	void lowAlertThresholdChanged();
+	void highAlertThresholdChanged();
+	void alertHysteresisChanged();
+	void fastDropAlertRateChanged();
+	void fastRiseAlertRateChanged();
+	void staleDataAlertTimeoutChanged();
+	void activeAlertsChanged();
+
+	void minutesSinceBgStatusChanged();
+	void minutesSinceLastLoopChanged();
+
+	/*!
+		\fn BGDataReceiver::alertRaised(BGAlertEvaluator::Alert alert)
+		Emitted when an alert changes from the cleared to the raised state.
+	*/
+	void alertRaised(BGAlertEvaluator::Alert alert);
+
+	/*!
+		\fn BGDataReceiver::alertCleared(BGAlertEvaluator::Alert alert)
+		Emitted when an alert changes from the raised to the cleared state.
+	*/
+	void alertCleared(BGAlertEvaluator::Alert alert);
 
 public slots:
 	// This slot is invoked by the DBus ExternalAppMessages adaptor
@@ -464,7 +714,29 @@ public slots:
 	void pushMessage(QString sender, QByteArray payload);
 
 private:
+	// A time series as it was unpacked from the payload, along with its
+	// list of variants for QML. That list is only built when it is read.
+	struct TimeSeries
+	{
+		QPolygonF m_points;
+		mutable QVariantList m_variantList;
+		mutable bool m_variantListIsStale = false;
+
+		void setPoints(QPolygonF points);
+		QVariantList const & variantList() const;
+	};
+
 	void clearAllQuantities();
+	void updatePropertyVariants();
+	void updateForecasts();
+	QVariantList predictBGTimeSeries(int numForecastSteps) const;
+	void addPercentileBandsReading(BGStatus const &bgStatus);
+	void loadPercentileBands();
+	void savePercentileBands();
+	void evaluateAlerts();
+	void updateMinutesSince();
+	template<typename T>
+	bool setAlertSetting(T BGAlertEvaluator::Settings::*setting, T newValue);
 
 	std::optional<Unit> m_unit;
 	std::optional<BGStatus> m_bgStatus;
@@ -472,9 +744,39 @@ private:
 	std::optional<CarbsOnBoard> m_cob;
 	QDateTime m_lastLoopRunTimestamp;
 	std::optional<BasalRate> m_basalRate;
-	QVariantList m_bgTimeSeries;
-	QVariantList m_basalTimeSeries;
-	QVariantList m_baseBasalTimeSeries;
+	TimeSeries m_bgTimeSeries;
+	TimeSeries m_basalTimeSeries;
+	TimeSeries m_baseBasalTimeSeries;
+
+	// QVariant versions of the optional quantities above. QML bindings
+	// may call the property getters many times per change, so these are
+	// built once when the quantities change instead of in every getter
+	// call, since wrapping the gadgets in QVariants allocates memory.
+	QVariant m_unitVariant;
+	QVariant m_bgStatusVariant;
+	QVariant m_iobVariant;
+	QVariant m_cobVariant;
+	QVariant m_basalRateVariant;
+
+	BGForecaster m_bgForecaster;
+	int m_forecastHorizon;
+	QVariantList m_bgForecast;
+	QVariantList m_bgForecastTimeSeries;
+
+	BGPercentileBands m_percentileBandsStatistics;
+	int m_numUnsavedPercentileBandsReadings;
+	QVariantList m_percentileBands;
+
+	BGAlertEvaluator m_alertEvaluator;
+	QTimer m_alertTimer;
+	// Timestamp of the last valid BG reading (or of the creation of the
+	// receiver if there was none yet) for the STALE_DATA alert, in seconds
+	// since the epoch. Unlike m_bgStatus, this is not cleared.
+	qint64 m_lastValidBGTimestamp;
+
+	std::optional<int> m_minutesSinceBgStatus;
+	std::optional<int> m_minutesSinceLastLoop;
+	QTimer m_minutesSinceTimer;
 };
 
 #endif // BGDATARECEIVER_HPP
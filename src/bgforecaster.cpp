@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cmath>
+#include "bgforecaster.hpp"
+
+
+BGForecaster::BGForecaster(double weightTimeConstant, double trendDampingTimeConstant, double maxGap)
+	: m_weightTimeConstant(weightTimeConstant)
+	, m_trendDampingTimeConstant(trendDampingTimeConstant)
+	, m_maxGap(maxGap)
+{
+	reset();
+}
+
+
+void BGForecaster::reset()
+{
+	m_numPoints = 0;
+	m_latestTime = 0.0;
+	m_latestValue = 0.0;
+	m_slope = 0.0;
+
+	m_sumW = 0.0;
+	m_sumWT = 0.0;
+	m_sumWTT = 0.0;
+	m_sumWV = 0.0;
+	m_sumWTV = 0.0;
+}
+
+
+void BGForecaster::addPoint(double time, double value)
+{
+	if (m_numPoints > 0)
+	{
+		double dt = time - m_latestTime;
+
+		if (dt <= 0.0)
+			return;
+
+		if (dt > m_maxGap)
+		{
+			reset();
+		}
+		else
+		{
+			// Move the origin of the sums to the new point's time.
+			// All existing points then have a time that is dt
+			// smaller than before. Note that m_sumWTT has to be
+			// updated before m_sumWT, since it uses the old m_sumWT.
+			m_sumWTT = m_sumWTT - 2.0 * dt * m_sumWT + dt * dt * m_sumW;
+			m_sumWTV = m_sumWTV - dt * m_sumWV;
+			m_sumWT = m_sumWT - dt * m_sumW;
+
+			// Let the existing points lose weight according to their age.
+			double decay = std::exp(-dt / m_weightTimeConstant);
+			m_sumW *= decay;
+			m_sumWT *= decay;
+			m_sumWTT *= decay;
+			m_sumWV *= decay;
+			m_sumWTV *= decay;
+		}
+	}
+
+	// The new point is located at the origin (relative time 0),
+	// so it only contributes to the weight and value sums.
+	m_sumW += 1.0;
+	m_sumWV += value;
+
+	m_latestTime = time;
+	m_latestValue = value;
+	++m_numPoints;
+
+	double denominator = m_sumW * m_sumWTT - m_sumWT * m_sumWT;
+	if ((m_numPoints >= 2) && (denominator > 0.0))
+		m_slope = (m_sumW * m_sumWTV - m_sumWT * m_sumWV) / denominator;
+	else
+		m_slope = 0.0;
+}
+
+
+int BGForecaster::numPoints() const
+{
+	return m_numPoints;
+}
+
+
+double BGForecaster::latestTime() const
+{
+	return m_latestTime;
+}
+
+
+double BGForecaster::latestValue() const
+{
+	return m_latestValue;
+}
+
+
+bool BGForecaster::hasTrend() const
+{
+	return m_numPoints >= 2;
+}
+
+
+double BGForecaster::slope() const
+{
+	return m_slope;
+}
+
+
+double BGForecaster::predict(double time) const
+{
+	double timeAhead = std::max(time - m_latestTime, 0.0);
+
+	// Integrating a slope that decays exponentially with the damping time
+	// constant yields this term. For small timeAhead values, it approaches
+	// timeAhead (undamped), for large ones, it approaches the time constant.
+	double dampedTimeAhead = m_trendDampingTimeConstant * (1.0 - std::exp(-timeAhead / m_trendDampingTimeConstant));
+
+	return m_latestValue + m_slope * dampedTimeAhead;
+}
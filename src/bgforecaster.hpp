@@ -0,0 +1,85 @@
+#ifndef BGFORECASTER_HPP
+#define BGFORECASTER_HPP
+
+
+/*!
+	\class BGForecaster
+	\brief Short-term BG predictor based on a weighted least-squares trend fit.
+
+	Points are added in chronological order with \c addPoint(). The forecaster
+	maintains exponentially decaying least-squares sums, so adding a point is
+	O(1) and no history needs to be stored. Older points lose weight with the
+	\c weightTimeConstant, which makes the fitted slope follow recent changes.
+
+	Predictions start at the most recently added value and continue with the
+	fitted slope. That slope is damped with \c trendDampingTimeConstant, since
+	BG trends do not continue linearly for long. The units of time and value
+	are up to the caller; they only need to be consistent. If the gap between
+	two points is larger than \c maxGap, the old state is discarded, since a
+	trend that is based on data from before such a gap is not meaningful.
+*/
+class BGForecaster
+{
+public:
+	explicit BGForecaster(double weightTimeConstant, double trendDampingTimeConstant, double maxGap);
+
+	void reset();
+
+	/*!
+		\fn BGForecaster::addPoint(double time, double value)
+
+		Adds a point to the fit. If \c time is not newer than the time of
+		the last added point, the point is ignored.
+	*/
+	void addPoint(double time, double value);
+
+	int numPoints() const;
+	double latestTime() const;
+	double latestValue() const;
+
+	/*!
+		\fn BGForecaster::hasTrend() const
+
+		Returns true if at least two points were added since the last reset,
+		which is the minimum needed for computing a slope.
+	*/
+	bool hasTrend() const;
+
+	/*!
+		\fn BGForecaster::slope() const
+
+		Returns the fitted slope, in value units per time unit. If no
+		trend is available (see \c hasTrend()), this returns 0.
+	*/
+	double slope() const;
+
+	/*!
+		\fn BGForecaster::predict(double time) const
+
+		Returns the predicted value at the given time. \c time must not
+		be older than the time of the last added point.
+	*/
+	double predict(double time) const;
+
+private:
+	double m_weightTimeConstant;
+	double m_trendDampingTimeConstant;
+	double m_maxGap;
+
+	int m_numPoints;
+	double m_latestTime;
+	double m_latestValue;
+	double m_slope;
+
+	// Exponentially decayed least-squares sums. The time values in
+	// these sums are relative to m_latestTime, which keeps them
+	// small and thus avoids loss of precision.
+	double m_sumW;
+	double m_sumWT;
+	double m_sumWTT;
+	double m_sumWV;
+	double m_sumWTV;
+};
+
+
+#endif // BGFORECASTER_HPP
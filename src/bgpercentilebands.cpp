@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QDataStream>
+#include "bgpercentilebands.hpp"
+
+
+namespace
+{
+
+
+quint32 const SERIALIZATION_MAGIC = 0x42475042; // "BGPB"
+quint8 const SERIALIZATION_VERSION = 1;
+
+int const MINUTES_PER_DAY = 24 * 60;
+
+
+} // unnamed namespace end
+
+
+BGPercentileBands::BGPercentileBands()
+{
+	clear();
+}
+
+
+void BGPercentileBands::clear()
+{
+	m_daySlots.fill(-1);
+	m_newestDay = -1;
+	m_latestTimestamp = std::numeric_limits<qint64>::min();
+	m_counts.assign(NUM_DAYS * NUM_TIME_BINS * NUM_VALUE_BUCKETS, 0);
+}
+
+
+bool BGPercentileBands::addReading(QDateTime const &timestamp, float bgValue)
+{
+	if (!timestamp.isValid() || std::isnan(bgValue))
+		return false;
+
+	qint64 secsSinceEpoch = timestamp.toSecsSinceEpoch();
+	if (secsSinceEpoch <= m_latestTimestamp)
+		return false;
+
+	QDateTime localTimestamp = timestamp.toLocalTime();
+	qint64 day = localTimestamp.date().toJulianDay();
+
+	// Readings that are too old would land in a slot that
+	// is currently used by a day within the valid range.
+	if ((m_newestDay >= 0) && (day <= (m_newestDay - NUM_DAYS)))
+		return false;
+
+	int daySlot = int(day % NUM_DAYS);
+	if (m_daySlots[daySlot] != day)
+	{
+		// This slot contains an expired day (or is unused).
+		// Reset its histograms before reusing it.
+		auto slotBegin = m_counts.begin() + daySlot * NUM_TIME_BINS * NUM_VALUE_BUCKETS;
+		std::fill(slotBegin, slotBegin + NUM_TIME_BINS * NUM_VALUE_BUCKETS, 0);
+		m_daySlots[daySlot] = day;
+	}
+
+	QTime timeOfDay = localTimestamp.time();
+	int minuteOfDay = timeOfDay.hour() * 60 + timeOfDay.minute();
+	int timeBin = std::min(minuteOfDay * NUM_TIME_BINS / MINUTES_PER_DAY, NUM_TIME_BINS - 1);
+
+	quint8 &count = histogramFor(daySlot, timeBin)[valueBucketFor(bgValue)];
+	// Saturate instead of overflowing. With typical CGM
+	// reading intervals, this limit is never reached.
+	if (count < std::numeric_limits<quint8>::max())
+		++count;
+
+	m_newestDay = std::max(m_newestDay, day);
+	m_latestTimestamp = secsSinceEpoch;
+
+	return true;
+}
+
+
+void BGPercentileBands::computePercentiles(std::vector<float> const &percentiles, std::vector<std::array<float, NUM_TIME_BINS>> &results) const
+{
+	results.resize(percentiles.size());
+
+	for (int timeBin = 0; timeBin < NUM_TIME_BINS; ++timeBin)
+	{
+		// Merge the histograms of all days that are within the valid range.
+
+		std::array<int, NUM_VALUE_BUCKETS> totals;
+		totals.fill(0);
+		int numReadings = 0;
+
+		for (int daySlot = 0; daySlot < NUM_DAYS; ++daySlot)
+		{
+			qint64 day = m_daySlots[daySlot];
+			if ((day < 0) || (day <= (m_newestDay - NUM_DAYS)))
+				continue;
+
+			quint8 const *histogram = histogramFor(daySlot, timeBin);
+			for (int valueBucket = 0; valueBucket < NUM_VALUE_BUCKETS; ++valueBucket)
+			{
+				totals[valueBucket] += histogram[valueBucket];
+				numReadings += histogram[valueBucket];
+			}
+		}
+
+		for (std::size_t percentileIndex = 0; percentileIndex < percentiles.size(); ++percentileIndex)
+		{
+			if (numReadings == 0)
+			{
+				results[percentileIndex][timeBin] = std::numeric_limits<float>::quiet_NaN();
+				continue;
+			}
+
+			// Find the bucket that contains the percentile, then
+			// interpolate linearly within that bucket, assuming
+			// that its readings are evenly distributed.
+
+			float targetCount = percentiles[percentileIndex] * numReadings;
+			int cumulativeCount = 0;
+			int valueBucket = 0;
+
+			for (; valueBucket < (NUM_VALUE_BUCKETS - 1); ++valueBucket)
+			{
+				if ((cumulativeCount + totals[valueBucket]) >= targetCount)
+					break;
+				cumulativeCount += totals[valueBucket];
+			}
+
+			float fraction = (totals[valueBucket] > 0) ? ((targetCount - cumulativeCount) / totals[valueBucket]) : 0.5f;
+			fraction = std::clamp(fraction, 0.0f, 1.0f);
+
+			results[percentileIndex][timeBin] = valueFor(valueBucket + fraction);
+		}
+	}
+}
+
+
+bool BGPercentileBands::isEmpty() const
+{
+	return m_newestDay < 0;
+}
+
+
+QByteArray BGPercentileBands::serialize() const
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setByteOrder(QDataStream::LittleEndian);
+
+	stream << SERIALIZATION_MAGIC << SERIALIZATION_VERSION
+	       << quint16(NUM_DAYS) << quint16(NUM_TIME_BINS) << quint16(NUM_VALUE_BUCKETS)
+	       << m_newestDay << m_latestTimestamp;
+
+	for (qint64 day : m_daySlots)
+		stream << day;
+
+	stream.writeRawData(reinterpret_cast<char const *>(m_counts.data()), int(m_counts.size()));
+
+	return data;
+}
+
+
+bool BGPercentileBands::deserialize(QByteArray const &data)
+{
+	QDataStream stream(data);
+	stream.setByteOrder(QDataStream::LittleEndian);
+
+	quint32 magic;
+	quint8 version;
+	quint16 numDays, numTimeBins, numValueBuckets;
+
+	stream >> magic >> version >> numDays >> numTimeBins >> numValueBuckets;
+
+	// If the layout does not match (for example because the constants
+	// were changed in a newer version), the stored data is discarded.
+	if ((stream.status() != QDataStream::Ok)
+	 || (magic != SERIALIZATION_MAGIC)
+	 || (version != SERIALIZATION_VERSION)
+	 || (numDays != NUM_DAYS)
+	 || (numTimeBins != NUM_TIME_BINS)
+	 || (numValueBuckets != NUM_VALUE_BUCKETS))
+	{
+		return false;
+	}
+
+	qint64 newestDay, latestTimestamp;
+	std::array<qint64, NUM_DAYS> daySlots;
+	std::vector<quint8> counts(NUM_DAYS * NUM_TIME_BINS * NUM_VALUE_BUCKETS);
+
+	stream >> newestDay >> latestTimestamp;
+	for (qint64 &day : daySlots)
+		stream >> day;
+
+	if (stream.readRawData(reinterpret_cast<char *>(counts.data()), int(counts.size())) != int(counts.size()))
+		return false;
+
+	if (stream.status() != QDataStream::Ok)
+		return false;
+
+	m_newestDay = newestDay;
+	m_latestTimestamp = latestTimestamp;
+	m_daySlots = daySlots;
+	m_counts = std::move(counts);
+
+	return true;
+}
+
+
+int BGPercentileBands::valueBucketFor(float bgValue) const
+{
+	float clampedValue = std::clamp(bgValue, MIN_VALUE, MAX_VALUE);
+	float position = std::log(clampedValue / MIN_VALUE) / std::log(MAX_VALUE / MIN_VALUE);
+	return std::min(int(position * NUM_VALUE_BUCKETS), NUM_VALUE_BUCKETS - 1);
+}
+
+
+float BGPercentileBands::valueFor(float fractionalValueBucket) const
+{
+	return MIN_VALUE * std::pow(MAX_VALUE / MIN_VALUE, fractionalValueBucket / NUM_VALUE_BUCKETS);
+}
+
+
+quint8 * BGPercentileBands::histogramFor(int daySlot, int timeBin)
+{
+	return m_counts.data() + (daySlot * NUM_TIME_BINS + timeBin) * NUM_VALUE_BUCKETS;
+}
+
+
+quint8 const * BGPercentileBands::histogramFor(int daySlot, int timeBin) const
+{
+	return m_counts.data() + (daySlot * NUM_TIME_BINS + timeBin) * NUM_VALUE_BUCKETS;
+}
@@ -0,0 +1,86 @@
+#ifndef BGPERCENTILEBANDS_HPP
+#define BGPERCENTILEBANDS_HPP
+
+#include <array>
+#include <vector>
+#include <QByteArray>
+#include <QDateTime>
+
+
+/*!
+	\class BGPercentileBands
+	\brief Bounded-memory statistics for computing BG percentiles by time of day.
+
+	This is used for "typical day" views (also known as Ambulatory Glucose
+	Profile, or AGP). These show percentiles of the BG values of the past
+	days, grouped by time of day.
+
+	Instead of storing all readings, this keeps a histogram per day and
+	per time-of-day bin. The histogram buckets are spaced logarithmically,
+	so the relative resolution is the same for low and high BG values.
+	Keeping the histograms per day makes it possible to let readings
+	that are older than \c NUM_DAYS days expire. The memory usage is
+	fixed, and is NUM_DAYS * NUM_TIME_BINS * NUM_VALUE_BUCKETS bytes.
+
+	BG values are always given in mg/dL.
+*/
+class BGPercentileBands
+{
+public:
+	static int const NUM_DAYS = 14;
+	static int const NUM_TIME_BINS = 48;
+	static int const NUM_VALUE_BUCKETS = 64;
+
+	// BG range covered by the histograms, in mg/dL. Values outside
+	// of this range are clamped to the first or last bucket.
+	static constexpr float MIN_VALUE = 40.0f;
+	static constexpr float MAX_VALUE = 400.0f;
+
+	BGPercentileBands();
+
+	void clear();
+
+	/*!
+		\fn BGPercentileBands::addReading(QDateTime const &timestamp, float bgValue)
+
+		Adds a BG reading to the statistics. The time of day is taken
+		from the local time of \c timestamp. Readings that are not newer
+		than the latest added reading are ignored, as are readings that
+		are older than \c NUM_DAYS days relative to the newest day.
+
+		Returns true if the reading was added.
+	*/
+	bool addReading(QDateTime const &timestamp, float bgValue);
+
+	/*!
+		\fn BGPercentileBands::computePercentiles(std::vector<float> const &percentiles, std::vector<std::array<float, NUM_TIME_BINS>> &results) const
+
+		Computes the given percentiles (in the 0-1 range) for each time bin.
+		\c results is resized to the number of percentiles. Each of its items
+		contains the BG values (in mg/dL) of the corresponding percentile.
+		Time bins that contain no readings are set to NaN.
+	*/
+	void computePercentiles(std::vector<float> const &percentiles, std::vector<std::array<float, NUM_TIME_BINS>> &results) const;
+
+	bool isEmpty() const;
+
+	QByteArray serialize() const;
+	bool deserialize(QByteArray const &data);
+
+private:
+	int valueBucketFor(float bgValue) const;
+	float valueFor(float fractionalValueBucket) const;
+	quint8 * histogramFor(int daySlot, int timeBin);
+	quint8 const * histogramFor(int daySlot, int timeBin) const;
+
+	// The histograms of the days are organized as a ring buffer.
+	// m_daySlots contains the julian day number of the day that is
+	// stored in each slot, or -1 if that slot is unused.
+	std::array<qint64, NUM_DAYS> m_daySlots;
+	qint64 m_newestDay;
+	qint64 m_latestTimestamp;
+	std::vector<quint8> m_counts;
+};
+
+
+#endif // BGPERCENTILEBANDS_HPP
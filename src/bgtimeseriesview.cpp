@@ -1,4 +1,12 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <utility>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QLoggingCategory>
 #include <QImage>
 #include <QSGFlatColorMaterial>
@@ -7,137 +15,381 @@
 #include <QQuickWindow>
 #include <QSGGeometry>
 #include <QSGGeometryNode>
+#include <QSGRendererInterface>
+#include <QSGSimpleTextureNode>
+#include <QSGVertexColorMaterial>
 #include "bgtimeseriesview.hpp"
+#include "graphrasterizer.hpp"
+#include "linetessellator.hpp"
+#include "monotonespline.hpp"
+#include "scenegraphhelpers.hpp"
+#include "timeseriesmaterial.hpp"
 
 
 Q_DECLARE_LOGGING_CATEGORY(lcQmlBgData)
+Q_DECLARE_LOGGING_CATEGORY(lcQmlBgDataTiming)
 
 
 namespace
 {
 
 
-void simplifyTimeSeries(QVariantList const &sourceSeries, std::vector<QPointF> &destSeries, int minBucketWidth, int viewWidth)
+// Length of the dashes and of the gaps between them, in pixels.
+// These are used for drawing the BG forecast.
+double const DASH_LENGTH = 4.0;
+double const DASH_GAP_LENGTH = 3.0;
+
+int const NUM_PERCENTILE_BANDS = 5;
+
+// Opacities of the percentile envelopes, relative to the opacity of
+// the view's color, and the thickness of the median line, in pixels.
+float const OUTER_PERCENTILE_ENVELOPE_OPACITY = 0.25f;
+float const INNER_PERCENTILE_ENVELOPE_OPACITY = 0.5f;
+float const MEDIAN_LINE_THICKNESS = 1.0f;
+
+int const DEFAULT_MIN_BUCKET_WIDTH = 3;
+
+float const DEFAULT_SMOOTHING_TOLERANCE = 0.25f;
+
+// Smallest visible time window that zoom() allows, as a normalized
+// timestamp range. This corresponds to about 8 raw timestamp units.
+double const MIN_VISIBLE_WINDOW_LENGTH = 8.0 / 32767.0;
+
+// The highlight marker is a polygon with this many corners. Its radius is
+// twice the line width, but at least MIN_HIGHLIGHT_MARKER_RADIUS pixels.
+int const NUM_HIGHLIGHT_MARKER_SEGMENTS = 16;
+float const MIN_HIGHLIGHT_MARKER_RADIUS = 3.0f;
+
+// In ambient mode, the buckets are this many times wider than
+// minBucketWidth, which reduces the number of graph vertices.
+int const AMBIENT_BUCKET_WIDTH_FACTOR = 4;
+
+// If the series has gaps, the number of buckets of its last part is kept
+// as long as it deviates by at most this fraction from the number that
+// the part's length calls for. New readings extend the last part, and
+// changing its number of buckets would reset the incremental LTTB state.
+double const MAX_LAST_PART_BUCKET_COUNT_DEVIATION = 0.1;
+
+
+void generateDashedLineVertices(QVariantList const &series, std::vector<QSGGeometry::Point2D> &dashVertices, double xStart, double xScale, double yScale)
+{
+	// The geometry is drawn with DrawLines, so each dash is
+	// made of 2 vertices: the start and end of the dash.
+
+	dashVertices.clear();
+
+	// Position within the current dash+gap period. This is carried
+	// over between line segments so the dash pattern continues
+	// seamlessly across the points of the series.
+	double patternPosition = 0.0;
+
+	for (int pointIndex = 1; pointIndex < series.size(); ++pointIndex)
+	{
+		QPointF previousPoint = series[pointIndex - 1].toPointF();
+		QPointF currentPoint = series[pointIndex].toPointF();
+
+		QPointF lineStart((previousPoint.x() - xStart) * xScale, (1.0 - previousPoint.y()) * yScale);
+		QPointF lineEnd((currentPoint.x() - xStart) * xScale, (1.0 - currentPoint.y()) * yScale);
+		QPointF lineDirection = lineEnd - lineStart;
+
+		double lineLength = std::hypot(lineDirection.x(), lineDirection.y());
+		if (lineLength <= 0.0)
+			continue;
+
+		double linePosition = 0.0;
+		while (linePosition < lineLength)
+		{
+			if (patternPosition < DASH_LENGTH)
+			{
+				double dashEnd = std::min(lineLength, linePosition + (DASH_LENGTH - patternPosition));
+				QPointF dashStart = lineStart + lineDirection * (linePosition / lineLength);
+				QPointF dashStop = lineStart + lineDirection * (dashEnd / lineLength);
+				dashVertices.push_back({ float(dashStart.x()), float(dashStart.y()) });
+				dashVertices.push_back({ float(dashStop.x()), float(dashStop.y()) });
+				patternPosition += dashEnd - linePosition;
+				linePosition = dashEnd;
+			}
+			else
+			{
+				double gapEnd = std::min(lineLength, linePosition + (DASH_LENGTH + DASH_GAP_LENGTH - patternPosition));
+				patternPosition += gapEnd - linePosition;
+				linePosition = gapEnd;
+			}
+
+			if (patternPosition >= (DASH_LENGTH + DASH_GAP_LENGTH))
+				patternPosition = 0.0;
+		}
+	}
+}
+
+
+void generatePercentileBandsVertices(QVariantList const &percentileBands, QColor const &color, std::vector<QSGGeometry::ColoredPoint2D> &stripVertices, double xScale, double yScale)
 {
-	// This implements Sveinn Steinarsson’s Largest-Triangle-Three-Buckets (LTTB) algorithm
-	// for downsampling time series data. Source: https://github.com/sveinn-steinarsson/flot-downsample
-	// The MSc thesis with a description of LTTB is found at: http://hdl.handle.net/1946/15343
-	//
-	// The number of buckets is chosen based on the width of the QML item and the
-	// desired minimum bucket with in pixels.
-	// TODO: Currently, the "dynamic" variant of LTTB is not implemented. It could yield
-	// better visual results and is worth investigating.
+	// All percentile envelopes are put into one triangle strip, so they
+	// can be drawn in one draw call. The envelopes are connected with
+	// degenerate triangles (that is, triangles with zero area). Each
+	// envelope gets its own opacity through the vertex colors.
+
+	stripVertices.clear();
 
-	// Calculate the number of buckets by rounding the viewWidth/minBucketWidth result.
-	int numBuckets = ((viewWidth + (minBucketWidth -1)) / minBucketWidth);
+	if (percentileBands.empty())
+		return;
 
-	// Check for the special case where the view width is large enough to accomodate
-	// for all source series data points. If so, then just return all source points.
-	if (numBuckets > sourceSeries.size())
+	if (percentileBands.size() != NUM_PERCENTILE_BANDS)
 	{
-		destSeries.resize(sourceSeries.size());
-		for (int i = 0; i < sourceSeries.size(); ++i)
-			destSeries[i] = sourceSeries[i].toPointF();
+		qCWarning(lcQmlBgData) << "Expected" << NUM_PERCENTILE_BANDS << "percentile bands, got" << percentileBands.size();
 		return;
 	}
 
-	struct Bucket
+	std::array<QVariantList, NUM_PERCENTILE_BANDS> bands;
+	for (int bandIndex = 0; bandIndex < NUM_PERCENTILE_BANDS; ++bandIndex)
+	{
+		bands[bandIndex] = percentileBands[bandIndex].toList();
+		if (bands[bandIndex].size() != bands[0].size())
+		{
+			qCWarning(lcQmlBgData) << "Percentile bands have mismatching numbers of points";
+			return;
+		}
+	}
+
+	struct Envelope
 	{
-		std::vector<QPointF> m_points;
-		int m_selectedPointIndex;
+		int m_lowerBandIndex;
+		int m_upperBandIndex;
+		float m_opacity;
+		float m_minThickness;
 	};
 
-	std::vector<Bucket> buckets;
+	// The outermost envelope (5th to 95th percentile) comes first, then
+	// the 25th to 75th percentile envelope. The median is drawn as a thin
+	// envelope whose lower and upper bounds are the same band.
+	Envelope const envelopes[] = {
+		{ 0, 4, OUTER_PERCENTILE_ENVELOPE_OPACITY, 0.0f },
+		{ 1, 3, INNER_PERCENTILE_ENVELOPE_OPACITY, 0.0f },
+		{ 2, 2, 1.0f, MEDIAN_LINE_THICKNESS }
+	};
 
-	// Step 1: Initialize the buckets and assign each source series
-	// point to an appropriate bucket. As per the definiton of LTTB,
-	// the first and last source data points are placed in the first
-	// and last buckets, respectively. Those buckets only contain
-	// those single points. The remaining source series data points
-	// are assigned to the remaining buckets based on the index
-	// of the source data point in the source series to produce
-	// buckets with approximately the same number of points in them.
+	int numPoints = bands[0].size();
+	stripVertices.reserve(std::size(envelopes) * (numPoints * 2 + 2));
 
-	buckets.resize(numBuckets);
+	for (Envelope const &envelope : envelopes)
+	{
+		// The scene graph expects vertex colors to be premultiplied.
+		float alpha = color.alphaF() * envelope.m_opacity;
+		uchar r = uchar(color.redF() * alpha * 255.0f);
+		uchar g = uchar(color.greenF() * alpha * 255.0f);
+		uchar b = uchar(color.blueF() * alpha * 255.0f);
+		uchar a = uchar(alpha * 255.0f);
+
+		for (int pointIndex = 0; pointIndex < numPoints; ++pointIndex)
+		{
+			QPointF lowerPoint = bands[envelope.m_lowerBandIndex][pointIndex].toPointF();
+			QPointF upperPoint = bands[envelope.m_upperBandIndex][pointIndex].toPointF();
 
-	buckets.front().m_points.push_back(sourceSeries.front().toPointF());
-	buckets.back().m_points.push_back(sourceSeries.back().toPointF());
+			float x = lowerPoint.x() * xScale;
+			float lowerY = (1.0 - lowerPoint.y()) * yScale;
+			float upperY = (1.0 - upperPoint.y()) * yScale;
 
-	// For each bucket, one of its points becomes "selected" (more
-	// on that below). In the first and last buckets, since there is
-	// exactly one point, only that single point can be the selected
-	// point of those buckets.
-	buckets.front().m_selectedPointIndex = 0;
-	buckets.back().m_selectedPointIndex = 0;
+			// Widen envelopes that are thinner than their minimum thickness.
+			float missingThickness = std::max(envelope.m_minThickness - (lowerY - upperY), 0.0f);
+			lowerY += missingThickness * 0.5f;
+			upperY -= missingThickness * 0.5f;
 
-	for (int sourcePointIndex = 1; sourcePointIndex < (sourceSeries.size() - 1); ++sourcePointIndex)
-	{
-		QPointF sourcePoint = sourceSeries[sourcePointIndex].toPointF();
-		int bucketIndex = (sourcePointIndex - 1) * (numBuckets - 2) / (sourceSeries.size() - 2) + 1;
+			QSGGeometry::ColoredPoint2D upperVertex, lowerVertex;
+			upperVertex.set(x, upperY, r, g, b, a);
+			lowerVertex.set(x, lowerY, r, g, b, a);
 
-		buckets[bucketIndex].m_points.push_back(sourcePoint);
+			if ((pointIndex == 0) && !stripVertices.empty())
+			{
+				// Connect to the previous envelope with degenerate triangles.
+				stripVertices.push_back(stripVertices.back());
+				stripVertices.push_back(upperVertex);
+			}
+
+			stripVertices.push_back(upperVertex);
+			stripVertices.push_back(lowerVertex);
+		}
 	}
+}
+
 
-	// Step 2: Rank the points in each bucket by going over each of
-	// them and calculating the are of the triangle that is described
-	// by the previous bucket's selected point, the current point
-	// that is being evaluated, and the average of all of the next
-	// bucket's points. The current bucket's point with the largest
-	// triangle area gets the highest rank and thus "wins", becoming
-	// the bucket's selected point.
+// Colors of the graph depending on which side of the thresholds it
+// is on. The thresholds are given as y coordinates in pixels, so
+// larger values are lower values.
+struct ThresholdColoring
+{
+	double m_lowThresholdY;
+	double m_highThresholdY;
+	QColor m_lowColor;
+	QColor m_normalColor;
+	QColor m_highColor;
 
-	for (int bucketIndex = 1; bucketIndex < (numBuckets - 1); ++bucketIndex)
+	QColor const & colorAt(double y) const
 	{
-		Bucket const &previousBucket = buckets[bucketIndex - 1];
-		Bucket &currentBucket = buckets[bucketIndex];
-		Bucket const &nextBucket = buckets[bucketIndex + 1];
+		if (y > m_lowThresholdY)
+			return m_lowColor;
+		else if (y < m_highThresholdY)
+			return m_highColor;
+		else
+			return m_normalColor;
+	}
+};
 
-		QPointF const &prevSelectedPoint = previousBucket.m_points[previousBucket.m_selectedPointIndex];
 
-		QPointF nextAveragePoint(0.0f, 0.0f);
-		for (auto const &nextBucketPoint : nextBucket.m_points)
-			nextAveragePoint += nextBucketPoint;
-		nextAveragePoint /= nextBucket.m_points.size();
+// Appends the given polyline to the tessellated triangle strip. Segments
+// that cross a threshold are split exactly at the crossing, so the color
+// changes right where the line crosses the threshold.
+void appendThresholdColoredPolyline(QPointF const *points, int numPoints, float lineWidth, ThresholdColoring const &coloring, std::vector<QPointF> &splitPoints, std::vector<QColor> &segmentColors, std::vector<QSGGeometry::ColoredPoint2D> &vertices)
+{
+	splitPoints.clear();
+	segmentColors.clear();
 
-		float currentBestRank = 0;
-		int currentBestPointIndex = 0;
+	if (numPoints < 2)
+		return;
 
-		float x1 = prevSelectedPoint.x();
-		float y1 = prevSelectedPoint.y();
-		float x3 = nextAveragePoint.x();
-		float y3 = nextAveragePoint.y();
+	splitPoints.push_back(points[0]);
 
-		for (std::size_t bucketPointIndex = 0; bucketPointIndex < currentBucket.m_points.size(); ++bucketPointIndex)
+	for (int pointIndex = 1; pointIndex < numPoints; ++pointIndex)
+	{
+		QPointF const &segmentStart = points[pointIndex - 1];
+		QPointF const &segmentEnd = points[pointIndex];
+		QPointF segmentDelta = segmentEnd - segmentStart;
+
+		// Find the positions along the segment where it crosses the thresholds.
+		double crossings[2];
+		int numCrossings = 0;
+		for (double thresholdY : { coloring.m_lowThresholdY, coloring.m_highThresholdY })
 		{
-			float x2 = currentBucket.m_points[bucketPointIndex].x();
-			float y2 = currentBucket.m_points[bucketPointIndex].y();
-
-			// The correct triangle area formulat is:
-			//
-			//   (x1 * (y2 - y3) + x2 * (y3 - y1) + x3 * (y1 - y2)) * 0.5
-			//
-			// However, since we only need the area values for comparison purposes
-			// to find the "best" point, we omit the "* 0.5" as a small optimization,
-			// hence getting the "doubleTriangleArea" instead.
-			float doubleTriangleArea = (x1 * (y2 - y3) + x2 * (y3 - y1) + x3 * (y1 - y2));
-
-			if (doubleTriangleArea > currentBestRank)
-			{
-				currentBestRank = doubleTriangleArea;
-				currentBestPointIndex = bucketPointIndex;
-			}
+			if (((segmentStart.y() - thresholdY) * (segmentEnd.y() - thresholdY)) < 0.0)
+				crossings[numCrossings++] = (thresholdY - segmentStart.y()) / segmentDelta.y();
+		}
+		if ((numCrossings == 2) && (crossings[0] > crossings[1]))
+			std::swap(crossings[0], crossings[1]);
+
+		// Each part of the segment gets the color of its midpoint, since
+		// its endpoints may lie exactly on a threshold.
+		double partStart = 0.0;
+		for (int crossingIndex = 0; crossingIndex <= numCrossings; ++crossingIndex)
+		{
+			double partEnd = (crossingIndex < numCrossings) ? crossings[crossingIndex] : 1.0;
+			double partMidY = segmentStart.y() + segmentDelta.y() * (partStart + partEnd) * 0.5;
+
+			splitPoints.push_back(segmentStart + segmentDelta * partEnd);
+			segmentColors.push_back(coloring.colorAt(partMidY));
+
+			partStart = partEnd;
 		}
+	}
+
+	appendThickPolyline(splitPoints.data(), splitPoints.size(), lineWidth, segmentColors.data(), vertices);
+}
+
+
+// Calls func(partBegin, partEnd) for each part of a series with numPoints
+// points that is split at the given gaps. gapIndices contains the indices
+// of the points that follow a gap, in ascending order.
+template<typename Func>
+void forEachSeriesPart(int numPoints, std::vector<int> const &gapIndices, Func const &func)
+{
+	int partBegin = 0;
+	for (int gapIndex : gapIndices)
+	{
+		func(partBegin, gapIndex);
+		partBegin = gapIndex;
+	}
+	func(partBegin, numPoints);
+}
+
+
+void generateTessellatedGraphVertices(std::vector<QPointF> const &graphPoints, std::vector<int> const &graphGapIndices, std::vector<QSGGeometry::Point2D> const &dashVertices, float lineWidth, ThresholdColoring const &coloring, QColor const &targetRangeColor, float width, std::vector<QPointF> &splitPoints, std::vector<QColor> &segmentColors, std::vector<QSGGeometry::ColoredPoint2D> &stripVertices)
+{
+	// The target range band, the graph and the forecast dashes all go
+	// into one triangle strip, so they are drawn with one draw call.
+	// The band comes first, so it is drawn below the lines. Enough
+	// space is reserved up front so that the tessellation never has
+	// to reallocate. Splitting a segment at the thresholds adds at
+	// most 2 points to it. The parts of the graph between gaps are
+	// separate polylines in the same strip.
+
+	int numDashes = dashVertices.size() / 2;
+	int maxNumGraphVertices = 0;
+	forEachSeriesPart(graphPoints.size(), graphGapIndices, [&](int partBegin, int partEnd) {
+		maxNumGraphVertices += maxThickPolylineVertexCount(std::max((partEnd - partBegin) * 3 - 2, 0));
+	});
+
+	stripVertices.clear();
+	stripVertices.reserve(4 + maxNumGraphVertices + numDashes * maxThickPolylineVertexCount(4));
+
+	if ((targetRangeColor.alpha() > 0) && (coloring.m_lowThresholdY > coloring.m_highThresholdY))
+	{
+		// The scene graph expects vertex colors to be premultiplied.
+		float alpha = targetRangeColor.alphaF();
+		uchar r = uchar(targetRangeColor.redF() * alpha * 255.0f);
+		uchar g = uchar(targetRangeColor.greenF() * alpha * 255.0f);
+		uchar b = uchar(targetRangeColor.blueF() * alpha * 255.0f);
+		uchar a = uchar(alpha * 255.0f);
+
+		QSGGeometry::ColoredPoint2D bandVertices[4];
+		bandVertices[0].set(0.0f, coloring.m_highThresholdY, r, g, b, a);
+		bandVertices[1].set(0.0f, coloring.m_lowThresholdY, r, g, b, a);
+		bandVertices[2].set(width, coloring.m_highThresholdY, r, g, b, a);
+		bandVertices[3].set(width, coloring.m_lowThresholdY, r, g, b, a);
+		stripVertices.insert(stripVertices.end(), std::begin(bandVertices), std::end(bandVertices));
+	}
+
+	forEachSeriesPart(graphPoints.size(), graphGapIndices, [&](int partBegin, int partEnd) {
+		appendThresholdColoredPolyline(graphPoints.data() + partBegin, partEnd - partBegin, lineWidth, coloring, splitPoints, segmentColors, stripVertices);
+	});
+
+	for (int dashIndex = 0; dashIndex < numDashes; ++dashIndex)
+	{
+		QSGGeometry::Point2D const *dash = &(dashVertices[dashIndex * 2]);
+		QPointF const dashPoints[2] = {
+			QPointF(dash[0].x, dash[0].y),
+			QPointF(dash[1].x, dash[1].y)
+		};
+		appendThresholdColoredPolyline(dashPoints, 2, lineWidth, coloring, splitPoints, segmentColors, stripVertices);
+	}
+}
+
+
+// Appends the vertices of a triangle strip to another triangle strip.
+// The two are connected with degenerate triangles.
+void appendTriangleStrip(std::vector<QSGGeometry::ColoredPoint2D> const &vertices, std::vector<QSGGeometry::ColoredPoint2D> &stripVertices)
+{
+	if (vertices.empty())
+		return;
 
-		currentBucket.m_selectedPointIndex = currentBestPointIndex;
+	if (!stripVertices.empty())
+	{
+		stripVertices.push_back(stripVertices.back());
+		stripVertices.push_back(vertices.front());
 	}
 
-	// Step 3: Produce a new time series out of the selected points of each bucket.
+	stripVertices.insert(stripVertices.end(), vertices.begin(), vertices.end());
+}
+
+
+void generateHighlightMarkerVertices(QPointF const &center, float radius, QColor const &color, std::vector<QSGGeometry::ColoredPoint2D> &stripVertices)
+{
+	// The disc is a triangle strip, so it can be part of the vertex color
+	// strip. It zig-zags between both sides of the disc, going through the
+	// corners in this order: 0, 1, n-1, 2, n-2, ...
+
+	// The scene graph expects vertex colors to be premultiplied.
+	float alpha = color.alphaF();
+	uchar r = uchar(color.redF() * alpha * 255.0f);
+	uchar g = uchar(color.greenF() * alpha * 255.0f);
+	uchar b = uchar(color.blueF() * alpha * 255.0f);
+	uchar a = uchar(alpha * 255.0f);
 
-	destSeries.resize(numBuckets);
-	for (int bucketIndex = 0; bucketIndex < numBuckets; ++bucketIndex)
+	stripVertices.resize(NUM_HIGHLIGHT_MARKER_SEGMENTS);
+
+	for (int vertexIndex = 0; vertexIndex < NUM_HIGHLIGHT_MARKER_SEGMENTS; ++vertexIndex)
 	{
-		Bucket const &bucket = buckets[bucketIndex];
-		destSeries[bucketIndex] = bucket.m_points[bucket.m_selectedPointIndex];
+		int cornerIndex = ((vertexIndex % 2) == 1) ? ((vertexIndex + 1) / 2) : ((NUM_HIGHLIGHT_MARKER_SEGMENTS - vertexIndex / 2) % NUM_HIGHLIGHT_MARKER_SEGMENTS);
+		double angle = 2.0 * M_PI * cornerIndex / NUM_HIGHLIGHT_MARKER_SEGMENTS;
+		stripVertices[vertexIndex].set(center.x() + std::cos(angle) * radius, center.y() + std::sin(angle) * radius, r, g, b, a);
 	}
 }
 
@@ -145,35 +397,277 @@ void simplifyTimeSeries(QVariantList const &sourceSeries, std::vector<QPointF> &
 } // unnamed namespace end
 
 
+// Everything the render thread needs to update the QSG nodes. Instances
+// are immutable once published. Parts that did not change are shared
+// between consecutive instances, so the render thread can tell which
+// parts it has to upload by comparing the pointers.
+struct BGTimeSeriesRenderData
+{
+	template<typename Vertex>
+	using Vertices = std::shared_ptr<std::vector<Vertex> const>;
+
+	QColor m_color;
+	float m_lineWidth;
+	// The graph vertices are raw int16 timestamp/value pairs. These
+	// are the uniforms that map them to item coordinates.
+	QSizeF m_graphItemSize;
+	float m_graphTimeWindowStart;
+	float m_graphTimeWindowEnd;
+	float m_graphValueRangeMinimum;
+	float m_graphValueRangeMaximum;
+	// The graph vertices form a ring of line segments (see
+	// TimeSeriesVertexRing). m_graphGeneration is incremented every
+	// time they change. If they only changed partially compared to the
+	// previous generation, m_graphDirtyVertexRanges lists the changed
+	// vertices. Otherwise, it is null.
+	int m_graphTimeOffset;
+	unsigned int m_graphGeneration;
+	Vertices<TimeSeriesMaterial::Vertex> m_graphVertices;
+	std::shared_ptr<std::vector<TimeSeriesVertexRing::VertexRange> const> m_graphDirtyVertexRanges;
+	Vertices<QSGGeometry::Point2D> m_forecastVertices;
+	// Percentile bands, target range band, graph, forecast and highlight
+	// marker as one triangle strip with vertex colors, in pixel coordinates,
+	// so they are all drawn with one draw call. The graph and the forecast are
+	// only tessellated into this strip instead of using the vertices
+	// above if the lines are wider than 1 pixel, or if threshold colors
+	// or the target range band are used.
+	Vertices<QSGGeometry::ColoredPoint2D> m_stripVertices;
+	// The simplified graph in pixel coordinates, for drawing it as a
+	// hairline into the cached image below. Only set if the graph
+	// is drawn from that image and is not tessellated. The gap indices
+	// are set together with the points.
+	Vertices<QPointF> m_hairlineGraphPoints;
+	Vertices<int> m_hairlineGraphGapIndices;
+	// If set, all of the above was rasterized into this image, which is
+	// then drawn as a texture instead of the vertices. Its size is the
+	// item size times the device pixel ratio.
+	std::shared_ptr<QImage const> m_cachedImage;
+};
+
+
+namespace
+{
+
+
+// Root node of the view. Its child nodes are drawn in order,
+// so the percentile bands are drawn below the graph.
+class BGTimeSeriesNode
+	: public QSGNode
+{
+public:
+	BGTimeSeriesNode()
+	{
+		// Tessellated lines are made of triangles, so they do not
+		// depend on the line widths that the GPU supports.
+		m_stripNode = createGeometryNode(new QSGVertexColorMaterial, QSGGeometry::defaultAttributes_ColoredPoint2D(), QSGGeometry::DrawTriangleStrip, 1.0f);
+		appendChildNode(m_stripNode);
+
+		// The graph is updated partially most of the time. The DynamicPattern
+		// hint tells the renderer to keep its vertices in a buffer object
+		// that is meant to be updated frequently.
+		m_graphNode = createGeometryNode(new TimeSeriesMaterial, TimeSeriesMaterial::attributes(), QSGGeometry::DrawLines, 1.0f);
+		m_graphNode->geometry()->setVertexDataPattern(QSGGeometry::DynamicPattern);
+		appendChildNode(m_graphNode);
+
+		// The forecast is drawn by a separate node, since it
+		// uses dashed lines instead of a line strip.
+		m_forecastNode = createGeometryNode(new QSGFlatColorMaterial, QSGGeometry::defaultAttributes_Point2D(), QSGGeometry::DrawLines, 1.0f);
+		appendChildNode(m_forecastNode);
+	}
+
+	void setRenderData(std::shared_ptr<BGTimeSeriesRenderData const> renderData)
+	{
+		BGTimeSeriesRenderData const *previous = m_renderData.get();
+
+		TimeSeriesMaterial *graphMaterial = static_cast<TimeSeriesMaterial *>(m_graphNode->material());
+
+		if ((previous == nullptr) || (previous->m_color != renderData->m_color))
+		{
+			graphMaterial->setColor(renderData->m_color);
+			static_cast<QSGFlatColorMaterial *>(m_forecastNode->material())->setColor(renderData->m_color);
+			m_graphNode->markDirty(QSGNode::DirtyMaterial);
+			m_forecastNode->markDirty(QSGNode::DirtyMaterial);
+		}
+
+		if ((previous == nullptr) || (previous->m_lineWidth != renderData->m_lineWidth))
+		{
+			m_graphNode->geometry()->setLineWidth(renderData->m_lineWidth);
+			m_forecastNode->geometry()->setLineWidth(renderData->m_lineWidth);
+			m_graphNode->markDirty(QSGNode::DirtyGeometry);
+			m_forecastNode->markDirty(QSGNode::DirtyGeometry);
+		}
+
+		if ((previous == nullptr)
+		 || (previous->m_graphItemSize != renderData->m_graphItemSize)
+		 || (previous->m_graphTimeWindowStart != renderData->m_graphTimeWindowStart)
+		 || (previous->m_graphTimeWindowEnd != renderData->m_graphTimeWindowEnd)
+		 || (previous->m_graphValueRangeMinimum != renderData->m_graphValueRangeMinimum)
+		 || (previous->m_graphValueRangeMaximum != renderData->m_graphValueRangeMaximum)
+		 || (previous->m_graphTimeOffset != renderData->m_graphTimeOffset))
+		{
+			graphMaterial->setItemSize(renderData->m_graphItemSize);
+			graphMaterial->setTimeWindow(renderData->m_graphTimeWindowStart, renderData->m_graphTimeWindowEnd);
+			graphMaterial->setValueRange(renderData->m_graphValueRangeMinimum, renderData->m_graphValueRangeMaximum);
+			graphMaterial->setTimeOffset(renderData->m_graphTimeOffset);
+			m_graphNode->markDirty(QSGNode::DirtyMaterial);
+		}
+
+		// The vertex ring reuses its buffers, so the
+		// generation is compared instead of the pointers.
+		if ((previous == nullptr) || (previous->m_graphGeneration != renderData->m_graphGeneration))
+			uploadGraphVertices(*renderData);
+
+		if ((previous == nullptr) || (previous->m_forecastVertices != renderData->m_forecastVertices))
+			uploadVertices(*(renderData->m_forecastVertices), m_forecastNode);
+
+		if ((previous == nullptr) || (previous->m_stripVertices != renderData->m_stripVertices))
+			uploadVertices(*(renderData->m_stripVertices), m_stripNode);
+
+		m_renderData = std::move(renderData);
+	}
+
+private:
+	void uploadGraphVertices(BGTimeSeriesRenderData const &renderData)
+	{
+		std::vector<TimeSeriesMaterial::Vertex> const &vertices = *(renderData.m_graphVertices);
+		QSGGeometry *geometry = m_graphNode->geometry();
+
+		// Only the changed vertices need to be copied if the geometry
+		// contains the generation that the changes are based on. This is
+		// not the case if the GUI thread published several generations
+		// in between two calls.
+		bool canCopyPartially = (renderData.m_graphDirtyVertexRanges != nullptr)
+		                     && (renderData.m_graphGeneration == (m_uploadedGraphGeneration + 1))
+		                     && (geometry->vertexCount() == int(vertices.size()));
+
+		if (canCopyPartially)
+		{
+			TimeSeriesMaterial::Vertex *destVertices = static_cast<TimeSeriesMaterial::Vertex *>(geometry->vertexData());
+			for (TimeSeriesVertexRing::VertexRange const &range : *(renderData.m_graphDirtyVertexRanges))
+				std::copy(vertices.begin() + range.m_begin, vertices.begin() + range.m_end, destVertices + range.m_begin);
+
+			geometry->markVertexDataDirty();
+			m_graphNode->markDirty(QSGNode::DirtyGeometry);
+		}
+		else
+		{
+			uploadVertices(vertices, m_graphNode);
+		}
+
+		m_uploadedGraphGeneration = renderData.m_graphGeneration;
+	}
+
+	QSGGeometryNode *m_stripNode;
+	QSGGeometryNode *m_graphNode;
+	QSGGeometryNode *m_forecastNode;
+	unsigned int m_uploadedGraphGeneration = 0;
+
+	std::shared_ptr<BGTimeSeriesRenderData const> m_renderData;
+};
+
+
+// Root node of the view when the graph is drawn from a cached image.
+// A new texture is only created when the image changes.
+class BGTimeSeriesTextureNode
+	: public QSGSimpleTextureNode
+{
+public:
+	BGTimeSeriesTextureNode()
+	{
+		setOwnsTexture(true);
+	}
+
+	void setRenderData(std::shared_ptr<BGTimeSeriesRenderData const> renderData, QQuickWindow *window)
+	{
+		if ((m_renderData == nullptr) || (m_renderData->m_cachedImage != renderData->m_cachedImage))
+		{
+			QImage const &image = *(renderData->m_cachedImage);
+			setTexture(window->createTextureFromImage(image, QQuickWindow::TextureHasAlphaChannel));
+			setRect(0, 0, image.width() / image.devicePixelRatio(), image.height() / image.devicePixelRatio());
+		}
+
+		m_renderData = std::move(renderData);
+	}
+
+private:
+	std::shared_ptr<BGTimeSeriesRenderData const> m_renderData;
+};
+
+
+} // unnamed namespace end
+
+
 BGTimeSeriesView::BGTimeSeriesView(QQuickItem *parent)
 	: QQuickItem(parent)
 	, m_color(Qt::black)
 	, m_lineWidth(1.0f)
-	, m_mustUpdateMaterial(false)
-	, m_mustRecreateNodeGeometry(false)
+	, m_simplificationMode(SimplificationMode::LTTB)
+	, m_minBucketWidth(DEFAULT_MIN_BUCKET_WIDTH)
+	, m_smoothing(false)
+	, m_smoothingTolerance(DEFAULT_SMOOTHING_TOLERANCE)
+	, m_gapThreshold(0.0f)
+	, m_lowThreshold(0.0f)
+	, m_highThreshold(1.0f)
+	, m_targetRangeColor(Qt::transparent)
+	, m_visibleStart(0.0f)
+	, m_visibleEnd(1.0f)
+	, m_highlightedIndex(-1)
+	, m_cached(false)
+	, m_ambient(false)
+	, m_mustSimplifyBGTimeSeries(false)
+	, m_numSimplificationBuckets(0)
+	, m_numLastPartBuckets(0)
+	, m_simplifiedLevel(-1)
+	, m_simplifiedSliceBegin(0)
+	, m_simplifiedSliceEnd(0)
+	, m_mustUpdateGraphLayout(false)
+	, m_mustUpdateGraphStyle(false)
+	, m_graphUsesVertexRing(false)
+	, m_mustRecreatePercentileBandsVertices(false)
+	, m_mustUpdateHighlight(false)
 {
 	setFlag(QQuickItem::ItemHasContents, true);
 
+	auto renderData = std::make_shared<BGTimeSeriesRenderData>();
+	renderData->m_color = m_color;
+	renderData->m_lineWidth = m_lineWidth;
+	renderData->m_graphTimeWindowStart = 0.0f;
+	renderData->m_graphTimeWindowEnd = 1.0f;
+	renderData->m_graphValueRangeMinimum = 0.0f;
+	renderData->m_graphValueRangeMaximum = 1.0f;
+	renderData->m_graphTimeOffset = 0;
+	renderData->m_graphGeneration = 0;
+	renderData->m_graphVertices = std::make_shared<std::vector<TimeSeriesMaterial::Vertex>>();
+	renderData->m_forecastVertices = std::make_shared<std::vector<QSGGeometry::Point2D>>();
+	renderData->m_stripVertices = std::make_shared<std::vector<QSGGeometry::ColoredPoint2D>>();
+	renderData->m_hairlineGraphPoints = std::make_shared<std::vector<QPointF>>();
+	renderData->m_hairlineGraphGapIndices = std::make_shared<std::vector<int>>();
+	m_renderData = std::move(renderData);
+
 	connect(this, &QQuickItem::widthChanged, [this](){
-		qCDebug(lcQmlBgData).nospace().noquote() << "Width changed to " << width() << "; need to recreate QSG node geometry";
+		qCDebug(lcQmlBgData).nospace().noquote() << "Width changed to " << width() << "; need to recreate graph vertices";
 
-		{
-			std::lock_guard<std::mutex> lock(m_nodeStateMutex);
-			m_mustRecreateNodeGeometry = true;
-		}
+		m_mustUpdateGraphLayout = true;
+		m_mustRecreatePercentileBandsVertices = true;
 
-		update();
+		polish();
+	});
+
+	// The new window may use a different scene graph backend.
+	connect(this, &QQuickItem::windowChanged, [this](QQuickWindow *newWindow){
+		m_mustUpdateGraphStyle = true;
+		polish();
+
+		connectFrameTimingLog(newWindow);
 	});
 
 	connect(this, &QQuickItem::heightChanged, [this](){
-		qCDebug(lcQmlBgData).nospace().noquote() << "Height changed to " << height() << "; need to recreate QSG node geometry";
+		qCDebug(lcQmlBgData).nospace().noquote() << "Height changed to " << height() << "; need to recreate graph vertices";
 
-		{
-			std::lock_guard<std::mutex> lock(m_nodeStateMutex);
-			m_mustRecreateNodeGeometry = true;
-		}
+		m_mustUpdateGraphLayout = true;
+		m_mustRecreatePercentileBandsVertices = true;
 
-		update();
+		polish();
 	});
 }
 
@@ -194,13 +688,12 @@ void BGTimeSeriesView::setColor(QColor newColor)
 	qCDebug(lcQmlBgData).nospace().noquote()
 		<< "Using new color " << newColor;
 
-	{
-		std::lock_guard<std::mutex> lock(m_nodeStateMutex);
-		m_color = std::move(newColor);
-		m_mustUpdateMaterial = true;
-	}
+	m_color = std::move(newColor);
+	// The percentile bands and tessellated lines use vertex colors.
+	m_mustRecreatePercentileBandsVertices = true;
+	m_mustUpdateGraphStyle = true;
 
-	update();
+	schedulePolish();
 }
 
 
@@ -215,13 +708,10 @@ void BGTimeSeriesView::setLineWidth(float newLineWidth)
 	qCDebug(lcQmlBgData).nospace().noquote()
 		<< "Using new line width " << newLineWidth;
 
-	{
-		std::lock_guard<std::mutex> lock(m_nodeStateMutex);
-		m_lineWidth = newLineWidth;
-		m_mustUpdateMaterial = true;
-	}
+	m_lineWidth = newLineWidth;
+	m_mustUpdateGraphStyle = true;
 
-	update();
+	schedulePolish();
 }
 
 
@@ -235,103 +725,1156 @@ void BGTimeSeriesView::setBGTimeSeries(QVariantList newBGTimeSeries)
 {
 	qCDebug(lcQmlBgData).nospace().noquote()
 		<< "Got new BG time series with " << newBGTimeSeries.size()
-		<< " item(s); will recreate QSG node geometry";
+		<< " item(s); will recreate graph vertices";
 
-	{
-		std::lock_guard<std::mutex> lock(m_nodeStateMutex);
-		m_bgTimeSeries = std::move(newBGTimeSeries);
-		m_mustRecreateNodeGeometry = true;
-	}
+	m_bgTimeSeries = std::move(newBGTimeSeries);
+	m_packedBGTimeSeries = QPolygonF();
 
-	update();
+	// Convert the series to a contiguous array once here instead
+	// of going through the QVariants every time the geometry is
+	// recreated. The vector's capacity is retained, so this does
+	// not allocate if the new series is not larger than before.
+	m_bgTimeSeriesPoints.resize(m_bgTimeSeries.size());
+	for (int i = 0; i < m_bgTimeSeries.size(); ++i)
+		m_bgTimeSeriesPoints[i] = m_bgTimeSeries[i].toPointF();
+
+	updateBGTimeSeriesPoints();
 }
 
 
-QSGNode* BGTimeSeriesView::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+QPolygonF const & BGTimeSeriesView::bgTimeSeriesPoints() const
 {
-	std::lock_guard<std::mutex> lock(m_nodeStateMutex);
+	return m_packedBGTimeSeries;
+}
 
-	QSGGeometryNode *node;
 
-	if (oldNode == nullptr)
-	{
-		qCDebug(lcQmlBgData) << "Creating new QSG time series node";
+void BGTimeSeriesView::setBGTimeSeriesPoints(QPolygonF newBGTimeSeriesPoints)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Got new packed BG time series with " << newBGTimeSeriesPoints.size()
+		<< " point(s); will recreate graph vertices";
 
-		node = new QSGGeometryNode();
-		node->setFlag(QSGNode::OwnsGeometry, true);
-		node->setFlag(QSGNode::OwnsMaterial, true);
+	m_packedBGTimeSeries = std::move(newBGTimeSeriesPoints);
+	m_bgTimeSeries = QVariantList();
 
-		QSGFlatColorMaterial *material = new QSGFlatColorMaterial;
-		node->setMaterial(material);
-		m_mustUpdateMaterial = true;
+	// The points are already contiguous, so this is a plain copy.
+	m_bgTimeSeriesPoints.assign(m_packedBGTimeSeries.begin(), m_packedBGTimeSeries.end());
 
-		QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 0);
-		geometry->setDrawingMode(QSGGeometry::DrawLineStrip);
-		geometry->setLineWidth(m_lineWidth);
-		node->setGeometry(geometry);
-	}
-	else
-	{
-		node = static_cast<QSGGeometryNode *>(oldNode);
-	}
+	updateBGTimeSeriesPoints();
+}
 
-	if (m_mustUpdateMaterial)
-	{
-		static_cast<QSGFlatColorMaterial *>(node->material())->setColor(m_color);
-		m_mustUpdateMaterial = false;
-	}
 
-	if (m_bgTimeSeries.empty())
+void BGTimeSeriesView::updateBGTimeSeriesPoints()
+{
+	// Long histories are decimated once here, so that zooming and
+	// panning only need to simplify a few thousand points at most.
+	m_bgTimeSeriesPyramid.build(m_bgTimeSeriesPoints.data(), m_bgTimeSeriesPoints.size());
+
+	m_mustSimplifyBGTimeSeries = true;
+
+	polish();
+}
+
+
+QVariantList const & BGTimeSeriesView::bgForecastTimeSeries() const
+{
+	return m_bgForecastTimeSeries;
+}
+
+
+void BGTimeSeriesView::setBGForecastTimeSeries(QVariantList newBGForecastTimeSeries)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Got new BG forecast time series with " << newBGForecastTimeSeries.size()
+		<< " item(s); will recreate graph vertices";
+
+	m_bgForecastTimeSeries = std::move(newBGForecastTimeSeries);
+	// The forecast affects the horizontal scale of the whole graph.
+	m_mustUpdateGraphLayout = true;
+
+	polish();
+}
+
+
+QVariantList const & BGTimeSeriesView::percentileBands() const
+{
+	return m_percentileBands;
+}
+
+
+void BGTimeSeriesView::setPercentileBands(QVariantList newPercentileBands)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Got new percentile bands with " << newPercentileBands.size()
+		<< " band(s); will recreate percentile bands vertices";
+
+	m_percentileBands = std::move(newPercentileBands);
+	m_mustRecreatePercentileBandsVertices = true;
+
+	polish();
+}
+
+
+BGTimeSeriesView::SimplificationMode BGTimeSeriesView::simplificationMode() const
+{
+	return m_simplificationMode;
+}
+
+
+void BGTimeSeriesView::setSimplificationMode(SimplificationMode newSimplificationMode)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new simplification mode " << newSimplificationMode;
+
+	m_simplificationMode = newSimplificationMode;
+	m_mustSimplifyBGTimeSeries = true;
+
+	schedulePolish();
+}
+
+
+int BGTimeSeriesView::minBucketWidth() const
+{
+	return m_minBucketWidth;
+}
+
+
+void BGTimeSeriesView::setMinBucketWidth(int newMinBucketWidth)
+{
+	if (newMinBucketWidth < 1)
 	{
-		qCDebug(lcQmlBgData) << "Clearing QSG time series node since the time series is empty";
-		node->geometry()->allocate(0);
-		m_simplifiedBGTimeSeries.clear();
-		m_mustRecreateNodeGeometry = false;
+		qCWarning(lcQmlBgData) << "Invalid minimum bucket width" << newMinBucketWidth << "; using 1 instead";
+		newMinBucketWidth = 1;
 	}
-	else if (m_mustRecreateNodeGeometry)
-	{
-		int currentWidth = width();
-		int currentHeight = height();
 
-		if ((currentWidth <= 0) || (currentHeight <= 0))
-		{
-			// This should in theory never happen, but if it does,
-			// we risk division by zero errors, so be on the safe side.
-			qCWarning(lcQmlBgData).nospace().noquote()
-				<< "Need to recreate QSG node geometry, but this currently cannot be done; "
-				<< "QML item width and/or height are invalid; "
-				<< "width: " << currentWidth << " height: " << currentHeight;
-		}
-		else
-		{
-			qCDebug(lcQmlBgData).nospace().noquote() << "Recreating QSG node geometry";
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new minimum bucket width " << newMinBucketWidth;
 
-			simplifyTimeSeries(m_bgTimeSeries, m_simplifiedBGTimeSeries, 3, currentWidth);
-			qCDebug(lcQmlBgData).nospace().noquote()
-				<< "Simplified original BG time series with " << m_bgTimeSeries.size() << " item(s)"
-				<< " to a BG time series with " << m_simplifiedBGTimeSeries.size() << " item(s)";
+	m_minBucketWidth = newMinBucketWidth;
+	m_mustSimplifyBGTimeSeries = true;
 
-			QSGGeometry *geometry = node->geometry();
+	schedulePolish();
+}
 
-			if (int(m_simplifiedBGTimeSeries.size()) != geometry->vertexCount())
-				geometry->allocate(m_simplifiedBGTimeSeries.size());
 
-			QSGGeometry::Point2D *vertices = geometry->vertexDataAsPoint2D();
+bool BGTimeSeriesView::smoothing() const
+{
+	return m_smoothing;
+}
 
-			for (std::size_t i = 0; i < m_simplifiedBGTimeSeries.size(); ++i)
-			{
-				QPointF const &timeSeriesPoint = m_simplifiedBGTimeSeries[i];
-				float x = timeSeriesPoint.x() * currentWidth;
-				float y = (1.0 - timeSeriesPoint.y()) * currentHeight;
 
-				vertices[i].set(x, y);
-			}
+void BGTimeSeriesView::setSmoothing(bool newSmoothing)
+{
+	if (newSmoothing == m_smoothing)
+		return;
 
-			node->markDirty(QSGNode::DirtyGeometry);
+	qCDebug(lcQmlBgData) << (newSmoothing ? "Enabling" : "Disabling") << "graph smoothing";
 
-			m_mustRecreateNodeGeometry = false;
-		}
+	m_smoothing = newSmoothing;
+	m_mustUpdateGraphStyle = true;
+
+	schedulePolish();
+}
+
+
+float BGTimeSeriesView::smoothingTolerance() const
+{
+	return m_smoothingTolerance;
+}
+
+
+void BGTimeSeriesView::setSmoothingTolerance(float newSmoothingTolerance)
+{
+	if (!(newSmoothingTolerance > 0.0f))
+	{
+		qCWarning(lcQmlBgData) << "Invalid smoothing tolerance" << newSmoothingTolerance << "; using" << DEFAULT_SMOOTHING_TOLERANCE << "instead";
+		newSmoothingTolerance = DEFAULT_SMOOTHING_TOLERANCE;
 	}
 
-	return node;
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new smoothing tolerance " << newSmoothingTolerance;
+
+	m_smoothingTolerance = newSmoothingTolerance;
+	m_mustUpdateGraphStyle = true;
+
+	schedulePolish();
+}
+
+
+float BGTimeSeriesView::gapThreshold() const
+{
+	return m_gapThreshold;
+}
+
+
+void BGTimeSeriesView::setGapThreshold(float newGapThreshold)
+{
+	if (newGapThreshold < 0.0f)
+	{
+		qCWarning(lcQmlBgData) << "Invalid gap threshold" << newGapThreshold << "; disabling gap detection instead";
+		newGapThreshold = 0.0f;
+	}
+
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new gap threshold " << newGapThreshold;
+
+	m_gapThreshold = newGapThreshold;
+	// The gaps determine how the series is split for simplification.
+	m_mustSimplifyBGTimeSeries = true;
+
+	schedulePolish();
+}
+
+
+float BGTimeSeriesView::lowThreshold() const
+{
+	return m_lowThreshold;
+}
+
+
+void BGTimeSeriesView::setLowThreshold(float newLowThreshold)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new low threshold " << newLowThreshold;
+
+	m_lowThreshold = newLowThreshold;
+	m_mustUpdateGraphStyle = true;
+
+	schedulePolish();
+}
+
+
+float BGTimeSeriesView::highThreshold() const
+{
+	return m_highThreshold;
+}
+
+
+void BGTimeSeriesView::setHighThreshold(float newHighThreshold)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new high threshold " << newHighThreshold;
+
+	m_highThreshold = newHighThreshold;
+	m_mustUpdateGraphStyle = true;
+
+	schedulePolish();
+}
+
+
+QColor const & BGTimeSeriesView::lowColor() const
+{
+	return m_lowColor;
+}
+
+
+void BGTimeSeriesView::setLowColor(QColor newLowColor)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new low color " << newLowColor;
+
+	m_lowColor = std::move(newLowColor);
+	m_mustUpdateGraphStyle = true;
+
+	schedulePolish();
+}
+
+
+QColor const & BGTimeSeriesView::highColor() const
+{
+	return m_highColor;
+}
+
+
+void BGTimeSeriesView::setHighColor(QColor newHighColor)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new high color " << newHighColor;
+
+	m_highColor = std::move(newHighColor);
+	m_mustUpdateGraphStyle = true;
+
+	schedulePolish();
+}
+
+
+QColor const & BGTimeSeriesView::targetRangeColor() const
+{
+	return m_targetRangeColor;
+}
+
+
+void BGTimeSeriesView::setTargetRangeColor(QColor newTargetRangeColor)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new target range color " << newTargetRangeColor;
+
+	m_targetRangeColor = std::move(newTargetRangeColor);
+	m_mustUpdateGraphStyle = true;
+
+	schedulePolish();
+}
+
+
+int BGTimeSeriesView::highlightedIndex() const
+{
+	return m_highlightedIndex;
+}
+
+
+void BGTimeSeriesView::setHighlightedIndex(int newHighlightedIndex)
+{
+	if (newHighlightedIndex < 0)
+		newHighlightedIndex = -1;
+
+	if (newHighlightedIndex == m_highlightedIndex)
+		return;
+
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Highlighting BG time series item #" << newHighlightedIndex;
+
+	m_highlightedIndex = newHighlightedIndex;
+	m_mustUpdateHighlight = true;
+
+	schedulePolish();
+
+	emit highlightedIndexChanged();
+}
+
+
+QColor const & BGTimeSeriesView::highlightColor() const
+{
+	return m_highlightColor;
+}
+
+
+void BGTimeSeriesView::setHighlightColor(QColor newHighlightColor)
+{
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new highlight color " << newHighlightColor;
+
+	m_highlightColor = std::move(newHighlightColor);
+	// The marker color is part of its vertices.
+	m_mustUpdateHighlight = true;
+
+	schedulePolish();
+}
+
+
+bool BGTimeSeriesView::isCached() const
+{
+	return m_cached;
+}
+
+
+void BGTimeSeriesView::setCached(bool newCached)
+{
+	if (newCached == m_cached)
+		return;
+
+	qCDebug(lcQmlBgData) << (newCached ? "Enabling" : "Disabling") << "cached graph image";
+
+	m_cached = newCached;
+	// The cached image is rasterized from tessellated lines.
+	m_mustUpdateGraphStyle = true;
+
+	polish();
+}
+
+
+bool BGTimeSeriesView::isAmbient() const
+{
+	return m_ambient;
+}
+
+
+void BGTimeSeriesView::setAmbient(bool newAmbient)
+{
+	if (newAmbient == m_ambient)
+		return;
+
+	qCDebug(lcQmlBgData) << (newAmbient ? "Entering" : "Leaving") << "ambient mode";
+
+	m_ambient = newAmbient;
+	// Ambient mode uses a cached image (see above) and wider buckets.
+	// Leaving it also applies the changes that were deferred.
+	m_mustUpdateGraphStyle = true;
+	m_mustUpdateGraphLayout = true;
+
+	polish();
+
+	emit ambientChanged();
+}
+
+
+QVariantMap BGTimeSeriesView::nearestPointAt(qreal x, qreal y) const
+{
+	QVariantMap result;
+
+	if (m_bgTimeSeriesPoints.empty() || (width() <= 0.0) || (height() <= 0.0))
+		return result;
+
+	double windowStart, windowEnd;
+	getTimeWindow(windowStart, windowEnd);
+	double xScale = width() / (windowEnd - windowStart);
+	double yScale = height();
+
+	auto toItemCoordinates = [&](QPointF const &point) {
+		return QPointF((point.x() - windowStart) * xScale, (1.0 - point.y()) * yScale);
+	};
+
+	// Find the point with the closest timestamp with a binary search,
+	// then search outwards from there for the closest point in 2D. The
+	// points are sorted by their timestamps, so the search can stop in
+	// each direction once the horizontal distance alone is larger than
+	// the smallest distance found so far. In steep sections of the
+	// graph, this may be many points away from the first one.
+	double timestamp = windowStart + x / xScale;
+	auto timestampLess = [](QPointF const &a, QPointF const &b) { return a.x() < b.x(); };
+	int numPoints = m_bgTimeSeriesPoints.size();
+	int closestIndex = std::lower_bound(m_bgTimeSeriesPoints.begin(), m_bgTimeSeriesPoints.end(), QPointF(timestamp, 0.0), timestampLess) - m_bgTimeSeriesPoints.begin();
+
+	int nearestIndex = -1;
+	double nearestDistanceSquared = 0.0;
+
+	// Returns false once the search in that direction can stop.
+	auto checkPoint = [&](int pointIndex) {
+		QPointF delta = toItemCoordinates(m_bgTimeSeriesPoints[pointIndex]) - QPointF(x, y);
+		if ((nearestIndex >= 0) && ((delta.x() * delta.x()) > nearestDistanceSquared))
+			return false;
+
+		double distanceSquared = QPointF::dotProduct(delta, delta);
+		if ((nearestIndex < 0) || (distanceSquared < nearestDistanceSquared))
+		{
+			nearestIndex = pointIndex;
+			nearestDistanceSquared = distanceSquared;
+		}
+
+		return true;
+	};
+
+	for (int pointIndex = closestIndex; pointIndex < numPoints; ++pointIndex)
+	{
+		if (!checkPoint(pointIndex))
+			break;
+	}
+
+	for (int pointIndex = closestIndex - 1; pointIndex >= 0; --pointIndex)
+	{
+		if (!checkPoint(pointIndex))
+			break;
+	}
+
+	QPointF const &nearestPoint = m_bgTimeSeriesPoints[nearestIndex];
+	QPointF nearestItemPoint = toItemCoordinates(nearestPoint);
+
+	result["index"] = nearestIndex;
+	result["timestamp"] = nearestPoint.x();
+	result["value"] = nearestPoint.y();
+	result["x"] = nearestItemPoint.x();
+	result["y"] = nearestItemPoint.y();
+
+	return result;
+}
+
+
+float BGTimeSeriesView::visibleStart() const
+{
+	return m_visibleStart;
+}
+
+
+void BGTimeSeriesView::setVisibleStart(float newVisibleStart)
+{
+	setVisibleWindow(newVisibleStart, m_visibleEnd);
+}
+
+
+float BGTimeSeriesView::visibleEnd() const
+{
+	return m_visibleEnd;
+}
+
+
+void BGTimeSeriesView::setVisibleEnd(float newVisibleEnd)
+{
+	setVisibleWindow(m_visibleStart, newVisibleEnd);
+}
+
+
+void BGTimeSeriesView::zoom(qreal factor, qreal centerX)
+{
+	if (!(factor > 0.0) || (width() <= 0.0))
+	{
+		qCWarning(lcQmlBgData) << "Cannot zoom by factor" << factor << "with item width" << width();
+		return;
+	}
+
+	// Keep the timestamp under centerX in place.
+	double windowStart, windowEnd;
+	getTimeWindow(windowStart, windowEnd);
+	double centerTimestamp = windowStart + (windowEnd - windowStart) * (centerX / width());
+
+	double visibleLength = std::clamp((m_visibleEnd - m_visibleStart) / factor, MIN_VISIBLE_WINDOW_LENGTH, 1.0);
+	double newVisibleStart = centerTimestamp - (centerTimestamp - m_visibleStart) * (visibleLength / (m_visibleEnd - m_visibleStart));
+	newVisibleStart = std::clamp(newVisibleStart, 0.0, 1.0 - visibleLength);
+
+	setVisibleWindow(newVisibleStart, newVisibleStart + visibleLength);
+}
+
+
+void BGTimeSeriesView::pan(qreal deltaX)
+{
+	if (width() <= 0.0)
+		return;
+
+	// Moving the content to the right reveals older data.
+	double windowStart, windowEnd;
+	getTimeWindow(windowStart, windowEnd);
+	double timestampDelta = -deltaX * (windowEnd - windowStart) / width();
+
+	double visibleLength = m_visibleEnd - m_visibleStart;
+	double newVisibleStart = std::clamp(m_visibleStart + timestampDelta, 0.0, std::max(1.0 - visibleLength, 0.0));
+
+	setVisibleWindow(newVisibleStart, newVisibleStart + visibleLength);
+}
+
+
+void BGTimeSeriesView::setVisibleWindow(float newVisibleStart, float newVisibleEnd)
+{
+	if (!(newVisibleEnd > newVisibleStart))
+	{
+		qCWarning(lcQmlBgData) << "Invalid visible window" << newVisibleStart << "-" << newVisibleEnd << "; ignoring";
+		return;
+	}
+
+	bool startChanged = (newVisibleStart != m_visibleStart);
+	bool endChanged = (newVisibleEnd != m_visibleEnd);
+	if (!startChanged && !endChanged)
+		return;
+
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Using new visible window " << newVisibleStart << " - " << newVisibleEnd;
+
+	m_visibleStart = newVisibleStart;
+	m_visibleEnd = newVisibleEnd;
+	m_mustUpdateGraphLayout = true;
+
+	schedulePolish();
+
+	if (startChanged)
+		emit visibleStartChanged();
+	if (endChanged)
+		emit visibleEndChanged();
+}
+
+
+void BGTimeSeriesView::schedulePolish()
+{
+	// In ambient mode, only new data and size changes cause a redraw.
+	// All other changes are applied with the next redraw, which happens
+	// at the latest when ambient mode ends.
+	if (!m_ambient)
+		polish();
+}
+
+
+bool BGTimeSeriesView::useCachedImage() const
+{
+	// The software backend of Qt Quick cannot draw custom geometry
+	// nodes, so the graph is always drawn from the cached image there.
+	return m_cached || m_ambient || isSoftwareRendererUsed();
+}
+
+
+bool BGTimeSeriesView::isSoftwareRendererUsed() const
+{
+	return (window() != nullptr) && (window()->rendererInterface()->graphicsApi() == QSGRendererInterface::Software);
+}
+
+
+void BGTimeSeriesView::getTimeWindow(double &windowStart, double &windowEnd) const
+{
+	// The forecast lies in the future, that is, its timestamps go beyond 1.
+	// The window is extended by the length of the forecast, so that the
+	// forecast fits in the item when "now" is visible.
+	double forecastLength = 0.0;
+	if (!m_bgForecastTimeSeries.empty())
+		forecastLength = std::max(m_bgForecastTimeSeries.back().toPointF().x() - 1.0, 0.0);
+
+	windowStart = m_visibleStart;
+	windowEnd = m_visibleEnd + forecastLength;
+}
+
+
+void BGTimeSeriesView::simplifyBGTimeSeries(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, double columnWidth, double gapThreshold)
+{
+	m_sourceGapIndices.clear();
+	m_simplifiedGapIndices.clear();
+
+	if (gapThreshold > 0.0)
+	{
+		for (int pointIndex = 1; pointIndex < numSourcePoints; ++pointIndex)
+		{
+			if ((sourcePoints[pointIndex].x() - sourcePoints[pointIndex - 1].x()) > gapThreshold)
+				m_sourceGapIndices.push_back(pointIndex);
+		}
+	}
+
+	if (m_sourceGapIndices.empty())
+	{
+		simplifyBGTimeSeriesPart(sourcePoints, numSourcePoints, numBuckets, columnWidth, true, m_simplifiedBGTimeSeries);
+	}
+	else
+	{
+		// Each part between gaps is simplified separately, so no bucket
+		// spans a gap. Each part gets as many buckets as fit into its
+		// length. Unlike a share of numBuckets, this does not change for
+		// the earlier parts when the slice grows or shrinks.
+		m_simplifiedBGTimeSeries.clear();
+		forEachSeriesPart(numSourcePoints, m_sourceGapIndices, [&](int partBegin, int partEnd) {
+			bool isLastPart = (partEnd == numSourcePoints);
+
+			if ((partEnd - partBegin) == 1)
+			{
+				// A reading with gaps on both sides has no neighbours to be
+				// connected to. It is drawn as a tick one bucket wide instead.
+				QPointF const &point = sourcePoints[partBegin];
+				m_simplifiedPartPoints.clear();
+				m_simplifiedPartPoints.emplace_back(point.x() - columnWidth * 0.5, point.y());
+				m_simplifiedPartPoints.emplace_back(point.x() + columnWidth * 0.5, point.y());
+			}
+			else
+			{
+				double partLength = sourcePoints[partEnd - 1].x() - sourcePoints[partBegin].x();
+				int numPartBuckets = int(std::ceil(partLength / columnWidth));
+
+				if (isLastPart)
+				{
+					int maxDeviation = std::max(int(m_numLastPartBuckets * MAX_LAST_PART_BUCKET_COUNT_DEVIATION), 2);
+					if (std::abs(numPartBuckets - m_numLastPartBuckets) > maxDeviation)
+						m_numLastPartBuckets = numPartBuckets;
+					numPartBuckets = m_numLastPartBuckets;
+				}
+
+				simplifyBGTimeSeriesPart(sourcePoints + partBegin, partEnd - partBegin, numPartBuckets, columnWidth, isLastPart, m_simplifiedPartPoints);
+			}
+
+			if (partBegin > 0)
+				m_simplifiedGapIndices.push_back(m_simplifiedBGTimeSeries.size());
+			m_simplifiedBGTimeSeries.insert(m_simplifiedBGTimeSeries.end(), m_simplifiedPartPoints.begin(), m_simplifiedPartPoints.end());
+		});
+	}
+
+	qCDebug(lcQmlBgData).nospace().noquote()
+		<< "Simplified original BG time series with " << numSourcePoints << " item(s)"
+		<< " to a BG time series with " << m_simplifiedBGTimeSeries.size() << " item(s)"
+		<< " and " << m_simplifiedGapIndices.size() << " gap(s)";
+}
+
+
+void BGTimeSeriesView::simplifyBGTimeSeriesPart(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, double columnWidth, bool isLastPart, std::vector<QPointF> &destPoints)
+{
+	switch (m_simplificationMode)
+	{
+		case SimplificationMode::LTTB:
+			// Typically, a new series is the previous one plus a new
+			// reading, minus the oldest one. The incremental variant
+			// then only has to update the buckets at the start and end.
+			// New readings only ever extend the last part, so that is
+			// the part the incremental state is kept for.
+			if (isLastPart)
+				m_simplifier.simplifyLTTBIncrementally(sourcePoints, numSourcePoints, numBuckets, destPoints);
+			else
+				m_simplifier.simplifyLTTB(sourcePoints, numSourcePoints, numBuckets, destPoints);
+			break;
+		case SimplificationMode::DYNAMIC_LTTB:
+			m_simplifier.simplifyDynamicLTTB(sourcePoints, numSourcePoints, numBuckets, destPoints);
+			break;
+		case SimplificationMode::MIN_MAX:
+			m_simplifier.simplifyMinMax(sourcePoints, numSourcePoints, columnWidth, destPoints);
+			break;
+		case SimplificationMode::NONE:
+			destPoints.assign(sourcePoints, sourcePoints + numSourcePoints);
+			break;
+	}
+}
+
+
+void BGTimeSeriesView::publishGraphVertexRing(BGTimeSeriesRenderData &renderData)
+{
+	// The ring only rewrites the parts of the published
+	// buffer that changed since it was published last.
+	renderData.m_graphVertices = m_graphVertexRing.publishVertices();
+	renderData.m_graphTimeOffset = m_graphVertexRing.timeOffset();
+	++renderData.m_graphGeneration;
+
+	if (m_graphVertexRing.isFullyDirty())
+		renderData.m_graphDirtyVertexRanges = nullptr;
+	else
+		renderData.m_graphDirtyVertexRanges = std::make_shared<std::vector<TimeSeriesVertexRing::VertexRange>>(m_graphVertexRing.dirtyVertexRanges());
+}
+
+
+void BGTimeSeriesView::updatePolish()
+{
+	// This runs on the GUI thread, so the states set by the setters above
+	// can be accessed without synchronization. The results are published
+	// as a new immutable render data instance, which the render thread
+	// picks up in updatePaintNode().
+
+	// Only measure the time if it is going to be logged.
+	bool logTiming = lcQmlBgDataTiming().isDebugEnabled();
+	QElapsedTimer polishTimer, stepTimer;
+	qint64 simplificationNsecs = 0, rasterizationNsecs = 0;
+	if (logTiming)
+		polishTimer.start();
+
+	std::shared_ptr<BGTimeSeriesRenderData const> previousRenderData = std::atomic_load(&m_renderData);
+	auto renderData = std::make_shared<BGTimeSeriesRenderData>(*previousRenderData);
+	renderData->m_color = m_color;
+	renderData->m_lineWidth = m_lineWidth;
+
+	qreal currentWidth = width();
+	qreal currentHeight = height();
+	bool hasValidSize = (currentWidth > 0) && (currentHeight > 0);
+	// Set when any of the parts of the vertex color strip change.
+	bool mustAssembleStrip = false;
+
+	// The highlight marker follows the highlighted point when the series,
+	// the item size or the window change. Its color and size depend on
+	// the graph's color and line width.
+	if (m_mustSimplifyBGTimeSeries || m_mustUpdateGraphLayout || m_mustUpdateGraphStyle)
+		m_mustUpdateHighlight = true;
+
+	if (m_bgTimeSeriesPoints.empty())
+	{
+		if (!renderData->m_graphVertices->empty() || !renderData->m_forecastVertices->empty() || !m_tessellatedGraphVertices.empty() || !renderData->m_hairlineGraphPoints->empty())
+		{
+			qCDebug(lcQmlBgData) << "Clearing graph vertices since the time series is empty";
+			m_graphVertexRing.clear();
+			publishGraphVertexRing(*renderData);
+			renderData->m_forecastVertices = std::make_shared<std::vector<QSGGeometry::Point2D>>();
+			renderData->m_hairlineGraphPoints = std::make_shared<std::vector<QPointF>>();
+			m_tessellatedGraphVertices.clear();
+			mustAssembleStrip = true;
+		}
+
+		m_simplifiedBGTimeSeries.clear();
+		m_simplifiedGapIndices.clear();
+		m_numSimplificationBuckets = 0;
+		m_simplifiedLevel = -1;
+		m_simplifiedSliceBegin = m_simplifiedSliceEnd = 0;
+		m_mustSimplifyBGTimeSeries = false;
+		m_mustUpdateGraphLayout = false;
+		m_mustUpdateGraphStyle = false;
+	}
+	else if (m_mustSimplifyBGTimeSeries || m_mustUpdateGraphLayout || m_mustUpdateGraphStyle)
+	{
+		if (!hasValidSize)
+		{
+			// This should in theory never happen, but if it does,
+			// we risk division by zero errors, so be on the safe side.
+			qCWarning(lcQmlBgData).nospace().noquote()
+				<< "Need to update graph, but this currently cannot be done; "
+				<< "QML item width and/or height are invalid; "
+				<< "width: " << currentWidth << " height: " << currentHeight;
+		}
+		else
+		{
+			double windowStart, windowEnd;
+			getTimeWindow(windowStart, windowEnd);
+			double xScale = currentWidth / (windowEnd - windowStart);
+			int minBucketWidth = m_ambient ? (m_minBucketWidth * AMBIENT_BUCKET_WIDTH_FACTOR) : m_minBucketWidth;
+			double bucketWidth = minBucketWidth / xScale;
+
+			// Pick the coarsest level of detail whose columns are at most
+			// half as wide as a bucket, so each bucket still gets the
+			// extreme values of at least two columns to choose from.
+			int level = m_bgTimeSeriesPyramid.selectLevel(bucketWidth * 0.5);
+			std::vector<QPointF> const &sourcePoints = (level >= 0) ? m_bgTimeSeriesPyramid.levelPoints(level) : m_bgTimeSeriesPoints;
+
+			// Only the slice of the series that lies within the time window
+			// is simplified and uploaded. The points right outside of the
+			// window are included, so the graph reaches the item edges.
+			auto timestampLess = [](QPointF const &a, QPointF const &b) { return a.x() < b.x(); };
+			auto sliceBeginIter = std::lower_bound(sourcePoints.begin(), sourcePoints.end(), QPointF(windowStart, 0.0), timestampLess);
+			auto sliceEndIter = std::upper_bound(sliceBeginIter, sourcePoints.end(), QPointF(windowEnd, 0.0), timestampLess);
+			int sliceBegin = std::max(int(sliceBeginIter - sourcePoints.begin()) - 1, 0);
+			int sliceEnd = std::min(int(sliceEndIter - sourcePoints.begin()) + 1, int(sourcePoints.size()));
+
+			// Consecutive points in the same column of a level can be up to
+			// a column width apart, so only larger distances are gaps there.
+			double gapThreshold = m_gapThreshold;
+			if ((gapThreshold > 0.0) && (level >= 0))
+				gapThreshold = std::max(gapThreshold, m_bgTimeSeriesPyramid.levelColumnWidth(level));
+
+			// The number of buckets is chosen based on the width of
+			// the slice in pixels and the minimum bucket width.
+			double sliceLength = sourcePoints[sliceEnd - 1].x() - sourcePoints[sliceBegin].x();
+			int sliceWidth = std::max(int(sliceLength * xScale), 1);
+			int numBuckets = (sliceWidth + (minBucketWidth - 1)) / minBucketWidth;
+
+			bool mustRecreateGraphVertices = false;
+			if (m_mustSimplifyBGTimeSeries || (numBuckets != m_numSimplificationBuckets) || (level != m_simplifiedLevel) || (sliceBegin != m_simplifiedSliceBegin) || (sliceEnd != m_simplifiedSliceEnd))
+			{
+				if (logTiming)
+					stepTimer.start();
+
+				simplifyBGTimeSeries(sourcePoints.data() + sliceBegin, sliceEnd - sliceBegin, numBuckets, bucketWidth, gapThreshold);
+
+				if (logTiming)
+					simplificationNsecs = stepTimer.nsecsElapsed();
+
+				m_numSimplificationBuckets = numBuckets;
+				m_simplifiedLevel = level;
+				m_simplifiedSliceBegin = sliceBegin;
+				m_simplifiedSliceEnd = sliceEnd;
+				m_mustSimplifyBGTimeSeries = false;
+				mustRecreateGraphVertices = true;
+			}
+
+			// Wide lines, threshold colors and the target range band all need
+			// vertex colors, which the raw int16 graph vertices do not have.
+			bool hasThresholdColors = m_lowColor.isValid() || m_highColor.isValid();
+			bool hasTargetRangeBand = (m_targetRangeColor.alpha() > 0);
+			bool useTessellation = (m_lineWidth > 1.0f) || hasThresholdColors || hasTargetRangeBand;
+			// Hairlines are drawn directly into the cached image if there is one.
+			bool useHairlineRaster = !useTessellation && useCachedImage();
+
+			// The dashes have a fixed length in pixels, so unlike the
+			// graph, the forecast is regenerated for the new size.
+			auto forecastVertices = std::make_shared<std::vector<QSGGeometry::Point2D>>();
+			generateDashedLineVertices(m_bgForecastTimeSeries, *forecastVertices, windowStart, xScale, currentHeight);
+
+			if (m_smoothing)
+			{
+				// The spline is flattened in pixel coordinates, since the
+				// tolerance is given in pixels. The flattened curve depends
+				// on the item size and the time window, so unlike with
+				// straight lines, the vertices are always recreated here,
+				// even for the int16 vertex path.
+				m_splineControlPixelPoints.resize(m_simplifiedBGTimeSeries.size());
+				for (std::size_t i = 0; i < m_simplifiedBGTimeSeries.size(); ++i)
+				{
+					QPointF const &timeSeriesPoint = m_simplifiedBGTimeSeries[i];
+					m_splineControlPixelPoints[i] = QPointF((timeSeriesPoint.x() - windowStart) * xScale, (1.0 - timeSeriesPoint.y()) * currentHeight);
+				}
+
+				// Each part between gaps gets its own spline.
+				m_graphPixelPoints.clear();
+				m_graphPixelGapIndices.clear();
+				forEachSeriesPart(m_splineControlPixelPoints.size(), m_simplifiedGapIndices, [&](int partBegin, int partEnd) {
+					if (partBegin > 0)
+						m_graphPixelGapIndices.push_back(m_graphPixelPoints.size());
+					appendMonotoneSpline(m_splineControlPixelPoints.data() + partBegin, partEnd - partBegin, m_smoothingTolerance, m_graphPixelPoints);
+				});
+				mustRecreateGraphVertices = true;
+
+				qCDebug(lcQmlBgData).nospace().noquote()
+					<< "Smoothed graph with " << m_splineControlPixelPoints.size()
+					<< " point(s) to " << m_graphPixelPoints.size() << " point(s)";
+			}
+
+			std::vector<int> const &graphGapIndices = m_smoothing ? m_graphPixelGapIndices : m_simplifiedGapIndices;
+
+			if (useTessellation || useHairlineRaster)
+			{
+				// The lines are tessellated and rasterized in pixel coordinates,
+				// since scaling their triangles non-uniformly would distort the
+				// line width. Resizing the item therefore requires a new
+				// tessellation, but as long as the number of buckets stays the
+				// same, no new simplification.
+				if (!m_smoothing)
+				{
+					m_graphPixelPoints.resize(m_simplifiedBGTimeSeries.size());
+					for (std::size_t i = 0; i < m_simplifiedBGTimeSeries.size(); ++i)
+					{
+						QPointF const &timeSeriesPoint = m_simplifiedBGTimeSeries[i];
+						m_graphPixelPoints[i] = QPointF((timeSeriesPoint.x() - windowStart) * xScale, (1.0 - timeSeriesPoint.y()) * currentHeight);
+					}
+				}
+
+				if (!renderData->m_graphVertices->empty())
+				{
+					m_graphVertexRing.clear();
+					publishGraphVertexRing(*renderData);
+				}
+			}
+
+			if (useTessellation)
+			{
+				ThresholdColoring coloring;
+				coloring.m_lowThresholdY = (1.0 - m_lowThreshold) * currentHeight;
+				coloring.m_highThresholdY = (1.0 - m_highThreshold) * currentHeight;
+				coloring.m_lowColor = m_lowColor.isValid() ? m_lowColor : m_color;
+				coloring.m_normalColor = m_color;
+				coloring.m_highColor = m_highColor.isValid() ? m_highColor : m_color;
+
+				generateTessellatedGraphVertices(m_graphPixelPoints, graphGapIndices, *forecastVertices, m_lineWidth, coloring, m_targetRangeColor, currentWidth, m_tessellationSplitPoints, m_tessellationSegmentColors, m_tessellatedGraphVertices);
+				mustAssembleStrip = true;
+
+				renderData->m_forecastVertices = std::make_shared<std::vector<QSGGeometry::Point2D>>();
+
+				if (!renderData->m_hairlineGraphPoints->empty())
+					renderData->m_hairlineGraphPoints = std::make_shared<std::vector<QPointF>>();
+			}
+			else if (useHairlineRaster)
+			{
+				// The graph and the forecast dashes are drawn into the
+				// cached image with an antialiased line algorithm.
+				renderData->m_hairlineGraphPoints = std::make_shared<std::vector<QPointF>>(m_graphPixelPoints);
+				renderData->m_hairlineGraphGapIndices = std::make_shared<std::vector<int>>(graphGapIndices);
+				renderData->m_forecastVertices = std::move(forecastVertices);
+
+				if (!m_tessellatedGraphVertices.empty())
+				{
+					m_tessellatedGraphVertices.clear();
+					mustAssembleStrip = true;
+				}
+			}
+			else
+			{
+				// The graph vertices are the raw int16 values of the series. The
+				// material maps them to item coordinates in the vertex shader.
+				// Unless the number of buckets changes, resizing the item
+				// therefore only changes the material's uniforms. When the
+				// series scrolls, the vertex ring only rewrites the segments
+				// at its start and end.
+				if (mustRecreateGraphVertices || !m_graphUsesVertexRing)
+				{
+					if (m_smoothing)
+					{
+						// The flattened spline is mapped back to normalized
+						// coordinates. One int16 step is far smaller than
+						// a pixel, so this adds no visible error.
+						m_graphRawPoints.resize(m_graphPixelPoints.size());
+						for (std::size_t i = 0; i < m_graphPixelPoints.size(); ++i)
+						{
+							QPointF const &pixelPoint = m_graphPixelPoints[i];
+							QPointF timeSeriesPoint(windowStart + pixelPoint.x() / xScale, 1.0 - pixelPoint.y() / currentHeight);
+							m_graphRawPoints[i] = TimeSeriesMaterial::Vertex::fromNormalizedPoint(timeSeriesPoint);
+						}
+					}
+					else
+					{
+						m_graphRawPoints.resize(m_simplifiedBGTimeSeries.size());
+						for (std::size_t i = 0; i < m_simplifiedBGTimeSeries.size(); ++i)
+						{
+							// The series was normalized from int16 values, so
+							// this restores the original values exactly.
+							m_graphRawPoints[i] = TimeSeriesMaterial::Vertex::fromNormalizedPoint(m_simplifiedBGTimeSeries[i]);
+						}
+					}
+
+					m_graphVertexRing.update(m_graphRawPoints, graphGapIndices);
+					publishGraphVertexRing(*renderData);
+				}
+
+				if (!m_tessellatedGraphVertices.empty())
+				{
+					m_tessellatedGraphVertices.clear();
+					mustAssembleStrip = true;
+				}
+				if (!renderData->m_hairlineGraphPoints->empty())
+					renderData->m_hairlineGraphPoints = std::make_shared<std::vector<QPointF>>();
+
+				renderData->m_forecastVertices = std::move(forecastVertices);
+			}
+
+			// Unless the slice or the number of buckets changes, zooming and
+			// panning only change these uniforms, and no vertices.
+			renderData->m_graphItemSize = QSizeF(currentWidth, currentHeight);
+			renderData->m_graphTimeWindowStart = windowStart;
+			renderData->m_graphTimeWindowEnd = windowEnd;
+
+			m_graphUsesVertexRing = !useTessellation && !useHairlineRaster;
+			m_mustUpdateGraphStyle = false;
+			m_mustUpdateGraphLayout = false;
+		}
+	}
+
+	if (m_mustRecreatePercentileBandsVertices && (m_percentileBands.empty() || hasValidSize))
+	{
+		qCDebug(lcQmlBgData).nospace().noquote() << "Recreating percentile bands vertices";
+
+		generatePercentileBandsVertices(m_percentileBands, m_color, m_percentileBandsVertices, currentWidth, currentHeight);
+		mustAssembleStrip = true;
+
+		m_mustRecreatePercentileBandsVertices = false;
+	}
+
+	if (m_mustUpdateHighlight && (hasValidSize || (m_highlightedIndex < 0)))
+	{
+		m_highlightVertices.clear();
+
+		// The index refers to the original series. If the series got
+		// shorter than that, nothing is highlighted.
+		if ((m_highlightedIndex >= 0) && (m_highlightedIndex < int(m_bgTimeSeriesPoints.size())))
+		{
+			double windowStart, windowEnd;
+			getTimeWindow(windowStart, windowEnd);
+
+			QPointF const &point = m_bgTimeSeriesPoints[m_highlightedIndex];
+			QPointF center((point.x() - windowStart) * currentWidth / (windowEnd - windowStart), (1.0 - point.y()) * currentHeight);
+			QColor const &highlightColor = m_highlightColor.isValid() ? m_highlightColor : m_color;
+			generateHighlightMarkerVertices(center, std::max(m_lineWidth * 2.0f, MIN_HIGHLIGHT_MARKER_RADIUS), highlightColor, m_highlightVertices);
+		}
+
+		mustAssembleStrip = true;
+		m_mustUpdateHighlight = false;
+	}
+
+	if (mustAssembleStrip)
+	{
+		// The percentile bands come first, so they are drawn below the
+		// graph. The highlight marker comes last, on top of the tessellated
+		// graph. The raw int16 graph is drawn over the whole strip.
+		auto stripVertices = std::make_shared<std::vector<QSGGeometry::ColoredPoint2D>>();
+		stripVertices->reserve(m_percentileBandsVertices.size() + 2 + m_tessellatedGraphVertices.size() + 2 + m_highlightVertices.size());
+		appendTriangleStrip(m_percentileBandsVertices, *stripVertices);
+		appendTriangleStrip(m_tessellatedGraphVertices, *stripVertices);
+		appendTriangleStrip(m_highlightVertices, *stripVertices);
+		renderData->m_stripVertices = std::move(stripVertices);
+	}
+
+	if (!useCachedImage())
+	{
+		renderData->m_cachedImage = nullptr;
+	}
+	else if (hasValidSize)
+	{
+		// Only rasterize the graph again if any of its parts changed.
+		qreal devicePixelRatio = (window() != nullptr) ? window()->effectiveDevicePixelRatio() : 1.0;
+		QSize imageSize(std::ceil(currentWidth * devicePixelRatio), std::ceil(currentHeight * devicePixelRatio));
+
+		bool mustRasterize = (renderData->m_cachedImage == nullptr)
+		                  || (renderData->m_cachedImage->size() != imageSize)
+		                  || (renderData->m_color != previousRenderData->m_color)
+		                  || (renderData->m_stripVertices != previousRenderData->m_stripVertices)
+		                  || (renderData->m_hairlineGraphPoints != previousRenderData->m_hairlineGraphPoints)
+		                  || (renderData->m_forecastVertices != previousRenderData->m_forecastVertices);
+
+		if (mustRasterize)
+		{
+			if (logTiming)
+				stepTimer.start();
+
+			qCDebug(lcQmlBgData).nospace().noquote()
+				<< "Rasterizing graph into " << imageSize.width() << "x" << imageSize.height() << " image";
+
+			auto image = std::make_shared<QImage>(imageSize, QImage::Format_ARGB32_Premultiplied);
+			image->setDevicePixelRatio(devicePixelRatio);
+			image->fill(Qt::transparent);
+
+			// Same order as the nodes in BGTimeSeriesNode.
+			BGTimeSeriesRenderData const &data = *renderData;
+			rasterizeTriangleStrip(data.m_stripVertices->data(), data.m_stripVertices->size(), devicePixelRatio, *image);
+			forEachSeriesPart(data.m_hairlineGraphPoints->size(), *(data.m_hairlineGraphGapIndices), [&](int partBegin, int partEnd) {
+				rasterizeHairlinePolyline(data.m_hairlineGraphPoints->data() + partBegin, partEnd - partBegin, data.m_color, devicePixelRatio, *image);
+			});
+			rasterizeHairlines(data.m_forecastVertices->data(), data.m_forecastVertices->size(), data.m_color, devicePixelRatio, *image);
+
+			renderData->m_cachedImage = std::move(image);
+
+			if (logTiming)
+				rasterizationNsecs = stepTimer.nsecsElapsed();
+		}
+	}
+
+	std::atomic_store(&m_renderData, std::shared_ptr<BGTimeSeriesRenderData const>(std::move(renderData)));
+
+	// Schedule a call to updatePaintNode() to pick up the new render data.
+	update();
+
+	if (logTiming)
+	{
+		qCDebug(lcQmlBgDataTiming).nospace().noquote()
+			<< "updatePolish: " << (polishTimer.nsecsElapsed() / 1000) << " us"
+			<< " (simplification: " << (simplificationNsecs / 1000) << " us,"
+			<< " rasterization: " << (rasterizationNsecs / 1000) << " us)"
+			<< "; " << m_bgTimeSeriesPoints.size() << " point(s)"
+			<< " simplified to " << m_simplifiedBGTimeSeries.size();
+	}
+}
+
+
+QSGNode* BGTimeSeriesView::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+{
+	// This runs on the render thread. It only copies the vertices that
+	// were prepared by updatePolish() into the QSG nodes. The render data
+	// is handed over with an atomic pointer swap, so neither thread has
+	// to wait for the other to finish its work.
+
+	bool logTiming = lcQmlBgDataTiming().isDebugEnabled();
+	QElapsedTimer timer;
+	if (logTiming)
+		timer.start();
+
+	std::shared_ptr<BGTimeSeriesRenderData const> renderData = std::atomic_load(&m_renderData);
+	QSGNode *node;
+
+	// The root node type depends on whether the graph is drawn from the
+	// vertices or from the cached image. Replace the old node if needed.
+	if (renderData->m_cachedImage != nullptr)
+	{
+		BGTimeSeriesTextureNode *textureNode = dynamic_cast<BGTimeSeriesTextureNode *>(oldNode);
+		if (textureNode == nullptr)
+		{
+			qCDebug(lcQmlBgData) << "Creating new QSG time series texture node";
+			delete oldNode;
+			textureNode = new BGTimeSeriesTextureNode();
+		}
+
+		textureNode->setRenderData(std::move(renderData), window());
+		node = textureNode;
+	}
+	else
+	{
+		BGTimeSeriesNode *geometryNode = dynamic_cast<BGTimeSeriesNode *>(oldNode);
+		if (geometryNode == nullptr)
+		{
+			qCDebug(lcQmlBgData) << "Creating new QSG time series node";
+			delete oldNode;
+			geometryNode = new BGTimeSeriesNode();
+		}
+
+		geometryNode->setRenderData(std::move(renderData));
+		node = geometryNode;
+	}
+
+	if (logTiming)
+		qCDebug(lcQmlBgDataTiming).nospace().noquote() << "updatePaintNode: " << (timer.nsecsElapsed() / 1000) << " us";
+
+	return node;
+}
+
+
+void BGTimeSeriesView::connectFrameTimingLog(QQuickWindow *newWindow)
+{
+	for (QMetaObject::Connection const &connection : m_frameTimingConnections)
+		disconnect(connection);
+	m_frameTimingConnections.clear();
+
+	// Like the rest of the timing log, this is only set up if enabled,
+	// since the signals are emitted on the render thread every frame.
+	if ((newWindow == nullptr) || !lcQmlBgDataTiming().isDebugEnabled())
+		return;
+
+	// These measure the whole window, not just this view. The
+	// timers are only accessed by the render thread.
+	m_frameTimingConnections = {
+		connect(newWindow, &QQuickWindow::beforeSynchronizing, this, [this]() {
+			m_syncTimer.start();
+		}, Qt::DirectConnection),
+		connect(newWindow, &QQuickWindow::afterSynchronizing, this, [this]() {
+			qCDebug(lcQmlBgDataTiming).nospace().noquote() << "Window sync: " << (m_syncTimer.nsecsElapsed() / 1000) << " us";
+		}, Qt::DirectConnection),
+		connect(newWindow, &QQuickWindow::beforeRendering, this, [this]() {
+			m_renderTimer.start();
+		}, Qt::DirectConnection),
+		connect(newWindow, &QQuickWindow::afterRendering, this, [this]() {
+			qCDebug(lcQmlBgDataTiming).nospace().noquote() << "Window render: " << (m_renderTimer.nsecsElapsed() / 1000) << " us";
+		}, Qt::DirectConnection)
+	};
 }
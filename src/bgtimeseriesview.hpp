@@ -1,9 +1,19 @@
 #ifndef BGTIMESERIESVIEW_HPP
 #define BGTIMESERIESVIEW_HPP
 
-#include <mutex>
+#include <memory>
+#include <vector>
+#include <QElapsedTimer>
+#include <QPolygonF>
 #include <QQuickItem>
+#include <QSGGeometry>
 #include <QVariant>
+#include "timeseriespyramid.hpp"
+#include "timeseriessimplifier.hpp"
+#include "timeseriesvertexring.hpp"
+
+
+struct BGTimeSeriesRenderData;
 
 
 /*!
@@ -14,15 +24,15 @@
 	as a graph. This graph is simplified if the item's with is too small for the amount
 	of time series data to improve graph readability.
 
-	To use, assign the value of \c {BGDataReceiver.bgTimeSeries} to this item's
-	\c bgTimeSeries property every time new BG time series become available. Typically,
+	To use, assign the value of \c {BGDataReceiver.bgTimeSeriesPoints} to this item's
+	\c bgTimeSeriesPoints property every time new BG time series become available. Typically,
 	the way to go is to do this assignment in a \c {BGDataReceiver.newDataReceived}
 	signal handler, like this:
 
 	\qml
 		BGDataReceiver {
 			onNewDataReceived: {
-				bgTimeSeriesView.bgTimeSeries = bgTimeSeries;
+				bgTimeSeriesView.bgTimeSeriesPoints = bgTimeSeriesPoints;
 			}
 		}
 
@@ -31,8 +41,44 @@
 		}
 	\endqml
 
+	By default, the graph is simplified with the Largest-Triangle-Three-Buckets
+	(LTTB) algorithm. Other algorithms can be selected with \c simplificationMode.
+
 	The item does not render any background; only the line graph itself is drawn,
 	with the color specified by the \c color property.
+
+	If \c bgForecastTimeSeries is set, the forecast is drawn as a dashed continuation
+	of the graph, in the same color. Since the forecast lies in the future, the graph
+	is compressed horizontally to make room for it.
+
+	For "typical day" views, \c percentileBands can be set to
+	\c {BGDataReceiver.percentileBands}. The 5th-95th and 25th-75th percentile
+	envelopes are then drawn as filled areas below the graph, using the
+	\c color property with reduced opacity, along with a thin median line.
+
+	Values outside of the target range can be highlighted by setting
+	\c lowThreshold and \c highThreshold along with \c lowColor and
+	\c highColor. The target range itself can be shaded by setting
+	\c targetRangeColor. The graph, the forecast and the bands are
+	then still drawn with one draw call.
+
+	For tap-to-inspect, \c nearestPointAt() finds the point of
+	\c bgTimeSeries that is closest to a tap, and \c highlightedIndex
+	marks a point of the series with a small disc.
+
+	If \c cached is set, the graph is rasterized on the CPU into an image
+	that is drawn as a texture. The image is only rasterized again when the
+	data, the size or the style changes, so the graph costs almost nothing
+	when other parts of the scene change. \c ambient additionally uses
+	coarser simplification and only redraws when new data arrives or the
+	size changes, which is meant for always-on watch face modes.
+
+	To measure the rendering cost of the view, for example with
+	\c QT_QUICK_BACKEND=software on a machine without GPU, enable the
+	\c qmlbgdata.timing logging category. The time spent in updatePolish()
+	(including simplification and rasterization), in updatePaintNode(),
+	and in synchronizing and rendering the window are then logged
+	every frame.
 */
 class BGTimeSeriesView
 	: public QQuickItem
@@ -52,8 +98,11 @@ class BGTimeSeriesView
 		\property BGTimeSeriesView::lineWidth
 		\brief Width (or thickness) of the lines that make up the graph, in pixels.
 
-		\note A line width other than 1.0 may not always be supported. This is
-		decided by the GPU and GPU driver support. This limitation is being worked on.
+		Lines that are at most 1 pixel wide are drawn as GPU lines. Wider lines
+		are tessellated into triangles with mitered (or, at sharp corners,
+		rounded) joins and antialiased edges, so any width is supported,
+		regardless of the line widths the GPU and its driver can draw.
+		The default width is 1.0.
 	*/
 	Q_PROPERTY(float lineWidth READ lineWidth WRITE setLineWidth)
 
@@ -63,7 +112,258 @@ class BGTimeSeriesView
 	*/
 	Q_PROPERTY(QVariantList bgTimeSeries READ bgTimeSeries WRITE setBGTimeSeries)
 
+	/*!
+		\property BGTimeSeriesView::bgTimeSeriesPoints
+		\brief The BG time series to render, as an array of points.
+
+		This is an alternative to \c bgTimeSeries which is meant to be set to
+		\c {BGDataReceiver.bgTimeSeriesPoints}. Unlike the list of variants,
+		this needs no conversion of individual points. Setting one of these
+		two properties clears the other one.
+	*/
+	Q_PROPERTY(QPolygonF bgTimeSeriesPoints READ bgTimeSeriesPoints WRITE setBGTimeSeriesPoints)
+
+	/*!
+		\property BGTimeSeriesView::bgForecastTimeSeries
+		\brief The BG forecast to render as a dashed continuation of the graph.
+
+		Typically, this is set to \c {BGDataReceiver.bgForecastTimeSeries}
+		together with \c bgTimeSeries. If this is empty, no forecast is drawn.
+	*/
+	Q_PROPERTY(QVariantList bgForecastTimeSeries READ bgForecastTimeSeries WRITE setBGForecastTimeSeries)
+
+	/*!
+		\property BGTimeSeriesView::percentileBands
+		\brief The percentile bands to render.
+
+		This must either be empty or contain exactly 5 time series with the
+		same timestamps, which contain the 5th, 25th, 50th, 75th and 95th
+		percentile, in that order. Typically, this is set to
+		\c {BGDataReceiver.percentileBands}. The percentile bands
+		always span the full width of the item.
+	*/
+	Q_PROPERTY(QVariantList percentileBands READ percentileBands WRITE setPercentileBands)
+
+	/*!
+		\property BGTimeSeriesView::simplificationMode
+		\brief How the BG time series is simplified if the item is too narrow for it.
+
+		The default mode is \c SimplificationMode.LTTB.
+	*/
+	Q_PROPERTY(SimplificationMode simplificationMode READ simplificationMode WRITE setSimplificationMode)
+
+	/*!
+		\property BGTimeSeriesView::minBucketWidth
+		\brief Minimum width of the buckets (or columns) used for simplification, in pixels.
+
+		Larger values produce simpler graphs. The default value is 3.
+		With \c SimplificationMode.MIN_MAX, a value of 1 yields a graph
+		that looks like the unsimplified one.
+	*/
+	Q_PROPERTY(int minBucketWidth READ minBucketWidth WRITE setMinBucketWidth)
+
+	/*!
+		\property BGTimeSeriesView::smoothing
+		\brief Whether the graph is drawn as a smooth curve.
+
+		If true, a monotone cubic spline is fitted through the simplified
+		points, and the graph follows that curve instead of straight lines.
+		The spline never goes beyond the lower or higher of two consecutive
+		points, so it does not show lows or highs that were never measured.
+		See \c smoothingTolerance for how closely the curve is approximated.
+		The default value is false.
+	*/
+	Q_PROPERTY(bool smoothing READ smoothing WRITE setSmoothing)
+
+	/*!
+		\property BGTimeSeriesView::smoothingTolerance
+		\brief Maximum deviation of the drawn graph from the smooth curve, in pixels.
+
+		The curve is drawn as a polyline. Strongly curved parts get more
+		points than flat ones, which need few or none in addition to the
+		simplified points. Smaller values produce smoother curves at the
+		cost of more vertices. The default value is 0.25.
+	*/
+	Q_PROPERTY(float smoothingTolerance READ smoothingTolerance WRITE setSmoothingTolerance)
+
+	/*!
+		\property BGTimeSeriesView::gapThreshold
+		\brief Minimum time between two readings for them not to be connected.
+
+		When the sensor misses readings, for example during a warmup or a
+		connection loss, connecting the readings around the gap with a line
+		would suggest values that were never measured. Instead, the graph
+		is interrupted wherever consecutive readings are further apart
+		than this. Like the timestamps in the time series, this is
+		normalized to the 0-1 range. Each part of the series is simplified
+		separately, so no bucket spans a gap. A reading with gaps on both
+		sides has no line to be part of, and is therefore drawn as a short
+		horizontal tick that is as wide as a bucket (see \c minBucketWidth).
+		The default value is 0.0, which disables gap detection.
+	*/
+	Q_PROPERTY(float gapThreshold READ gapThreshold WRITE setGapThreshold)
+
+	/*!
+		\property BGTimeSeriesView::lowThreshold
+		\brief BG value below which the graph is drawn with \c lowColor.
+
+		Like the values in the time series, this is normalized to the 0-1
+		range. The default value is 0.0. This is also the lower bound of
+		the target range band (see \c targetRangeColor).
+	*/
+	Q_PROPERTY(float lowThreshold READ lowThreshold WRITE setLowThreshold)
+
+	/*!
+		\property BGTimeSeriesView::highThreshold
+		\brief BG value above which the graph is drawn with \c highColor.
+
+		Like the values in the time series, this is normalized to the 0-1
+		range. The default value is 1.0. This is also the upper bound of
+		the target range band (see \c targetRangeColor).
+	*/
+	Q_PROPERTY(float highThreshold READ highThreshold WRITE setHighThreshold)
+
+	/*!
+		\property BGTimeSeriesView::lowColor
+		\brief Color of the parts of the graph (and forecast) below \c lowThreshold.
+
+		Segments that cross the threshold are split exactly at the crossing.
+		By default, this color is invalid, which means that \c color is used.
+	*/
+	Q_PROPERTY(QColor lowColor READ lowColor WRITE setLowColor)
+
+	/*!
+		\property BGTimeSeriesView::highColor
+		\brief Color of the parts of the graph (and forecast) above \c highThreshold.
+
+		Segments that cross the threshold are split exactly at the crossing.
+		By default, this color is invalid, which means that \c color is used.
+	*/
+	Q_PROPERTY(QColor highColor READ highColor WRITE setHighColor)
+
+	/*!
+		\property BGTimeSeriesView::targetRangeColor
+		\brief Color of the band between \c lowThreshold and \c highThreshold.
+
+		The band spans the full width of the item and is drawn below the
+		graph. The default color is transparent, which disables the band.
+	*/
+	Q_PROPERTY(QColor targetRangeColor READ targetRangeColor WRITE setTargetRangeColor)
+
+	/*!
+		\property BGTimeSeriesView::visibleStart
+		\brief Normalized timestamp at the left edge of the item.
+
+		Together with \c visibleEnd, this defines the visible time window.
+		Like the timestamps in the time series, this is normalized, where
+		1.0 corresponds to "now". For example, if the series covers the
+		last 24 hours, a window from 0.875 to 1.0 shows the last 3 hours.
+		The default value is 0.0.
+
+		Only the part of the series that lies in the window is simplified
+		and drawn. The points right outside of the window are included as
+		well so the graph reaches the item edges; set \c clip to true to
+		cut off the line segments that go beyond the edges.
+
+		If there is a forecast, the window is extended to the right by the
+		length of the forecast.
+	*/
+	Q_PROPERTY(float visibleStart READ visibleStart WRITE setVisibleStart NOTIFY visibleStartChanged)
+
+	/*!
+		\property BGTimeSeriesView::visibleEnd
+		\brief Normalized timestamp at the right edge of the item.
+
+		See \c visibleStart for details. The default value is 1.0.
+	*/
+	Q_PROPERTY(float visibleEnd READ visibleEnd WRITE setVisibleEnd NOTIFY visibleEndChanged)
+
+	/*!
+		\property BGTimeSeriesView::highlightedIndex
+		\brief Index of the \c bgTimeSeries item that is marked with a disc.
+
+		This is typically set to the index returned by \c nearestPointAt().
+		The index refers to the unsimplified series, so the marker is drawn
+		even if simplification dropped that point from the graph. Since the
+		index is kept when a new series is set, the marker then stays at
+		the same index. -1 means that no point is highlighted, which is
+		the default.
+	*/
+	Q_PROPERTY(int highlightedIndex READ highlightedIndex WRITE setHighlightedIndex NOTIFY highlightedIndexChanged)
+
+	/*!
+		\property BGTimeSeriesView::highlightColor
+		\brief Color of the highlight marker.
+
+		If this is not set, the \c color property is used.
+	*/
+	Q_PROPERTY(QColor highlightColor READ highlightColor WRITE setHighlightColor)
+
+	/*!
+		\property BGTimeSeriesView::cached
+		\brief Whether the graph is drawn from a cached image.
+
+		If true, the graph is rasterized into an image on the GUI thread,
+		and the scene graph only contains one texture node. The image is
+		rasterized from the same triangles that would otherwise be drawn
+		by the GPU, so it looks the same. It is only recreated when the
+		data, the item size or the style change.
+
+		Graphs that are at most 1 pixel wide and use no threshold colors or
+		target range band are drawn directly with an antialiased line
+		algorithm instead, which is faster than rasterizing triangles.
+
+		With the software backend of Qt Quick (for example with
+		\c QT_QUICK_BACKEND=software), the cached image is always used,
+		since that backend cannot draw the custom geometry the graph
+		otherwise uses.
+
+		This is useful when the graph rarely changes but the rest of the
+		scene is redrawn often. Rasterizing is more expensive than
+		generating vertices, though, so this is not meant for graphs that
+		change every frame, like while zooming. The default value is false.
+	*/
+	Q_PROPERTY(bool cached READ isCached WRITE setCached)
+
+	/*!
+		\property BGTimeSeriesView::ambient
+		\brief Whether the view is in low-power ambient (always-on) mode.
+
+		In ambient mode, the graph is drawn from a cached image like with
+		\c cached, and simplified with buckets that are 4 times as wide as
+		\c minBucketWidth. Only new data (the series, the forecast and the
+		percentile bands) and size changes cause a redraw. Changes to all
+		other properties, like colors, thresholds, the visible window and
+		the highlighted index, do not cause a redraw on their own. They
+		are applied with the next redraw, that is, when new data arrives,
+		when the size changes, or when ambient mode ends, whichever comes
+		first. The default value is false.
+	*/
+	Q_PROPERTY(bool ambient READ isAmbient WRITE setAmbient NOTIFY ambientChanged)
+
 public:
+	/*!
+		\enum BGTimeSeriesView::SimplificationMode
+
+		\value LTTB Largest-Triangle-Three-Buckets. When a new series is the previous
+			one shifted by a few readings, only the buckets at its start and end
+			are updated, so the rest of the graph stays stable.
+		\value DYNAMIC_LTTB LTTB with buckets that are smaller where the
+			series changes a lot and larger where it is mostly flat.
+		\value MIN_MAX Keeps the first, last, lowest and highest point in each
+			bucket (also known as M4). This never drops extreme lows or highs,
+			at the cost of producing up to 4 points per bucket.
+		\value NONE The series is not simplified.
+	*/
+	enum class SimplificationMode
+	{
+		LTTB,
+		DYNAMIC_LTTB,
+		MIN_MAX,
+		NONE
+	};
+	Q_ENUM(SimplificationMode)
+
 	explicit BGTimeSeriesView(QQuickItem *parent = nullptr);
 	~BGTimeSeriesView() override;
 
@@ -76,23 +376,223 @@ public:
 	QVariantList const & bgTimeSeries() const;
 	void setBGTimeSeries(QVariantList newBGTimeSeries);
 
+	QPolygonF const & bgTimeSeriesPoints() const;
+	void setBGTimeSeriesPoints(QPolygonF newBGTimeSeriesPoints);
+
+	QVariantList const & bgForecastTimeSeries() const;
+	void setBGForecastTimeSeries(QVariantList newBGForecastTimeSeries);
+
+	QVariantList const & percentileBands() const;
+	void setPercentileBands(QVariantList newPercentileBands);
+
+	SimplificationMode simplificationMode() const;
+	void setSimplificationMode(SimplificationMode newSimplificationMode);
+
+	int minBucketWidth() const;
+	void setMinBucketWidth(int newMinBucketWidth);
+
+	bool smoothing() const;
+	void setSmoothing(bool newSmoothing);
+
+	float smoothingTolerance() const;
+	void setSmoothingTolerance(float newSmoothingTolerance);
+
+	float gapThreshold() const;
+	void setGapThreshold(float newGapThreshold);
+
+	float lowThreshold() const;
+	void setLowThreshold(float newLowThreshold);
+
+	float highThreshold() const;
+	void setHighThreshold(float newHighThreshold);
+
+	QColor const & lowColor() const;
+	void setLowColor(QColor newLowColor);
+
+	QColor const & highColor() const;
+	void setHighColor(QColor newHighColor);
+
+	QColor const & targetRangeColor() const;
+	void setTargetRangeColor(QColor newTargetRangeColor);
+
+	float visibleStart() const;
+	void setVisibleStart(float newVisibleStart);
+
+	float visibleEnd() const;
+	void setVisibleEnd(float newVisibleEnd);
+
+	int highlightedIndex() const;
+	void setHighlightedIndex(int newHighlightedIndex);
+
+	QColor const & highlightColor() const;
+	void setHighlightColor(QColor newHighlightColor);
+
+	bool isCached() const;
+	void setCached(bool newCached);
+
+	bool isAmbient() const;
+	void setAmbient(bool newAmbient);
+
+	/*!
+		\fn BGTimeSeriesView::nearestPointAt(qreal x, qreal y)
+
+		Returns the item of \c bgTimeSeries that is closest to the given
+		item coordinates as a map with these entries:
+
+		\list
+			\li \c index: Index of the item in \c bgTimeSeries.
+			\li \c timestamp: Its normalized timestamp.
+			\li \c value: Its normalized BG value.
+			\li \c x, \c y: Its position in item coordinates,
+				for example for placing a label.
+		\endlist
+
+		The unsimplified series is searched, so this returns actual readings.
+		The search is a binary search over the timestamps, followed by a
+		search outwards from there that stops once the horizontal distance
+		alone exceeds the smallest distance found. If the series is
+		empty or the item has no valid size, an empty map is returned.
+	*/
+	Q_INVOKABLE QVariantMap nearestPointAt(qreal x, qreal y) const;
+
+	/*!
+		\fn BGTimeSeriesView::zoom(qreal factor, qreal centerX)
+
+		Shrinks the visible time window by \c factor (or enlarges it if
+		\c factor is less than 1). The timestamp at the item x coordinate
+		\c centerX stays in place. This is meant to be called from pinch
+		gesture handlers. The window is kept within the 0-1 range.
+	*/
+	Q_INVOKABLE void zoom(qreal factor, qreal centerX);
+
+	/*!
+		\fn BGTimeSeriesView::pan(qreal deltaX)
+
+		Moves the contents of the view by \c deltaX pixels. Positive values
+		move the contents to the right, revealing older data. This is meant
+		to be called from drag gesture handlers. The window is kept within
+		the 0-1 range.
+	*/
+	Q_INVOKABLE void pan(qreal deltaX);
+
+signals:
+	void visibleStartChanged();
+	void visibleEndChanged();
+	void highlightedIndexChanged();
+	void ambientChanged();
+
 protected:
+	void updatePolish() override;
 	QSGNode* updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *updatePaintNodeData);
 
 private:
-	// This mutex protects states that are relevant to the QSG node.
-	// In particular, it synchronizes write access by the setters
-	// above and the code in updatePaintNode(), because the latter
-	// runs in a different thread than the getters and setters abvoe.
-	std::mutex m_nodeStateMutex;
+	void schedulePolish();
+	bool useCachedImage() const;
+	bool isSoftwareRendererUsed() const;
+	void connectFrameTimingLog(QQuickWindow *newWindow);
+	void setVisibleWindow(float newVisibleStart, float newVisibleEnd);
+	void getTimeWindow(double &windowStart, double &windowEnd) const;
+	void updateBGTimeSeriesPoints();
+	void simplifyBGTimeSeries(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, double columnWidth, double gapThreshold);
+	void simplifyBGTimeSeriesPart(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, double columnWidth, bool isLastPart, std::vector<QPointF> &destPoints);
+	void publishGraphVertexRing(BGTimeSeriesRenderData &renderData);
 
+	// These states are only accessed by the GUI thread. This includes
+	// updatePolish(), which is where the vertices are generated.
 	QColor m_color;
 	float m_lineWidth;
-	bool m_mustUpdateMaterial;
 
 	QVariantList m_bgTimeSeries;
+	QPolygonF m_packedBGTimeSeries;
+	std::vector<QPointF> m_bgTimeSeriesPoints;
+	TimeSeriesPyramid m_bgTimeSeriesPyramid;
 	std::vector<QPointF> m_simplifiedBGTimeSeries;
-	bool m_mustRecreateNodeGeometry;
+	// Indices of the points in m_simplifiedBGTimeSeries that follow a gap.
+	std::vector<int> m_simplifiedGapIndices;
+	// Scratch buffers for splitting the series at gaps.
+	std::vector<int> m_sourceGapIndices;
+	std::vector<QPointF> m_simplifiedPartPoints;
+	TimeSeriesSimplifier m_simplifier;
+	SimplificationMode m_simplificationMode;
+	int m_minBucketWidth;
+	bool m_smoothing;
+	float m_smoothingTolerance;
+	float m_gapThreshold;
+	float m_lowThreshold;
+	float m_highThreshold;
+	QColor m_lowColor;
+	QColor m_highColor;
+	QColor m_targetRangeColor;
+	float m_visibleStart;
+	float m_visibleEnd;
+	int m_highlightedIndex;
+	QColor m_highlightColor;
+	bool m_cached;
+	bool m_ambient;
+	QVariantList m_bgForecastTimeSeries;
+	// Set when the series or the simplification settings change.
+	bool m_mustSimplifyBGTimeSeries;
+	int m_numSimplificationBuckets;
+	// Number of buckets of the last part if the series has gaps.
+	int m_numLastPartBuckets;
+	// Level of detail (-1 for m_bgTimeSeriesPoints itself) and
+	// range of its points that were simplified.
+	int m_simplifiedLevel;
+	int m_simplifiedSliceBegin;
+	int m_simplifiedSliceEnd;
+	// Set when the size of the item, the forecast or the visible window
+	// change. The series is then only simplified again if the slice or
+	// the number of buckets changes.
+	bool m_mustUpdateGraphLayout;
+	// Set when the colors, line width or thresholds change. These only
+	// affect the vertices if the graph is tessellated.
+	bool m_mustUpdateGraphStyle;
+	// False if the vertex ring was cleared or not updated the last
+	// time, since the graph was tessellated or rasterized instead.
+	bool m_graphUsesVertexRing;
+	// Scratch buffer for the simplified series in pixel coordinates,
+	// which is what the line tessellation and rasterization work with.
+	std::vector<QPointF> m_graphPixelPoints;
+	// With smoothing, m_graphPixelPoints contains the flattened spline
+	// instead, and this contains the simplified points it is fitted to.
+	std::vector<QPointF> m_splineControlPixelPoints;
+	// Gaps in m_graphPixelPoints. Only used with smoothing; otherwise,
+	// m_graphPixelPoints has the same gaps as the simplified series.
+	std::vector<int> m_graphPixelGapIndices;
+	// The simplified series as raw int16 values, and the ring of line
+	// segments that is built from them for the int16 shader path.
+	std::vector<TimeSeriesMaterial::Vertex> m_graphRawPoints;
+	TimeSeriesVertexRing m_graphVertexRing;
+
+	// Scratch buffers for splitting the tessellated lines at the thresholds.
+	std::vector<QPointF> m_tessellationSplitPoints;
+	std::vector<QColor> m_tessellationSegmentColors;
+	// Parts of the vertex color strip in the render data. They are kept
+	// here, since the strip is assembled again if any of them changes.
+	std::vector<QSGGeometry::ColoredPoint2D> m_tessellatedGraphVertices;
+	std::vector<QSGGeometry::ColoredPoint2D> m_percentileBandsVertices;
+	std::vector<QSGGeometry::ColoredPoint2D> m_highlightVertices;
+
+	QVariantList m_percentileBands;
+	bool m_mustRecreatePercentileBandsVertices;
+
+	// Set when the highlighted index changes, and by updatePolish()
+	// whenever the position of the highlighted point may have changed.
+	bool m_mustUpdateHighlight;
+
+	// Connections to the window's rendering signals for the timing log,
+	// and the timers they use. The timers are only accessed by the
+	// render thread.
+	QList<QMetaObject::Connection> m_frameTimingConnections;
+	QElapsedTimer m_syncTimer;
+	QElapsedTimer m_renderTimer;
+
+	// Immutable snapshot of the generated vertices and the material states.
+	// updatePolish() publishes a new snapshot with std::atomic_store(), and
+	// updatePaintNode() (which runs on the render thread) fetches it with
+	// std::atomic_load(). This way, the render thread never has to wait
+	// for the GUI thread to finish simplifying the time series.
+	std::shared_ptr<BGTimeSeriesRenderData const> m_renderData;
 };
 
 
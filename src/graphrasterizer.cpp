@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cmath>
+#include "graphrasterizer.hpp"
+
+
+namespace
+{
+
+
+// Triangles whose doubled area (in square pixels) is
+// smaller than this are treated as degenerate.
+float const MIN_DOUBLED_TRIANGLE_AREA = 1e-6f;
+
+
+// Vertex with premultiplied color channels in the 0-255 range.
+struct RasterVertex
+{
+	float m_x, m_y;
+	float m_r, m_g, m_b, m_a;
+};
+
+
+RasterVertex toRasterVertex(QSGGeometry::ColoredPoint2D const &vertex, float scale)
+{
+	return { vertex.x * scale, vertex.y * scale, float(vertex.r), float(vertex.g), float(vertex.b), float(vertex.a) };
+}
+
+
+// Signed edge function. Its value is twice the area of the triangle
+// (a, b, p), and is positive if p lies to one side of the edge a-b.
+struct Edge
+{
+	Edge(RasterVertex const &a, RasterVertex const &b)
+		: m_stepX(a.m_y - b.m_y)
+		, m_stepY(b.m_x - a.m_x)
+		, m_offset(a.m_x * b.m_y - a.m_y * b.m_x)
+	{
+		// A pixel center that lies exactly on an edge shared by two
+		// triangles must only be drawn by one of them. Both triangles
+		// traverse the shared edge in opposite directions (see
+		// rasterizeTriangle()), so a rule that depends on the direction
+		// picks exactly one of them.
+		m_includesZero = (m_stepX < 0.0f) || ((m_stepX == 0.0f) && (m_stepY < 0.0f));
+	}
+
+	float evaluate(float x, float y) const
+	{
+		return m_stepX * x + m_stepY * y + m_offset;
+	}
+
+	bool isInside(float value) const
+	{
+		return (value > 0.0f) || (m_includesZero && (value == 0.0f));
+	}
+
+	float m_stepX;
+	float m_stepY;
+	float m_offset;
+	bool m_includesZero;
+};
+
+
+void blendPixel(QRgb &pixel, float r, float g, float b, float a)
+{
+	// Source-over blending with premultiplied colors.
+	float inverseAlpha = 1.0f - a / 255.0f;
+	float destA = float((pixel >> 24) & 0xFF);
+	float destR = float((pixel >> 16) & 0xFF);
+	float destG = float((pixel >> 8) & 0xFF);
+	float destB = float(pixel & 0xFF);
+
+	auto toChannel = [](float value) { return QRgb(std::min(std::lround(value), 255L)); };
+
+	pixel = (toChannel(a + destA * inverseAlpha) << 24)
+	      | (toChannel(r + destR * inverseAlpha) << 16)
+	      | (toChannel(g + destG * inverseAlpha) << 8)
+	      | toChannel(b + destB * inverseAlpha);
+}
+
+
+void rasterizeTriangle(RasterVertex const &v0, RasterVertex v1, RasterVertex v2, QImage &image)
+{
+	float doubledArea = (v1.m_x - v0.m_x) * (v2.m_y - v0.m_y) - (v1.m_y - v0.m_y) * (v2.m_x - v0.m_x);
+	if (std::abs(doubledArea) < MIN_DOUBLED_TRIANGLE_AREA)
+		return;
+
+	// Bring all triangles into the same winding order,
+	// so that all edge functions are positive inside.
+	if (doubledArea < 0.0f)
+	{
+		std::swap(v1, v2);
+		doubledArea = -doubledArea;
+	}
+
+	int minX = std::max(int(std::floor(std::min({ v0.m_x, v1.m_x, v2.m_x }))), 0);
+	int maxX = std::min(int(std::ceil(std::max({ v0.m_x, v1.m_x, v2.m_x }))), image.width() - 1);
+	int minY = std::max(int(std::floor(std::min({ v0.m_y, v1.m_y, v2.m_y }))), 0);
+	int maxY = std::min(int(std::ceil(std::max({ v0.m_y, v1.m_y, v2.m_y }))), image.height() - 1);
+	if ((minX > maxX) || (minY > maxY))
+		return;
+
+	// The weight of each vertex is the edge function of the opposite edge.
+	Edge const edges[3] = { Edge(v1, v2), Edge(v2, v0), Edge(v0, v1) };
+	float const inverseArea = 1.0f / doubledArea;
+
+	for (int y = minY; y <= maxY; ++y)
+	{
+		float centerY = y + 0.5f;
+
+		// Narrow the scanline down to the span where all edge functions are
+		// nonnegative. The span is widened by one pixel on each side to
+		// be safe from rounding errors; the per-pixel test is exact.
+		float spanBegin = minX, spanEnd = maxX + 1;
+		for (Edge const &edge : edges)
+		{
+			if (edge.m_stepX == 0.0f)
+				continue;
+
+			float zeroX = -(edge.m_stepY * centerY + edge.m_offset) / edge.m_stepX - 0.5f;
+			if (edge.m_stepX > 0.0f)
+				spanBegin = std::max(spanBegin, std::floor(zeroX) - 1.0f);
+			else
+				spanEnd = std::min(spanEnd, std::ceil(zeroX) + 2.0f);
+		}
+
+		QRgb *scanline = reinterpret_cast<QRgb *>(image.scanLine(y));
+
+		for (int x = int(spanBegin); x < int(spanEnd); ++x)
+		{
+			float centerX = x + 0.5f;
+			float w0 = edges[0].evaluate(centerX, centerY);
+			float w1 = edges[1].evaluate(centerX, centerY);
+			float w2 = edges[2].evaluate(centerX, centerY);
+
+			if (!edges[0].isInside(w0) || !edges[1].isInside(w1) || !edges[2].isInside(w2))
+				continue;
+
+			w0 *= inverseArea;
+			w1 *= inverseArea;
+			w2 *= inverseArea;
+
+			float a = v0.m_a * w0 + v1.m_a * w1 + v2.m_a * w2;
+			if (a <= 0.0f)
+				continue;
+
+			blendPixel(
+				scanline[x],
+				v0.m_r * w0 + v1.m_r * w1 + v2.m_r * w2,
+				v0.m_g * w0 + v1.m_g * w1 + v2.m_g * w2,
+				v0.m_b * w0 + v1.m_b * w1 + v2.m_b * w2,
+				a
+			);
+		}
+	}
+}
+
+
+// Color with premultiplied channels in the 0-255 range.
+struct PremultipliedColor
+{
+	explicit PremultipliedColor(QColor const &color)
+		: m_a(color.alphaF() * 255.0f)
+		, m_r(color.redF() * m_a)
+		, m_g(color.greenF() * m_a)
+		, m_b(color.blueF() * m_a)
+	{
+	}
+
+	float m_a, m_r, m_g, m_b;
+};
+
+
+void plotCoverage(QImage &image, int x, int y, float coverage, PremultipliedColor const &color)
+{
+	if ((x < 0) || (y < 0) || (x >= image.width()) || (y >= image.height()) || (coverage <= 0.0f))
+		return;
+
+	QRgb &pixel = reinterpret_cast<QRgb *>(image.scanLine(y))[x];
+	blendPixel(pixel, color.m_r * coverage, color.m_g * coverage, color.m_b * coverage, color.m_a * coverage);
+}
+
+
+// Xiaolin Wu's antialiased line algorithm. Each column (or row, if
+// the line is steep) gets two pixels whose coverages add up to 1.
+// The coordinates are in pixels, with pixel centers at integers.
+// If skipEnd is true, the pixels of the end point are not drawn,
+// since the next line of a polyline draws them as its start point.
+void drawWuLine(float x0, float y0, float x1, float y1, bool skipEnd, PremultipliedColor const &color, QImage &image)
+{
+	bool steep = std::abs(y1 - y0) > std::abs(x1 - x0);
+	if (steep)
+	{
+		std::swap(x0, y0);
+		std::swap(x1, y1);
+	}
+
+	bool skipFirst = false, skipLast = skipEnd;
+	if (x0 > x1)
+	{
+		std::swap(x0, x1);
+		std::swap(y0, y1);
+		std::swap(skipFirst, skipLast);
+	}
+
+	int majorLimit = steep ? image.height() : image.width();
+	auto plot = [&](int major, int minor, float coverage) {
+		if (steep)
+			plotCoverage(image, minor, major, coverage, color);
+		else
+			plotCoverage(image, major, minor, coverage, color);
+	};
+
+	auto fractionalPart = [](float value) { return value - std::floor(value); };
+
+	float dx = x1 - x0;
+	float gradient = (dx == 0.0f) ? 1.0f : ((y1 - y0) / dx);
+
+	// First end point.
+	int firstMajor = int(std::lround(x0));
+	float firstMinor = y0 + gradient * (firstMajor - x0);
+	if (!skipFirst)
+	{
+		float gap = 1.0f - fractionalPart(x0 + 0.5f);
+		plot(firstMajor, int(std::floor(firstMinor)), (1.0f - fractionalPart(firstMinor)) * gap);
+		plot(firstMajor, int(std::floor(firstMinor)) + 1, fractionalPart(firstMinor) * gap);
+	}
+
+	// Last end point.
+	int lastMajor = int(std::lround(x1));
+	float lastMinor = y1 + gradient * (lastMajor - x1);
+	if (!skipLast && (lastMajor != firstMajor))
+	{
+		float gap = fractionalPart(x1 + 0.5f);
+		plot(lastMajor, int(std::floor(lastMinor)), (1.0f - fractionalPart(lastMinor)) * gap);
+		plot(lastMajor, int(std::floor(lastMinor)) + 1, fractionalPart(lastMinor) * gap);
+	}
+
+	// The pixels in between, limited to the image, since zoomed-in
+	// graphs contain lines that end far outside of the item.
+	int beginMajor = std::max(firstMajor + 1, 0);
+	int endMajor = std::min(lastMajor, majorLimit);
+	float minor = firstMinor + gradient * (beginMajor - firstMajor);
+
+	for (int major = beginMajor; major < endMajor; ++major)
+	{
+		int minorPixel = int(std::floor(minor));
+		float fraction = minor - minorPixel;
+		plot(major, minorPixel, 1.0f - fraction);
+		plot(major, minorPixel + 1, fraction);
+		minor += gradient;
+	}
+}
+
+
+} // unnamed namespace end
+
+
+void rasterizeTriangleStrip(QSGGeometry::ColoredPoint2D const *vertices, int numVertices, float scale, QImage &image)
+{
+	for (int vertexIndex = 0; (vertexIndex + 2) < numVertices; ++vertexIndex)
+	{
+		// Skip fully transparent triangles. Tessellated lines contain
+		// many of them, for example between their antialiased edges
+		// and the connections to other lines.
+		if ((vertices[vertexIndex].a == 0) && (vertices[vertexIndex + 1].a == 0) && (vertices[vertexIndex + 2].a == 0))
+			continue;
+
+		rasterizeTriangle(
+			toRasterVertex(vertices[vertexIndex + 0], scale),
+			toRasterVertex(vertices[vertexIndex + 1], scale),
+			toRasterVertex(vertices[vertexIndex + 2], scale),
+			image
+		);
+	}
+}
+
+
+void rasterizeHairlinePolyline(QPointF const *points, int numPoints, QColor const &color, float scale, QImage &image)
+{
+	PremultipliedColor premultipliedColor(color);
+
+	// Wu's algorithm places pixel centers at integer coordinates,
+	// while they lie at half-integer ones in scene graph coordinates.
+	for (int pointIndex = 0; (pointIndex + 1) < numPoints; ++pointIndex)
+	{
+		QPointF const &start = points[pointIndex];
+		QPointF const &end = points[pointIndex + 1];
+		bool isLastLine = (pointIndex + 2) == numPoints;
+
+		drawWuLine(
+			start.x() * scale - 0.5f, start.y() * scale - 0.5f,
+			end.x() * scale - 0.5f, end.y() * scale - 0.5f,
+			!isLastLine, premultipliedColor, image
+		);
+	}
+}
+
+
+void rasterizeHairlines(QSGGeometry::Point2D const *vertices, int numVertices, QColor const &color, float scale, QImage &image)
+{
+	PremultipliedColor premultipliedColor(color);
+
+	for (int vertexIndex = 0; (vertexIndex + 1) < numVertices; vertexIndex += 2)
+	{
+		QSGGeometry::Point2D const &start = vertices[vertexIndex];
+		QSGGeometry::Point2D const &end = vertices[vertexIndex + 1];
+
+		drawWuLine(
+			start.x * scale - 0.5f, start.y * scale - 0.5f,
+			end.x * scale - 0.5f, end.y * scale - 0.5f,
+			false, premultipliedColor, image
+		);
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef GRAPHRASTERIZER_HPP
+#define GRAPHRASTERIZER_HPP
+
+#include <QColor>
+#include <QImage>
+#include <QSGGeometry>
+
+
+/*!
+	\fn rasterizeTriangleStrip(QSGGeometry::ColoredPoint2D const *vertices, int numVertices, float scale, QImage &image)
+
+	Draws a triangle strip with premultiplied vertex colors into \c image,
+	which must have the QImage::Format_ARGB32_Premultiplied format. The
+	colors are interpolated across each triangle and blended over the
+	existing pixels, which matches what QSGVertexColorMaterial does on
+	the GPU. This includes the antialiased edges of tessellated lines
+	(see \c appendThickPolyline()), which fade out through their vertex
+	colors. Degenerate triangles are skipped.
+
+	The vertex coordinates are multiplied by \c scale, which is typically
+	the device pixel ratio of the image.
+
+	Pixels on an edge that is shared by two triangles are only drawn
+	once, so semi-translucent strips do not get seams.
+*/
+void rasterizeTriangleStrip(QSGGeometry::ColoredPoint2D const *vertices, int numVertices, float scale, QImage &image);
+
+/*!
+	\fn rasterizeHairlinePolyline(QPointF const *points, int numPoints, QColor const &color, float scale, QImage &image)
+
+	Draws a polyline that is 1 pixel wide into \c image with Xiaolin Wu's
+	antialiased line algorithm. This is much faster than tessellating the
+	line and rasterizing its triangles, and is used for hairline graphs.
+	Shared points are drawn once, so semi-translucent polylines do not get
+	darker dots at their joins. The parts of the polyline that lie outside
+	of the image are skipped.
+
+	The coordinates are multiplied by \c scale, like with
+	\c rasterizeTriangleStrip().
+*/
+void rasterizeHairlinePolyline(QPointF const *points, int numPoints, QColor const &color, float scale, QImage &image);
+
+/*!
+	\fn rasterizeHairlines(QSGGeometry::Point2D const *vertices, int numVertices, QColor const &color, float scale, QImage &image)
+
+	Like \c rasterizeHairlinePolyline(), except that each pair of vertices
+	is a separate line, like with QSGGeometry::DrawLines.
+*/
+void rasterizeHairlines(QSGGeometry::Point2D const *vertices, int numVertices, QColor const &color, float scale, QImage &image);
+
+
+#endif // GRAPHRASTERIZER_HPP
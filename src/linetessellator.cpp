@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <cmath>
+#include "linetessellator.hpp"
+
+
+namespace
+{
+
+
+double const PI = 3.14159265358979323846;
+
+// Width of the antialiased edges of the line, in pixels.
+double const FEATHER_WIDTH = 1.0;
+
+// Miters that are longer than this multiple of half the
+// line width are replaced with round joins.
+double const MITER_LIMIT = 2.0;
+
+// Round joins are made of one segment per this angle, with
+// at most MAX_ROUND_JOIN_STEPS segments (for a full reversal).
+double const ROUND_JOIN_STEP_ANGLE = PI / 8.0;
+int const MAX_ROUND_JOIN_STEPS = 8;
+
+// Consecutive points that are closer than this (in pixels)
+// are treated as one point, since their direction is undefined.
+double const MIN_SEGMENT_LENGTH = 1e-3;
+
+int const NUM_SECTION_VERTICES = 4;
+
+
+QPointF normalized(QPointF const &vector)
+{
+	double length = std::hypot(vector.x(), vector.y());
+	return vector / length;
+}
+
+
+QPointF perpendicular(QPointF const &direction)
+{
+	return QPointF(-direction.y(), direction.x());
+}
+
+
+double dotProduct(QPointF const &a, QPointF const &b)
+{
+	return a.x() * b.x() + a.y() * b.y();
+}
+
+
+// Builds the triangle strip out of cross sections of the line. Each
+// section consists of 4 vertices: the outer edge on one side (fully
+// transparent), the core of the line on both sides (opaque), and
+// the outer edge on the other side. Two consecutive sections are
+// connected by zigzagging between their vertices, which covers the
+// 3 bands (feather, core, feather) between them. The zigzag direction
+// alternates from segment to segment, so the strip never needs to
+// jump back to the other side of the line. The small triangles that
+// this produces at the folds only touch transparent edge vertices,
+// so they are invisible.
+class StripBuilder
+{
+public:
+	StripBuilder(float lineWidth, QColor const &color, std::vector<QSGGeometry::ColoredPoint2D> &vertices)
+		: m_vertices(vertices)
+		, m_numSegments(0)
+		, m_hasPreviousSection(false)
+	{
+		double halfWidth = lineWidth * 0.5;
+		m_innerDistance = std::max(halfWidth - FEATHER_WIDTH * 0.5, 0.0);
+		m_outerDistance = halfWidth + FEATHER_WIDTH * 0.5;
+
+		setColor(color);
+	}
+
+	// Sets the color of the sections added after this call.
+	void setColor(QColor const &color)
+	{
+		// The scene graph expects vertex colors to be premultiplied.
+		float alpha = color.alphaF();
+		m_red = uchar(color.redF() * alpha * 255.0f);
+		m_green = uchar(color.greenF() * alpha * 255.0f);
+		m_blue = uchar(color.blueF() * alpha * 255.0f);
+		m_alpha = uchar(alpha * 255.0f);
+	}
+
+	// Adds a cross section at the given center. The offset points from
+	// the center to the side of the line, and has a length of 1 for
+	// sections that are perpendicular to the line. Miters have longer
+	// offsets.
+	void addSection(QPointF const &center, QPointF const &offset)
+	{
+		QSGGeometry::ColoredPoint2D section[NUM_SECTION_VERTICES];
+		setVertex(section[0], center + offset * m_outerDistance, false);
+		setVertex(section[1], center + offset * m_innerDistance, true);
+		setVertex(section[2], center - offset * m_innerDistance, true);
+		setVertex(section[3], center - offset * m_outerDistance, false);
+
+		if (m_hasPreviousSection)
+		{
+			bool reversed = ((m_numSegments % 2) != 0);
+
+			for (int i = 0; i < NUM_SECTION_VERTICES; ++i)
+			{
+				int side = reversed ? (NUM_SECTION_VERTICES - 1 - i) : i;
+
+				if (i == 0)
+				{
+					if (m_numSegments == 0)
+					{
+						// Connect to a previously added polyline with degenerate triangles.
+						if (!m_vertices.empty())
+						{
+							m_vertices.push_back(m_vertices.back());
+							m_vertices.push_back(m_previousSection[side]);
+						}
+						m_vertices.push_back(m_previousSection[side]);
+					}
+					// Otherwise, the previous segment already ended with this vertex.
+				}
+				else
+				{
+					m_vertices.push_back(m_previousSection[side]);
+				}
+
+				m_vertices.push_back(section[side]);
+			}
+
+			++m_numSegments;
+		}
+
+		std::copy(std::begin(section), std::end(section), m_previousSection);
+		m_hasPreviousSection = true;
+	}
+
+private:
+	void setVertex(QSGGeometry::ColoredPoint2D &vertex, QPointF const &position, bool isCore)
+	{
+		if (isCore)
+			vertex.set(position.x(), position.y(), m_red, m_green, m_blue, m_alpha);
+		else
+			vertex.set(position.x(), position.y(), 0, 0, 0, 0);
+	}
+
+	std::vector<QSGGeometry::ColoredPoint2D> &m_vertices;
+	double m_innerDistance, m_outerDistance;
+	uchar m_red, m_green, m_blue, m_alpha;
+
+	QSGGeometry::ColoredPoint2D m_previousSection[NUM_SECTION_VERTICES];
+	int m_numSegments;
+	bool m_hasPreviousSection;
+};
+
+
+// segmentColor(i) returns the color of the segment from point #i to point #i+1.
+template<typename SegmentColorFunction>
+void appendThickPolylineImpl(QPointF const *points, int numPoints, float lineWidth, SegmentColorFunction const &segmentColor, std::vector<QSGGeometry::ColoredPoint2D> &vertices)
+{
+	// Returns the index of the next point after the given one that is
+	// not too close to it, or numPoints if there is no such point.
+	auto nextDistinctPoint = [&](int pointIndex) {
+		int nextPointIndex = pointIndex + 1;
+		while (nextPointIndex < numPoints)
+		{
+			QPointF delta = points[nextPointIndex] - points[pointIndex];
+			if (std::hypot(delta.x(), delta.y()) >= MIN_SEGMENT_LENGTH)
+				break;
+			++nextPointIndex;
+		}
+		return nextPointIndex;
+	};
+
+	if (numPoints < 2)
+		return;
+
+	int currentPointIndex = 0;
+	int nextPointIndex = nextDistinctPoint(0);
+	if (nextPointIndex >= numPoints)
+		return;
+
+	// Points that are skipped because they are too close to the previous
+	// one form zero-length segments. The color of a segment between two
+	// distinct points is therefore the color of its last original segment.
+	QColor incomingColor = segmentColor(nextPointIndex - 1);
+	StripBuilder builder(lineWidth, incomingColor, vertices);
+
+	// Butt cap at the start.
+	QPointF incomingDirection = normalized(points[nextPointIndex] - points[0]);
+	builder.addSection(points[0], perpendicular(incomingDirection));
+
+	while (true)
+	{
+		currentPointIndex = nextPointIndex;
+		nextPointIndex = nextDistinctPoint(currentPointIndex);
+
+		QPointF const &center = points[currentPointIndex];
+		QPointF incomingNormal = perpendicular(incomingDirection);
+
+		if (nextPointIndex >= numPoints)
+		{
+			// Butt cap at the end.
+			builder.addSection(center, incomingNormal);
+			break;
+		}
+
+		QPointF outgoingDirection = normalized(points[nextPointIndex] - center);
+		QPointF outgoingNormal = perpendicular(outgoingDirection);
+
+		// If the color changes at this point, the join's last section is
+		// repeated with the new color. This produces a hard color edge
+		// instead of a gradient along the outgoing segment.
+		QColor outgoingColor = segmentColor(nextPointIndex - 1);
+		bool colorChanges = (outgoingColor != incomingColor);
+
+		// The miter offset lies halfway between the two normals, and is
+		// scaled so that the line keeps its width along both segments.
+		QPointF miterSum = incomingNormal + outgoingNormal;
+		double miterSumLength = std::hypot(miterSum.x(), miterSum.y());
+		double miterScale = 0.0;
+		if (miterSumLength > 0.0)
+		{
+			QPointF miterDirection = miterSum / miterSumLength;
+			double cosine = dotProduct(miterDirection, incomingNormal);
+			miterScale = (cosine > 0.0) ? (1.0 / cosine) : 0.0;
+		}
+
+		QPointF lastJoinOffset;
+
+		if ((miterScale > 0.0) && (miterScale <= MITER_LIMIT))
+		{
+			lastJoinOffset = miterSum / miterSumLength * miterScale;
+			builder.addSection(center, lastJoinOffset);
+		}
+		else
+		{
+			// Round join: sweep the offset from the incoming to the
+			// outgoing normal, around the current point.
+			double angle = std::acos(std::clamp(dotProduct(incomingNormal, outgoingNormal), -1.0, 1.0));
+			double crossProduct = incomingNormal.x() * outgoingNormal.y() - incomingNormal.y() * outgoingNormal.x();
+			if (crossProduct < 0.0)
+				angle = -angle;
+
+			int numSteps = std::clamp(int(std::ceil(std::abs(angle) / ROUND_JOIN_STEP_ANGLE)), 1, MAX_ROUND_JOIN_STEPS);
+
+			for (int step = 0; step <= numSteps; ++step)
+			{
+				double stepAngle = angle * step / numSteps;
+				double cosine = std::cos(stepAngle);
+				double sine = std::sin(stepAngle);
+				QPointF offset(
+					incomingNormal.x() * cosine - incomingNormal.y() * sine,
+					incomingNormal.x() * sine + incomingNormal.y() * cosine
+				);
+				builder.addSection(center, offset);
+				lastJoinOffset = offset;
+			}
+		}
+
+		if (colorChanges)
+		{
+			builder.setColor(outgoingColor);
+			builder.addSection(center, lastJoinOffset);
+			incomingColor = outgoingColor;
+		}
+
+		incomingDirection = outgoingDirection;
+	}
+}
+
+
+} // unnamed namespace end
+
+
+void appendThickPolyline(QPointF const *points, int numPoints, float lineWidth, QColor const &color, std::vector<QSGGeometry::ColoredPoint2D> &vertices)
+{
+	appendThickPolylineImpl(points, numPoints, lineWidth, [&](int) { return color; }, vertices);
+}
+
+
+void appendThickPolyline(QPointF const *points, int numPoints, float lineWidth, QColor const *segmentColors, std::vector<QSGGeometry::ColoredPoint2D> &vertices)
+{
+	appendThickPolylineImpl(points, numPoints, lineWidth, [&](int segmentIndex) { return segmentColors[segmentIndex]; }, vertices);
+}
+
+
+int maxThickPolylineVertexCount(int numPoints)
+{
+	if (numPoints < 2)
+		return 0;
+
+	// Start and end sections, plus up to MAX_ROUND_JOIN_STEPS + 1
+	// sections per join, and one more if the color changes there.
+	// The first segment has 8 vertices, each further segment 7,
+	// plus 2 vertices for the degenerate connection.
+	int maxNumSections = 2 + (numPoints - 2) * (MAX_ROUND_JOIN_STEPS + 2);
+	return 2 + 2 * NUM_SECTION_VERTICES + (maxNumSections - 2) * (2 * NUM_SECTION_VERTICES - 1);
+}
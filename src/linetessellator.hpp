@@ -0,0 +1,48 @@
+#ifndef LINETESSELLATOR_HPP
+#define LINETESSELLATOR_HPP
+
+#include <vector>
+#include <QColor>
+#include <QPointF>
+#include <QSGGeometry>
+
+
+/*!
+	\fn appendThickPolyline(QPointF const *points, int numPoints, float lineWidth, QColor const &color, std::vector<QSGGeometry::ColoredPoint2D> &vertices)
+
+	Tessellates a polyline with the given width (in pixels) into triangles
+	and appends them to \c vertices, which are meant to be drawn as one
+	triangle strip with QSGVertexColorMaterial. If \c vertices is not empty,
+	the polyline is connected to the existing triangles with degenerate
+	triangles, so multiple polylines can be drawn with one draw call.
+
+	Joins are mitered. Where a miter would get too long, the join is
+	rounded instead. The line edges fade out over a width of 1 pixel,
+	which antialiases the line without requiring multisampling.
+
+	The number of appended vertices never exceeds what
+	\c maxThickPolylineVertexCount() returns for \c numPoints.
+*/
+void appendThickPolyline(QPointF const *points, int numPoints, float lineWidth, QColor const &color, std::vector<QSGGeometry::ColoredPoint2D> &vertices);
+
+/*!
+	\fn appendThickPolyline(QPointF const *points, int numPoints, float lineWidth, QColor const *segmentColors, std::vector<QSGGeometry::ColoredPoint2D> &vertices)
+
+	Like the other overload, except that each segment has its own color.
+	\c segmentColors must contain \c numPoints - 1 colors. Color #i is
+	used for the segment from point #i to point #i+1. Where the color
+	changes, the line changes its color abruptly instead of gradually.
+*/
+void appendThickPolyline(QPointF const *points, int numPoints, float lineWidth, QColor const *segmentColors, std::vector<QSGGeometry::ColoredPoint2D> &vertices);
+
+/*!
+	\fn maxThickPolylineVertexCount(int numPoints)
+
+	Returns the maximum number of vertices \c appendThickPolyline()
+	appends for a polyline with \c numPoints points. This is useful
+	for reserving space in the vertices vector up front.
+*/
+int maxThickPolylineVertexCount(int numPoints);
+
+
+#endif // LINETESSELLATOR_HPP
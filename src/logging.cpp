@@ -0,0 +1,12 @@
+#include <QLoggingCategory>
+
+
+// The logging categories are defined here instead of in the plugin
+// entrypoint, since the tests and benchmarks use the code without it.
+// The filter rules are set up by the plugin (see qmlbgdataplugin.cpp).
+
+Q_LOGGING_CATEGORY(lcQmlBgData, "qmlbgdata")
+// Frame timing measurements of the views. These are disabled by default
+// even in debug builds, since they produce several lines per frame.
+// Enable them with QT_LOGGING_RULES="qmlbgdata.timing.debug=true".
+Q_LOGGING_CATEGORY(lcQmlBgDataTiming, "qmlbgdata.timing")
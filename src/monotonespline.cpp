@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cmath>
+#include "monotonespline.hpp"
+
+
+namespace
+{
+
+
+// Limits the number of points per segment to 2^MAX_SUBDIVISION_DEPTH,
+// in case maxError is too small to ever be reached.
+int const MAX_SUBDIVISION_DEPTH = 8;
+
+
+double distanceToLine(QPointF const &point, QPointF const &lineStart, QPointF const &lineEnd)
+{
+	QPointF line = lineEnd - lineStart;
+	QPointF offset = point - lineStart;
+	double lineLength = std::hypot(line.x(), line.y());
+
+	if (lineLength < 1e-9)
+		return std::hypot(offset.x(), offset.y());
+	else
+		return std::abs(line.x() * offset.y() - line.y() * offset.x()) / lineLength;
+}
+
+
+// Subdivides a cubic Bezier curve with de Casteljau's algorithm until its
+// control points are within maxError of the chord. Since the curve lies
+// within the convex hull of its control points, the chord is then within
+// maxError of the curve. The start point is not appended.
+void appendFlattenedBezier(QPointF const &p0, QPointF const &p1, QPointF const &p2, QPointF const &p3, double maxError, int depth, std::vector<QPointF> &destPoints)
+{
+	bool isFlat = (distanceToLine(p1, p0, p3) <= maxError) && (distanceToLine(p2, p0, p3) <= maxError);
+
+	if (isFlat || (depth >= MAX_SUBDIVISION_DEPTH))
+	{
+		destPoints.push_back(p3);
+		return;
+	}
+
+	QPointF p01 = (p0 + p1) * 0.5;
+	QPointF p12 = (p1 + p2) * 0.5;
+	QPointF p23 = (p2 + p3) * 0.5;
+	QPointF p012 = (p01 + p12) * 0.5;
+	QPointF p123 = (p12 + p23) * 0.5;
+	QPointF middle = (p012 + p123) * 0.5;
+
+	appendFlattenedBezier(p0, p01, p012, middle, maxError, depth + 1, destPoints);
+	appendFlattenedBezier(middle, p123, p23, p3, maxError, depth + 1, destPoints);
+}
+
+
+} // unnamed namespace end
+
+
+void appendMonotoneSpline(QPointF const *points, int numPoints, double maxError, std::vector<QPointF> &destPoints)
+{
+	if (numPoints <= 0)
+		return;
+
+	destPoints.push_back(points[0]);
+
+	if (numPoints == 1)
+		return;
+
+	// Slopes of the secants between consecutive points. Secants
+	// between points with equal x coordinates are treated as flat.
+	auto secantSlope = [&](int segmentIndex) -> double {
+		double dx = points[segmentIndex + 1].x() - points[segmentIndex].x();
+		return (dx > 0.0) ? ((points[segmentIndex + 1].y() - points[segmentIndex].y()) / dx) : 0.0;
+	};
+
+	// Initial tangents: the average of the adjacent secants, or 0 at local
+	// extrema, where the adjacent secants have different signs. The end
+	// points use the slope of their only secant.
+	std::vector<double> tangents(numPoints);
+	tangents[0] = secantSlope(0);
+	tangents[numPoints - 1] = secantSlope(numPoints - 2);
+	for (int pointIndex = 1; pointIndex < (numPoints - 1); ++pointIndex)
+	{
+		double previousSlope = secantSlope(pointIndex - 1);
+		double nextSlope = secantSlope(pointIndex);
+		tangents[pointIndex] = ((previousSlope * nextSlope) > 0.0) ? ((previousSlope + nextSlope) * 0.5) : 0.0;
+	}
+
+	// Fritsch-Carlson: limit the tangents so each segment stays monotone.
+	for (int segmentIndex = 0; segmentIndex < (numPoints - 1); ++segmentIndex)
+	{
+		double slope = secantSlope(segmentIndex);
+		if (slope == 0.0)
+		{
+			tangents[segmentIndex] = tangents[segmentIndex + 1] = 0.0;
+			continue;
+		}
+
+		double alpha = tangents[segmentIndex] / slope;
+		double beta = tangents[segmentIndex + 1] / slope;
+		if (alpha < 0.0)
+			tangents[segmentIndex] = alpha = 0.0;
+		if (beta < 0.0)
+			tangents[segmentIndex + 1] = beta = 0.0;
+
+		double lengthSquared = alpha * alpha + beta * beta;
+		if (lengthSquared > 9.0)
+		{
+			double tau = 3.0 / std::sqrt(lengthSquared);
+			tangents[segmentIndex] = tau * alpha * slope;
+			tangents[segmentIndex + 1] = tau * beta * slope;
+		}
+	}
+
+	// Each segment is a cubic Hermite curve, which is
+	// flattened in its equivalent Bezier form.
+	for (int segmentIndex = 0; segmentIndex < (numPoints - 1); ++segmentIndex)
+	{
+		QPointF const &start = points[segmentIndex];
+		QPointF const &end = points[segmentIndex + 1];
+		double third = (end.x() - start.x()) / 3.0;
+
+		if (third <= 0.0)
+		{
+			destPoints.push_back(end);
+			continue;
+		}
+
+		QPointF control1(start.x() + third, start.y() + tangents[segmentIndex] * third);
+		QPointF control2(end.x() - third, end.y() - tangents[segmentIndex + 1] * third);
+
+		appendFlattenedBezier(start, control1, control2, end, maxError, 0, destPoints);
+	}
+}
@@ -0,0 +1,30 @@
+#ifndef MONOTONESPLINE_HPP
+#define MONOTONESPLINE_HPP
+
+#include <vector>
+#include <QPointF>
+
+
+/*!
+	\fn appendMonotoneSpline(QPointF const *points, int numPoints, double maxError, std::vector<QPointF> &destPoints)
+
+	Fits a monotone cubic spline through the given points and appends a
+	polyline that approximates it to \c destPoints. The points must be
+	sorted by their x coordinates. Points with equal x coordinates are
+	connected with straight lines.
+
+	The tangents are chosen with the Fritsch-Carlson method, so the curve
+	is monotone between each pair of points. In particular, it never goes
+	below the lower or above the higher of two consecutive points. This
+	matters for BG graphs, where overshooting below a low would show a
+	value that was never measured.
+
+	Each spline segment is subdivided adaptively until the polyline
+	deviates from the curve by at most \c maxError (in the units of the
+	coordinates, typically pixels). Straight and flat stretches therefore
+	add no extra points, and only strongly curved ones add many.
+*/
+void appendMonotoneSpline(QPointF const *points, int numPoints, double maxError, std::vector<QPointF> &destPoints);
+
+
+#endif // MONOTONESPLINE_HPP
@@ -6,12 +6,11 @@
 #include <QLoggingCategory>
 
 #include "qmlbgdataplugin.hpp"
+#include "bgbasaltimeseriesview.hpp"
 #include "bgdatareceiver.hpp"
 #include "bgtimeseriesview.hpp"
 
 
-Q_LOGGING_CATEGORY(lcQmlBgData, "qmlbgdata")
-
 
 QmlBgDataPlugin::QmlBgDataPlugin(QObject *parent)
 	: QQmlExtensionPlugin(parent)
@@ -22,7 +21,7 @@ QmlBgDataPlugin::QmlBgDataPlugin(QObject *parent)
 	// Also see http://doc.qt.io/qt-5/qloggingcategory.html#logging-rules
 	QLoggingCategory::setFilterRules(
 #ifdef QMLBGDATA_DEBUG_BUILD
-		QStringLiteral("qmlbgdata*.debug=true")
+		QStringLiteral("qmlbgdata*.debug=true\nqmlbgdata.timing.debug=false")
 #else
 		QStringLiteral("qmlbgdata*.debug=false")
 #endif
@@ -34,5 +33,7 @@ void QmlBgDataPlugin::registerTypes(char const *uri)
 {
 	qmlRegisterType<BGDataReceiver>(uri, 1, 0, "BGDataReceiver");
 	qmlRegisterType<BGTimeSeriesView>(uri, 1, 0, "BGTimeSeriesView");
+	qmlRegisterType<BGBasalTimeSeriesView>(uri, 1, 0, "BGBasalTimeSeriesView");
 	qmlRegisterUncreatableType<BGStatus>(uri, 1, 0, "BGStatus", "BGStatus cannot be instantiated in QML");
+	qmlRegisterUncreatableType<BGAlertEvaluator>(uri, 1, 0, "BGAlertEvaluator", "BGAlertEvaluator cannot be instantiated in QML");
 }
@@ -0,0 +1,47 @@
+#ifndef SCENEGRAPHHELPERS_HPP
+#define SCENEGRAPHHELPERS_HPP
+
+#include <algorithm>
+#include <vector>
+#include <QSGGeometry>
+#include <QSGGeometryNode>
+#include <QSGMaterial>
+
+
+// Helpers shared by the Quick items that draw time series.
+
+
+inline QSGGeometryNode * createGeometryNode(QSGMaterial *material, QSGGeometry::AttributeSet const &attributes, unsigned int drawingMode, float lineWidth)
+{
+	QSGGeometryNode *node = new QSGGeometryNode();
+	node->setFlag(QSGNode::OwnsGeometry, true);
+	node->setFlag(QSGNode::OwnsMaterial, true);
+
+	node->setMaterial(material);
+
+	QSGGeometry *geometry = new QSGGeometry(attributes, 0);
+	geometry->setDrawingMode(drawingMode);
+	geometry->setLineWidth(lineWidth);
+	node->setGeometry(geometry);
+
+	return node;
+}
+
+
+template<typename Vertex>
+void uploadVertices(std::vector<Vertex> const &vertices, QSGGeometryNode *node)
+{
+	QSGGeometry *geometry = node->geometry();
+
+	if (int(vertices.size()) != geometry->vertexCount())
+		geometry->allocate(vertices.size());
+
+	std::copy(vertices.begin(), vertices.end(), static_cast<Vertex *>(geometry->vertexData()));
+	// Geometry with a vertex data pattern other than AlwaysUploadPattern
+	// is only uploaded again if it is explicitly marked as dirty.
+	geometry->markVertexDataDirty();
+	node->markDirty(QSGNode::DirtyGeometry);
+}
+
+
+#endif // SCENEGRAPHHELPERS_HPP
@@ -0,0 +1,368 @@
+#include <cmath>
+#include <QtGlobal>
+#include "simdkernels.hpp"
+
+#if defined(QMLBGDATA_DISABLE_SIMD)
+// Use the scalar implementations only.
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define QMLBGDATA_SIMD_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define QMLBGDATA_SIMD_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define QMLBGDATA_SIMD_NEON
+#endif
+
+
+// The kernels access the coordinates of QPointF arrays directly
+// as arrays of doubles, with the x and y coordinates interleaved.
+static_assert(sizeof(QPointF) == (2 * sizeof(double)), "QPointF must consist of exactly two doubles");
+
+
+namespace
+{
+
+
+qint16 int16FromLittleEndian(char const *data)
+{
+	return qint16(quint16(quint8(data[0])) | (quint16(quint8(data[1])) << 8));
+}
+
+
+double doubleTriangleArea(double x1, double y1, double x2, double y2, double x3, double y3)
+{
+	// The correct triangle area formula is:
+	//
+	//   abs(x1 * (y2 - y3) + x2 * (y3 - y1) + x3 * (y1 - y2)) * 0.5
+	//
+	// However, since we only need the area values for comparison purposes
+	// to find the "best" point, we omit the "* 0.5" as a small optimization,
+	// hence getting the "doubleTriangleArea" instead.
+	//
+	// The vectorized kernels below evaluate the exact same
+	// expression, in the same order, to get identical results.
+	return std::abs(x1 * (y2 - y3) + x2 * (y3 - y1) + x3 * (y1 - y2));
+}
+
+
+void unpackNormalizedInt16PairsScalar(char const *data, int begin, int end, QPointF *points)
+{
+	for (int pairIndex = begin; pairIndex < end; ++pairIndex)
+	{
+		char const *pair = data + pairIndex * 4;
+		points[pairIndex] = QPointF(
+			double(int16FromLittleEndian(pair + 0)) / 32767.0,
+			double(int16FromLittleEndian(pair + 2)) / 32767.0
+		);
+	}
+}
+
+
+void findLargestTriangleScalar(QPointF const *points, int begin, int end, double x1, double y1, double x3, double y3, double &bestArea, int &bestIndex)
+{
+	for (int pointIndex = begin; pointIndex < end; ++pointIndex)
+	{
+		double area = doubleTriangleArea(x1, y1, points[pointIndex].x(), points[pointIndex].y(), x3, y3);
+		if (area > bestArea)
+		{
+			bestArea = area;
+			bestIndex = pointIndex;
+		}
+	}
+}
+
+
+#if defined(QMLBGDATA_SIMD_AVX2) || defined(QMLBGDATA_SIMD_SSE2) || defined(QMLBGDATA_SIMD_NEON)
+
+// Combines the per-lane results of the vectorized argmax into one. Among lanes
+// with equal areas, the one with the lowest index wins, so the result is the
+// same as that of the scalar loop, which picks the first largest area.
+void reduceLargestTriangleLanes(double const *laneAreas, double const *laneIndices, int numLanes, double &bestArea, int &bestIndex)
+{
+	bestArea = laneAreas[0];
+	bestIndex = int(laneIndices[0]);
+
+	for (int lane = 1; lane < numLanes; ++lane)
+	{
+		if ((laneAreas[lane] > bestArea) || ((laneAreas[lane] == bestArea) && (int(laneIndices[lane]) < bestIndex)))
+		{
+			bestArea = laneAreas[lane];
+			bestIndex = int(laneIndices[lane]);
+		}
+	}
+}
+
+#endif
+
+
+} // unnamed namespace end
+
+
+char const * simdInstructionSet()
+{
+#if defined(QMLBGDATA_SIMD_AVX2)
+	return "AVX2";
+#elif defined(QMLBGDATA_SIMD_SSE2)
+	return "SSE2";
+#elif defined(QMLBGDATA_SIMD_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+
+void unpackNormalizedInt16Pairs(char const *data, int numPairs, QPointF *points)
+{
+	int pairIndex = 0;
+	double *dest = reinterpret_cast<double *>(points);
+
+#if defined(QMLBGDATA_SIMD_AVX2)
+	__m256d const divisor = _mm256_set1_pd(32767.0);
+
+	for (; (pairIndex + 4) <= numPairs; pairIndex += 4)
+	{
+		__m128i raw = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + pairIndex * 4));
+		__m128i lowValues = _mm_cvtepi16_epi32(raw);
+		__m128i highValues = _mm_cvtepi16_epi32(_mm_srli_si128(raw, 8));
+		_mm256_storeu_pd(dest + pairIndex * 2 + 0, _mm256_div_pd(_mm256_cvtepi32_pd(lowValues), divisor));
+		_mm256_storeu_pd(dest + pairIndex * 2 + 4, _mm256_div_pd(_mm256_cvtepi32_pd(highValues), divisor));
+	}
+#elif defined(QMLBGDATA_SIMD_SSE2)
+	__m128d const divisor = _mm_set1_pd(32767.0);
+
+	for (; (pairIndex + 4) <= numPairs; pairIndex += 4)
+	{
+		__m128i raw = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + pairIndex * 4));
+		// Sign-extend the int16 values to int32 by duplicating
+		// each value and shifting the result to the right.
+		__m128i lowValues = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+		__m128i highValues = _mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16);
+		_mm_storeu_pd(dest + pairIndex * 2 + 0, _mm_div_pd(_mm_cvtepi32_pd(lowValues), divisor));
+		_mm_storeu_pd(dest + pairIndex * 2 + 2, _mm_div_pd(_mm_cvtepi32_pd(_mm_srli_si128(lowValues, 8)), divisor));
+		_mm_storeu_pd(dest + pairIndex * 2 + 4, _mm_div_pd(_mm_cvtepi32_pd(highValues), divisor));
+		_mm_storeu_pd(dest + pairIndex * 2 + 6, _mm_div_pd(_mm_cvtepi32_pd(_mm_srli_si128(highValues, 8)), divisor));
+	}
+#elif defined(QMLBGDATA_SIMD_NEON)
+	float64x2_t const divisor = vdupq_n_f64(32767.0);
+
+	for (; (pairIndex + 2) <= numPairs; pairIndex += 2)
+	{
+		int16x4_t raw = vreinterpret_s16_u8(vld1_u8(reinterpret_cast<uint8_t const *>(data + pairIndex * 4)));
+		int32x4_t values = vmovl_s16(raw);
+		float64x2_t firstPair = vcvtq_f64_s64(vmovl_s32(vget_low_s32(values)));
+		float64x2_t secondPair = vcvtq_f64_s64(vmovl_high_s32(values));
+		vst1q_f64(dest + pairIndex * 2 + 0, vdivq_f64(firstPair, divisor));
+		vst1q_f64(dest + pairIndex * 2 + 2, vdivq_f64(secondPair, divisor));
+	}
+#else
+	Q_UNUSED(dest);
+#endif
+
+	unpackNormalizedInt16PairsScalar(data, pairIndex, numPairs, points);
+}
+
+
+void computePrefixSums(QPointF const *points, int numPoints, QPointF *prefixSums)
+{
+	// The prefix sums have a serial dependency, so only the x and
+	// y coordinates can be summed in parallel. This is why even the
+	// AVX2 variant uses 128-bit vectors here.
+
+#if defined(QMLBGDATA_SIMD_AVX2) || defined(QMLBGDATA_SIMD_SSE2)
+	double const *src = reinterpret_cast<double const *>(points);
+	double *dest = reinterpret_cast<double *>(prefixSums);
+
+	__m128d sum = _mm_setzero_pd();
+	_mm_storeu_pd(dest, sum);
+
+	for (int pointIndex = 0; pointIndex < numPoints; ++pointIndex)
+	{
+		sum = _mm_add_pd(sum, _mm_loadu_pd(src + pointIndex * 2));
+		_mm_storeu_pd(dest + (pointIndex + 1) * 2, sum);
+	}
+#elif defined(QMLBGDATA_SIMD_NEON)
+	double const *src = reinterpret_cast<double const *>(points);
+	double *dest = reinterpret_cast<double *>(prefixSums);
+
+	float64x2_t sum = vdupq_n_f64(0.0);
+	vst1q_f64(dest, sum);
+
+	for (int pointIndex = 0; pointIndex < numPoints; ++pointIndex)
+	{
+		sum = vaddq_f64(sum, vld1q_f64(src + pointIndex * 2));
+		vst1q_f64(dest + (pointIndex + 1) * 2, sum);
+	}
+#else
+	QPointF sum(0.0, 0.0);
+	prefixSums[0] = sum;
+
+	for (int pointIndex = 0; pointIndex < numPoints; ++pointIndex)
+	{
+		sum += points[pointIndex];
+		prefixSums[pointIndex + 1] = sum;
+	}
+#endif
+}
+
+
+int findLargestTriangle(QPointF const *points, int begin, int end, QPointF const &firstPoint, QPointF const &thirdPoint)
+{
+	double x1 = firstPoint.x();
+	double y1 = firstPoint.y();
+	double x3 = thirdPoint.x();
+	double y3 = thirdPoint.y();
+
+	double bestArea = -1.0;
+	int bestIndex = begin;
+	int pointIndex = begin;
+
+#if defined(QMLBGDATA_SIMD_AVX2)
+	if ((end - begin) >= 4)
+	{
+		double const *src = reinterpret_cast<double const *>(points);
+
+		__m256d const vx1 = _mm256_set1_pd(x1);
+		__m256d const vy1 = _mm256_set1_pd(y1);
+		__m256d const vx3 = _mm256_set1_pd(x3);
+		__m256d const vy3 = _mm256_set1_pd(y3);
+		__m256d const vy3MinusY1 = _mm256_set1_pd(y3 - y1);
+		__m256d const signMask = _mm256_set1_pd(-0.0);
+		__m256d const indexStep = _mm256_set1_pd(4.0);
+
+		// The unpack operations below work within 128-bit halves, so
+		// the lanes contain the points in the order 0, 2, 1, 3.
+		__m256d indices = _mm256_set_pd(begin + 3, begin + 1, begin + 2, begin);
+		__m256d bestAreas = _mm256_set1_pd(-1.0);
+		__m256d bestIndices = _mm256_set1_pd(begin);
+
+		for (; (pointIndex + 4) <= end; pointIndex += 4)
+		{
+			__m256d a = _mm256_loadu_pd(src + pointIndex * 2 + 0);
+			__m256d b = _mm256_loadu_pd(src + pointIndex * 2 + 4);
+			__m256d x2 = _mm256_unpacklo_pd(a, b);
+			__m256d y2 = _mm256_unpackhi_pd(a, b);
+
+			__m256d area = _mm256_add_pd(
+				_mm256_add_pd(
+					_mm256_mul_pd(vx1, _mm256_sub_pd(y2, vy3)),
+					_mm256_mul_pd(x2, vy3MinusY1)
+				),
+				_mm256_mul_pd(vx3, _mm256_sub_pd(vy1, y2))
+			);
+			area = _mm256_andnot_pd(signMask, area);
+
+			__m256d isLarger = _mm256_cmp_pd(area, bestAreas, _CMP_GT_OQ);
+			bestAreas = _mm256_blendv_pd(bestAreas, area, isLarger);
+			bestIndices = _mm256_blendv_pd(bestIndices, indices, isLarger);
+
+			indices = _mm256_add_pd(indices, indexStep);
+		}
+
+		double laneAreas[4], laneIndices[4];
+		_mm256_storeu_pd(laneAreas, bestAreas);
+		_mm256_storeu_pd(laneIndices, bestIndices);
+		reduceLargestTriangleLanes(laneAreas, laneIndices, 4, bestArea, bestIndex);
+	}
+#elif defined(QMLBGDATA_SIMD_SSE2)
+	if ((end - begin) >= 2)
+	{
+		double const *src = reinterpret_cast<double const *>(points);
+
+		__m128d const vx1 = _mm_set1_pd(x1);
+		__m128d const vy1 = _mm_set1_pd(y1);
+		__m128d const vx3 = _mm_set1_pd(x3);
+		__m128d const vy3 = _mm_set1_pd(y3);
+		__m128d const vy3MinusY1 = _mm_set1_pd(y3 - y1);
+		__m128d const signMask = _mm_set1_pd(-0.0);
+		__m128d const indexStep = _mm_set1_pd(2.0);
+
+		__m128d indices = _mm_set_pd(begin + 1, begin);
+		__m128d bestAreas = _mm_set1_pd(-1.0);
+		__m128d bestIndices = _mm_set1_pd(begin);
+
+		for (; (pointIndex + 2) <= end; pointIndex += 2)
+		{
+			__m128d a = _mm_loadu_pd(src + pointIndex * 2 + 0);
+			__m128d b = _mm_loadu_pd(src + pointIndex * 2 + 2);
+			__m128d x2 = _mm_unpacklo_pd(a, b);
+			__m128d y2 = _mm_unpackhi_pd(a, b);
+
+			__m128d area = _mm_add_pd(
+				_mm_add_pd(
+					_mm_mul_pd(vx1, _mm_sub_pd(y2, vy3)),
+					_mm_mul_pd(x2, vy3MinusY1)
+				),
+				_mm_mul_pd(vx3, _mm_sub_pd(vy1, y2))
+			);
+			area = _mm_andnot_pd(signMask, area);
+
+			// SSE2 has no blend instruction, so select with bitwise operations.
+			__m128d isLarger = _mm_cmpgt_pd(area, bestAreas);
+			bestAreas = _mm_or_pd(_mm_and_pd(isLarger, area), _mm_andnot_pd(isLarger, bestAreas));
+			bestIndices = _mm_or_pd(_mm_and_pd(isLarger, indices), _mm_andnot_pd(isLarger, bestIndices));
+
+			indices = _mm_add_pd(indices, indexStep);
+		}
+
+		double laneAreas[2], laneIndices[2];
+		_mm_storeu_pd(laneAreas, bestAreas);
+		_mm_storeu_pd(laneIndices, bestIndices);
+		reduceLargestTriangleLanes(laneAreas, laneIndices, 2, bestArea, bestIndex);
+	}
+#elif defined(QMLBGDATA_SIMD_NEON)
+	if ((end - begin) >= 2)
+	{
+		double const *src = reinterpret_cast<double const *>(points);
+
+		float64x2_t const vx1 = vdupq_n_f64(x1);
+		float64x2_t const vy1 = vdupq_n_f64(y1);
+		float64x2_t const vx3 = vdupq_n_f64(x3);
+		float64x2_t const vy3 = vdupq_n_f64(y3);
+		float64x2_t const vy3MinusY1 = vdupq_n_f64(y3 - y1);
+		float64x2_t const indexStep = vdupq_n_f64(2.0);
+
+		double const initialIndices[2] = { double(begin), double(begin + 1) };
+		float64x2_t indices = vld1q_f64(initialIndices);
+		float64x2_t bestAreas = vdupq_n_f64(-1.0);
+		float64x2_t bestIndices = vdupq_n_f64(begin);
+
+		for (; (pointIndex + 2) <= end; pointIndex += 2)
+		{
+			float64x2_t a = vld1q_f64(src + pointIndex * 2 + 0);
+			float64x2_t b = vld1q_f64(src + pointIndex * 2 + 2);
+			float64x2_t x2 = vzip1q_f64(a, b);
+			float64x2_t y2 = vzip2q_f64(a, b);
+
+			float64x2_t area = vaddq_f64(
+				vaddq_f64(
+					vmulq_f64(vx1, vsubq_f64(y2, vy3)),
+					vmulq_f64(x2, vy3MinusY1)
+				),
+				vmulq_f64(vx3, vsubq_f64(vy1, y2))
+			);
+			area = vabsq_f64(area);
+
+			uint64x2_t isLarger = vcgtq_f64(area, bestAreas);
+			bestAreas = vbslq_f64(isLarger, area, bestAreas);
+			bestIndices = vbslq_f64(isLarger, indices, bestIndices);
+
+			indices = vaddq_f64(indices, indexStep);
+		}
+
+		double laneAreas[2], laneIndices[2];
+		vst1q_f64(laneAreas, bestAreas);
+		vst1q_f64(laneIndices, bestIndices);
+		reduceLargestTriangleLanes(laneAreas, laneIndices, 2, bestArea, bestIndex);
+	}
+#endif
+
+	// Handle the remaining points (or all points if no SIMD kernel is
+	// available). These come after all points that were handled above,
+	// so the strict comparison keeps the first largest area.
+	findLargestTriangleScalar(points, pointIndex, end, x1, y1, x3, y3, bestArea, bestIndex);
+
+	return bestIndex;
+}
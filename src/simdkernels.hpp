@@ -0,0 +1,60 @@
+#ifndef SIMDKERNELS_HPP
+#define SIMDKERNELS_HPP
+
+#include <QPointF>
+
+
+/*
+	Vectorized kernels for the hot loops of the time series processing.
+
+	The instruction set is chosen at build time. AVX2 is used if the
+	compiler targets it (for example with -march=native), SSE2 on other
+	x86-64 builds, and NEON on AArch64. Other platforms (including 32-bit
+	ARM, whose NEON unit has no double precision support) use the scalar
+	implementations. All variants produce bit-for-bit identical results.
+	Since this requires multiplications and additions to not be fused,
+	the plugin is built with -ffp-contract=off. Defining
+	QMLBGDATA_DISABLE_SIMD forces the scalar implementations, which
+	the tests use to compare the variants.
+*/
+
+
+/*!
+	\fn simdInstructionSet()
+
+	Returns the name of the instruction set the kernels were built
+	for: "AVX2", "SSE2", "NEON", or "scalar".
+*/
+char const * simdInstructionSet();
+
+
+/*!
+	\fn unpackNormalizedInt16Pairs(char const *data, int numPairs, QPointF *points)
+
+	Unpacks \c numPairs pairs of little-endian int16 values from \c data
+	into \c points. Each value is normalized by dividing it by 32767.
+	The first value of a pair becomes the x coordinate, the second
+	value the y coordinate.
+*/
+void unpackNormalizedInt16Pairs(char const *data, int numPairs, QPointF *points);
+
+/*!
+	\fn computePrefixSums(QPointF const *points, int numPoints, QPointF *prefixSums)
+
+	Fills \c prefixSums with \c numPoints + 1 entries. Entry #i contains
+	the sum of the first i points.
+*/
+void computePrefixSums(QPointF const *points, int numPoints, QPointF *prefixSums);
+
+/*!
+	\fn findLargestTriangle(QPointF const *points, int begin, int end, QPointF const &firstPoint, QPointF const &thirdPoint)
+
+	Returns the index of the point in the range [begin, end) that, together
+	with \c firstPoint and \c thirdPoint, forms the triangle with the largest
+	area. If several points form triangles with the same area, the one with
+	the lowest index is returned. If the range is empty, \c begin is returned.
+*/
+int findLargestTriangle(QPointF const *points, int begin, int end, QPointF const &firstPoint, QPointF const &thirdPoint);
+
+
+#endif // SIMDKERNELS_HPP
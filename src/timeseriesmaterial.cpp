@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <QOpenGLShaderProgram>
+#include <QSGMaterialShader>
+#include <QVector2D>
+#include <QVector4D>
+#include "timeseriesmaterial.hpp"
+
+
+namespace
+{
+
+
+class TimeSeriesMaterialShader
+	: public QSGMaterialShader
+{
+public:
+	char const * vertexShader() const override
+	{
+		// The division by 32767 is folded into the time window and value
+		// range uniforms (see updateState()), so this only needs one
+		// multiply-add per coordinate. The time offset is subtracted
+		// with int16 wraparound, that is, modulo 65536.
+		return
+			"attribute highp vec4 vertex;\n"
+			"uniform highp mat4 matrix;\n"
+			"uniform highp vec2 scale;\n"
+			"uniform highp vec2 offset;\n"
+			"uniform highp float timeOffset;\n"
+			"void main() {\n"
+			"    highp float timestamp = mod(vertex.x - timeOffset + 32768.0, 65536.0) - 32768.0;\n"
+			"    gl_Position = matrix * vec4(vec2(timestamp, vertex.y) * scale + offset, 0.0, 1.0);\n"
+			"}\n";
+	}
+
+	char const * fragmentShader() const override
+	{
+		return
+			"uniform lowp vec4 color;\n"
+			"uniform lowp float opacity;\n"
+			"void main() {\n"
+			"    gl_FragColor = color * opacity;\n"
+			"}\n";
+	}
+
+	char const * const * attributeNames() const override
+	{
+		static char const * const names[] = { "vertex", nullptr };
+		return names;
+	}
+
+	void initialize() override
+	{
+		m_matrixId = program()->uniformLocation("matrix");
+		m_opacityId = program()->uniformLocation("opacity");
+		m_colorId = program()->uniformLocation("color");
+		m_scaleId = program()->uniformLocation("scale");
+		m_offsetId = program()->uniformLocation("offset");
+		m_timeOffsetId = program()->uniformLocation("timeOffset");
+	}
+
+	void updateState(RenderState const &state, QSGMaterial *newMaterial, QSGMaterial *oldMaterial) override
+	{
+		if (state.isMatrixDirty())
+			program()->setUniformValue(m_matrixId, state.combinedMatrix());
+		if (state.isOpacityDirty())
+			program()->setUniformValue(m_opacityId, state.opacity());
+
+		TimeSeriesMaterial const *material = static_cast<TimeSeriesMaterial const *>(newMaterial);
+		TimeSeriesMaterial const *previousMaterial = static_cast<TimeSeriesMaterial const *>(oldMaterial);
+
+		if ((previousMaterial == nullptr) || (previousMaterial->color() != material->color()))
+		{
+			// The scene graph blends with premultiplied alpha.
+			QColor const &color = material->color();
+			float alpha = color.alphaF();
+			program()->setUniformValue(m_colorId, QVector4D(color.redF() * alpha, color.greenF() * alpha, color.blueF() * alpha, alpha));
+		}
+
+		if ((previousMaterial == nullptr) || (previousMaterial->compare(material) != 0))
+		{
+			// x = (timestamp / 32767 - windowStart) / (windowEnd - windowStart) * width
+			// y = (1 - (value / 32767 - rangeMin) / (rangeMax - rangeMin)) * height
+			// Both are rearranged into the form raw * scale + offset.
+			QSizeF const &itemSize = material->itemSize();
+			float timeWindowLength = material->timeWindowEnd() - material->timeWindowStart();
+			float valueRangeLength = material->valueRangeMaximum() - material->valueRangeMinimum();
+			float xFactor = (timeWindowLength != 0.0f) ? (itemSize.width() / timeWindowLength) : 0.0f;
+			float yFactor = (valueRangeLength != 0.0f) ? (itemSize.height() / valueRangeLength) : 0.0f;
+
+			QVector2D scale(xFactor / 32767.0f, -yFactor / 32767.0f);
+			QVector2D offset(
+				-material->timeWindowStart() * xFactor,
+				itemSize.height() + material->valueRangeMinimum() * yFactor
+			);
+
+			program()->setUniformValue(m_scaleId, scale);
+			program()->setUniformValue(m_offsetId, offset);
+			program()->setUniformValue(m_timeOffsetId, float(material->timeOffset()));
+		}
+	}
+
+private:
+	int m_matrixId;
+	int m_opacityId;
+	int m_colorId;
+	int m_scaleId;
+	int m_offsetId;
+	int m_timeOffsetId;
+};
+
+
+qint16 toRawInt16(double normalizedValue)
+{
+	return qint16(std::clamp(std::lround(normalizedValue * 32767.0), -32768L, 32767L));
+}
+
+
+} // unnamed namespace end
+
+
+TimeSeriesMaterial::Vertex TimeSeriesMaterial::Vertex::fromNormalizedPoint(QPointF const &point)
+{
+	return { toRawInt16(point.x()), toRawInt16(point.y()) };
+}
+
+
+
+QSGGeometry::AttributeSet const & TimeSeriesMaterial::attributes()
+{
+	static QSGGeometry::Attribute const attributes[] = {
+		QSGGeometry::Attribute::createWithAttributeType(0, 2, QSGGeometry::ShortType, QSGGeometry::PositionAttribute)
+	};
+	static QSGGeometry::AttributeSet const attributeSet = { 1, sizeof(Vertex), attributes };
+	return attributeSet;
+}
+
+
+TimeSeriesMaterial::TimeSeriesMaterial()
+	: m_color(Qt::black)
+	, m_timeWindowStart(0.0f)
+	, m_timeWindowEnd(1.0f)
+	, m_valueRangeMinimum(0.0f)
+	, m_valueRangeMaximum(1.0f)
+	, m_timeOffset(0)
+{
+}
+
+
+QSGMaterialType * TimeSeriesMaterial::type() const
+{
+	static QSGMaterialType type;
+	return &type;
+}
+
+
+QSGMaterialShader * TimeSeriesMaterial::createShader() const
+{
+	return new TimeSeriesMaterialShader;
+}
+
+
+int TimeSeriesMaterial::compare(QSGMaterial const *other) const
+{
+	// Materials that compare equal can be batched together,
+	// so all states that end up in uniforms must be compared.
+	TimeSeriesMaterial const *otherMaterial = static_cast<TimeSeriesMaterial const *>(other);
+
+	if (m_color != otherMaterial->m_color)
+		return (m_color.rgba() < otherMaterial->m_color.rgba()) ? -1 : 1;
+
+	float const states[] = {
+		float(m_itemSize.width()), float(m_itemSize.height()),
+		m_timeWindowStart, m_timeWindowEnd,
+		m_valueRangeMinimum, m_valueRangeMaximum,
+		float(m_timeOffset)
+	};
+	float const otherStates[] = {
+		float(otherMaterial->m_itemSize.width()), float(otherMaterial->m_itemSize.height()),
+		otherMaterial->m_timeWindowStart, otherMaterial->m_timeWindowEnd,
+		otherMaterial->m_valueRangeMinimum, otherMaterial->m_valueRangeMaximum,
+		float(otherMaterial->m_timeOffset)
+	};
+
+	for (std::size_t i = 0; i < std::size(states); ++i)
+	{
+		if (states[i] != otherStates[i])
+			return (states[i] < otherStates[i]) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+
+void TimeSeriesMaterial::setColor(QColor const &color)
+{
+	m_color = color;
+	setFlag(Blending, m_color.alpha() != 255);
+}
+
+
+QColor const & TimeSeriesMaterial::color() const
+{
+	return m_color;
+}
+
+
+void TimeSeriesMaterial::setItemSize(QSizeF const &itemSize)
+{
+	m_itemSize = itemSize;
+}
+
+
+QSizeF const & TimeSeriesMaterial::itemSize() const
+{
+	return m_itemSize;
+}
+
+
+void TimeSeriesMaterial::setTimeWindow(float start, float end)
+{
+	m_timeWindowStart = start;
+	m_timeWindowEnd = end;
+}
+
+
+float TimeSeriesMaterial::timeWindowStart() const
+{
+	return m_timeWindowStart;
+}
+
+
+float TimeSeriesMaterial::timeWindowEnd() const
+{
+	return m_timeWindowEnd;
+}
+
+
+void TimeSeriesMaterial::setValueRange(float minimum, float maximum)
+{
+	m_valueRangeMinimum = minimum;
+	m_valueRangeMaximum = maximum;
+}
+
+
+float TimeSeriesMaterial::valueRangeMinimum() const
+{
+	return m_valueRangeMinimum;
+}
+
+
+float TimeSeriesMaterial::valueRangeMaximum() const
+{
+	return m_valueRangeMaximum;
+}
+
+
+void TimeSeriesMaterial::setTimeOffset(int timeOffset)
+{
+	m_timeOffset = timeOffset;
+}
+
+
+int TimeSeriesMaterial::timeOffset() const
+{
+	return m_timeOffset;
+}
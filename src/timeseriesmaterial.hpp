@@ -0,0 +1,105 @@
+#ifndef TIMESERIESMATERIAL_HPP
+#define TIMESERIESMATERIAL_HPP
+
+#include <QColor>
+#include <QPointF>
+#include <QSGGeometry>
+#include <QSGMaterial>
+#include <QSizeF>
+#include <QtGlobal>
+
+
+/*!
+	\class TimeSeriesMaterial
+	\brief Flat color material for geometry made of raw int16 time series points.
+
+	The vertices of geometry that uses this material are the int16
+	timestamp/value pairs as they appear in the binary BG data format,
+	where 32767 corresponds to a normalized coordinate of 1. The vertex
+	shader maps them to item coordinates using the item size, the visible
+	time window and the value range. Since these are uniforms, changing
+	them (for example because the item is resized) does not require
+	regenerating or uploading any vertex data. The vertices are also half
+	as large as floating point vertices.
+
+	Like with QSGFlatColorMaterial, the color is not premultiplied.
+*/
+class TimeSeriesMaterial
+	: public QSGMaterial
+{
+public:
+	struct Vertex
+	{
+		qint16 m_timestamp;
+		qint16 m_value;
+
+		// Converts a point in normalized coordinates to raw int16 values. This
+		// exactly restores points that were normalized from int16 values.
+		static Vertex fromNormalizedPoint(QPointF const &point);
+	};
+
+	/*!
+		\fn TimeSeriesMaterial::attributes()
+
+		Returns the attribute set for geometry that contains \c Vertex instances.
+	*/
+	static QSGGeometry::AttributeSet const & attributes();
+
+	TimeSeriesMaterial();
+
+	QSGMaterialType * type() const override;
+	QSGMaterialShader * createShader() const override;
+	int compare(QSGMaterial const *other) const override;
+
+	void setColor(QColor const &color);
+	QColor const & color() const;
+
+	/*!
+		\fn TimeSeriesMaterial::setItemSize(QSizeF const &itemSize)
+
+		Sets the size of the area that the visible part of the
+		series is stretched to, in item coordinates.
+	*/
+	void setItemSize(QSizeF const &itemSize);
+	QSizeF const & itemSize() const;
+
+	/*!
+		\fn TimeSeriesMaterial::setTimeWindow(float start, float end)
+
+		Sets the visible range of normalized timestamps. \c start is mapped
+		to the left edge of the item, \c end to the right edge.
+	*/
+	void setTimeWindow(float start, float end);
+	float timeWindowStart() const;
+	float timeWindowEnd() const;
+
+	/*!
+		\fn TimeSeriesMaterial::setValueRange(float minimum, float maximum)
+
+		Sets the visible range of normalized values. \c minimum is mapped
+		to the bottom edge of the item, \c maximum to the top edge.
+	*/
+	void setValueRange(float minimum, float maximum);
+	float valueRangeMinimum() const;
+	float valueRangeMaximum() const;
+
+	/*!
+		\fn TimeSeriesMaterial::setTimeOffset(int timeOffset)
+
+		Sets an offset (in raw int16 units) that is subtracted from the
+		vertex timestamps, with int16 wraparound. This allows for scrolling
+		the series without rewriting its vertices. The default is 0.
+	*/
+	void setTimeOffset(int timeOffset);
+	int timeOffset() const;
+
+private:
+	QColor m_color;
+	QSizeF m_itemSize;
+	float m_timeWindowStart, m_timeWindowEnd;
+	float m_valueRangeMinimum, m_valueRangeMaximum;
+	int m_timeOffset;
+};
+
+
+#endif // TIMESERIESMATERIAL_HPP
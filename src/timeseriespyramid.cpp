@@ -0,0 +1,83 @@
+#include <cassert>
+#include "timeseriespyramid.hpp"
+
+
+namespace
+{
+
+
+// The first level has columns that contain this many source
+// points on average. Since min-max downsampling keeps up to 4
+// points per column, this roughly halves the number of points.
+int const FIRST_LEVEL_POINTS_PER_COLUMN = 8;
+
+
+} // unnamed namespace end
+
+
+void TimeSeriesPyramid::build(QPointF const *sourcePoints, int numSourcePoints)
+{
+	m_numLevels = 0;
+
+	if (numSourcePoints < MIN_SOURCE_POINTS)
+		return;
+
+	double timestampSpan = sourcePoints[numSourcePoints - 1].x() - sourcePoints[0].x();
+	if (!(timestampSpan > 0.0))
+		return;
+
+	double columnWidth = timestampSpan * FIRST_LEVEL_POINTS_PER_COLUMN / numSourcePoints;
+	QPointF const *levelSourcePoints = sourcePoints;
+	int numLevelSourcePoints = numSourcePoints;
+
+	// Add levels until they get so small that simplifying them
+	// directly is cheap, or until decimation stops being effective.
+	while ((numLevelSourcePoints > MIN_LEVEL_POINTS) && (columnWidth < timestampSpan))
+	{
+		if (m_numLevels == int(m_levels.size()))
+			m_levels.emplace_back();
+
+		Level &level = m_levels[m_numLevels];
+		level.m_columnWidth = columnWidth;
+		m_simplifier.simplifyMinMax(levelSourcePoints, numLevelSourcePoints, columnWidth, level.m_points);
+
+		if (int(level.m_points.size()) >= numLevelSourcePoints)
+			break;
+
+		++m_numLevels;
+		levelSourcePoints = level.m_points.data();
+		numLevelSourcePoints = level.m_points.size();
+		columnWidth *= 2.0;
+	}
+}
+
+
+void TimeSeriesPyramid::clear()
+{
+	m_levels.clear();
+	m_numLevels = 0;
+}
+
+
+int TimeSeriesPyramid::selectLevel(double maxColumnWidth) const
+{
+	int levelIndex = m_numLevels - 1;
+	while ((levelIndex >= 0) && (m_levels[levelIndex].m_columnWidth > maxColumnWidth))
+		--levelIndex;
+
+	return levelIndex;
+}
+
+
+std::vector<QPointF> const & TimeSeriesPyramid::levelPoints(int levelIndex) const
+{
+	assert((levelIndex >= 0) && (levelIndex < m_numLevels));
+	return m_levels[levelIndex].m_points;
+}
+
+
+double TimeSeriesPyramid::levelColumnWidth(int levelIndex) const
+{
+	assert((levelIndex >= 0) && (levelIndex < m_numLevels));
+	return m_levels[levelIndex].m_columnWidth;
+}
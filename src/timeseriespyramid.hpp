@@ -0,0 +1,88 @@
+#ifndef TIMESERIESPYRAMID_HPP
+#define TIMESERIESPYRAMID_HPP
+
+#include <vector>
+#include <QPointF>
+#include "timeseriessimplifier.hpp"
+
+
+/*!
+	\class TimeSeriesPyramid
+	\brief Precomputed levels of detail of a long time series.
+
+	Simplifying a history of tens of thousands of points every time the
+	view is zoomed or panned is too slow on a watch CPU. This class
+	decimates the series once per data change into a pyramid of levels,
+	each with about half as many points as the previous one. When the
+	view is updated, the coarsest level that still has enough detail for
+	the current pixels-per-sample ratio is picked, and only that level is
+	simplified further.
+
+	Each level is the min-max downsampling (see
+	\c TimeSeriesSimplifier::simplifyMinMax()) of the previous one, with
+	twice the column width. Since the columns of the coarser level are
+	unions of the columns of the finer one, the extreme values of the
+	original series are preserved in all levels.
+
+	Series with fewer than MIN_SOURCE_POINTS points do not get any levels;
+	they are cheap enough to simplify directly.
+*/
+class TimeSeriesPyramid
+{
+public:
+	static int const MIN_SOURCE_POINTS = 4096;
+
+	/*!
+		\fn TimeSeriesPyramid::build(QPointF const *sourcePoints, int numSourcePoints)
+
+		Recreates the levels from the given source points, which must be
+		sorted by their timestamps. The vectors of the levels are reused,
+		so rebuilding does not allocate unless the series grows.
+	*/
+	void build(QPointF const *sourcePoints, int numSourcePoints);
+
+	/*!
+		\fn TimeSeriesPyramid::clear()
+
+		Removes all levels.
+	*/
+	void clear();
+
+	/*!
+		\fn TimeSeriesPyramid::selectLevel(double maxColumnWidth) const
+
+		Returns the index of the coarsest level whose column width is not
+		larger than \c maxColumnWidth, or -1 if no level is fine enough,
+		in which case the source points should be used directly.
+	*/
+	int selectLevel(double maxColumnWidth) const;
+
+	std::vector<QPointF> const & levelPoints(int levelIndex) const;
+
+	/*!
+		\fn TimeSeriesPyramid::levelColumnWidth(int levelIndex) const
+
+		Returns the column width of the given level. Consecutive points of
+		a level that lie in the same column can be up to this far apart,
+		even if the source points in between them are much closer.
+	*/
+	double levelColumnWidth(int levelIndex) const;
+
+private:
+	static int const MIN_LEVEL_POINTS = 1024;
+
+	struct Level
+	{
+		double m_columnWidth;
+		std::vector<QPointF> m_points;
+	};
+
+	TimeSeriesSimplifier m_simplifier;
+	// Levels in order from finest to coarsest. The vector may contain
+	// more entries than are in use; their vectors are kept for reuse.
+	std::vector<Level> m_levels;
+	int m_numLevels = 0;
+};
+
+
+#endif // TIMESERIESPYRAMID_HPP
@@ -0,0 +1,681 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include "simdkernels.hpp"
+#include "timeseriessimplifier.hpp"
+
+
+namespace
+{
+
+
+// The dynamic LTTB variant adjusts the buckets iteratively.
+// As suggested in the thesis, the number of iterations is
+// the average number of points per bucket times this factor.
+int const DYNAMIC_LTTB_ITERATIONS_PER_BUCKET_POINT = 10;
+
+// The incremental LTTB variant only looks for shifts of up to this many
+// points. If more points were dropped, recreating all buckets is cheap
+// in comparison to the update that caused it.
+int const MAX_INCREMENTAL_SHIFT = 16;
+
+// Timestamps in the source series are normalized int16 values (see
+// BGDataReceiver), so shifting a series in time can change a point's
+// x coordinate by up to one rounding step in either direction.
+double const INCREMENTAL_SHIFT_TOLERANCE = 2.0 / 32767.0;
+
+// Recreate all incremental buckets once their number deviates from the
+// requested number by more than this fraction (or by more than 2 buckets
+// with small bucket counts).
+double const MAX_INCREMENTAL_BUCKET_COUNT_DEVIATION = 0.1;
+
+// LTTB point selection is split into chunks of buckets that run in
+// parallel once there are at least this many source points per chunk.
+// Below that, the overhead of dispatching work to the thread pool
+// outweighs the gain.
+int const MIN_PARALLEL_CHUNK_SOURCE_POINTS = 32768;
+
+// Each chunk needs enough buckets for the seeding at its
+// start (see selectLargestTrianglePoints()) to not matter.
+int const MIN_PARALLEL_CHUNK_BUCKETS = 64;
+
+
+// Runs a chunk of work in the thread pool and signals the
+// semaphore once done. Not auto-deleted, since the caller
+// waits for all chunks and then destroys them.
+class ChunkRunnable
+	: public QRunnable
+{
+public:
+	ChunkRunnable(std::function<void()> func, QSemaphore &doneSemaphore)
+		: m_func(std::move(func))
+		, m_doneSemaphore(doneSemaphore)
+	{
+		setAutoDelete(false);
+	}
+
+	void run() override
+	{
+		m_func();
+		m_doneSemaphore.release();
+	}
+
+private:
+	std::function<void()> m_func;
+	QSemaphore &m_doneSemaphore;
+};
+
+
+QPointF averagePoint(QPointF const *points, int begin, int end)
+{
+	QPointF sum(0.0, 0.0);
+	for (int pointIndex = begin; pointIndex < end; ++pointIndex)
+		sum += points[pointIndex];
+	return sum / double(end - begin);
+}
+
+
+// Matching points have identical values, and their timestamps all
+// differ by the same amount (apart from rounding errors).
+bool shiftedPointsMatch(QPointF const *previousPoints, QPointF const *points, int numPoints, double timeShift)
+{
+	for (int pointIndex = 0; pointIndex < numPoints; ++pointIndex)
+	{
+		if ((previousPoints[pointIndex].y() != points[pointIndex].y())
+		 || (std::abs(previousPoints[pointIndex].x() - timeShift - points[pointIndex].x()) > INCREMENTAL_SHIFT_TOLERANCE))
+			return false;
+	}
+
+	return true;
+}
+
+
+} // unnamed namespace end
+
+
+// The MSc thesis with a description of LTTB and its dynamic variant
+// is found at: http://hdl.handle.net/1946/15343
+// Reference implementation: https://github.com/sveinn-steinarsson/flot-downsample
+//
+// As per the definiton of LTTB, the first and last source points are placed
+// in the first and last buckets, respectively. Those buckets only contain
+// those single points. The remaining "inner" source points are assigned to
+// the remaining "inner" buckets. Regular LTTB does this based on the index
+// of the points in the source series to produce buckets with approximately
+// the same number of points in them.
+//
+// Buckets are not stored explicitly. Instead, they are index ranges in the
+// source points array. For each bucket, one of its points becomes "selected".
+// To pick it, the points in each bucket are ranked by calculating the area
+// of the triangle that is described by the previous bucket's selected point,
+// the current point that is being evaluated, and the average of all of the
+// next bucket's points. The point with the largest triangle area "wins".
+
+
+void TimeSeriesSimplifier::simplifyLTTB(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints)
+{
+	if (handleTrivialCases(sourcePoints, numSourcePoints, numBuckets, destPoints))
+		return;
+
+	initEqualBuckets(numSourcePoints, numBuckets - 2);
+
+	m_prefixSums.resize(numSourcePoints + 1);
+	computePrefixSums(sourcePoints, numSourcePoints, m_prefixSums.data());
+
+	selectLargestTrianglePoints(sourcePoints, numSourcePoints, destPoints);
+}
+
+
+void TimeSeriesSimplifier::simplifyLTTBIncrementally(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints)
+{
+	if (handleTrivialCases(sourcePoints, numSourcePoints, numBuckets, destPoints))
+	{
+		m_hasIncrementalState = false;
+		return;
+	}
+
+	// Bucket #i is dirty if its points changed. Buckets whose points, whose
+	// next bucket's points, and whose previous bucket's selected point
+	// are all unchanged keep their selected point.
+	int numDirtyHeadBuckets = 0;
+	int firstDirtyTailBucket = 0;
+	bool previousSelectionChanged = true;
+
+	int numDroppedPoints = -1;
+	if (m_hasIncrementalState && (numBuckets == m_incrementalNumBuckets))
+		numDroppedPoints = findShift(sourcePoints, numSourcePoints);
+
+	if ((numDroppedPoints < 0) || !updateIncrementalBuckets(numDroppedPoints, numSourcePoints, numDirtyHeadBuckets, firstDirtyTailBucket))
+	{
+		// Start over with equally sized buckets, all of them dirty.
+		initEqualBuckets(numSourcePoints, numBuckets - 2);
+		m_incrementalBucketBegins = m_innerBucketBegins;
+		m_incrementalNumBuckets = numBuckets;
+		m_incrementalBucketSize = double(numSourcePoints - 2) / (numBuckets - 2);
+		m_selectedPointIndices.assign(numBuckets - 2, -1);
+		numDirtyHeadBuckets = numBuckets - 2;
+		firstDirtyTailBucket = numBuckets - 2;
+	}
+	else
+	{
+		// The first point (which is the selected point of
+		// the first bucket) only changes if points were dropped.
+		previousSelectionChanged = (numDroppedPoints > 0);
+	}
+
+	int numInnerBuckets = int(m_incrementalBucketBegins.size()) - 1;
+
+	auto isBucketDirty = [&](int innerBucketIndex) {
+		return (innerBucketIndex < numDirtyHeadBuckets) || (innerBucketIndex >= firstDirtyTailBucket);
+	};
+
+	auto innerBucketBegin = [&](int innerBucketIndex) -> int {
+		return (innerBucketIndex <= numInnerBuckets) ? m_incrementalBucketBegins[innerBucketIndex] : numSourcePoints;
+	};
+
+	for (int innerBucketIndex = 0; innerBucketIndex < numInnerBuckets; ++innerBucketIndex)
+	{
+		// The last bucket (index numInnerBuckets) only contains the
+		// last point, which is dirty if points were appended. In that
+		// case, firstDirtyTailBucket is at most numInnerBuckets - 1,
+		// so checking innerBucketIndex + 1 covers that as well.
+		if (!previousSelectionChanged && !isBucketDirty(innerBucketIndex) && !isBucketDirty(innerBucketIndex + 1))
+			continue;
+
+		int bucketBegin = innerBucketBegin(innerBucketIndex);
+		int bucketEnd = innerBucketBegin(innerBucketIndex + 1);
+		int nextBucketEnd = innerBucketBegin(innerBucketIndex + 2);
+
+		int previousSelectedPointIndex = (innerBucketIndex > 0) ? m_selectedPointIndices[innerBucketIndex - 1] : 0;
+		QPointF nextAveragePoint = averagePoint(sourcePoints, bucketEnd, nextBucketEnd);
+
+		int selectedPointIndex = findLargestTriangle(
+			sourcePoints, bucketBegin, bucketEnd,
+			sourcePoints[previousSelectedPointIndex], nextAveragePoint
+		);
+
+		previousSelectionChanged = (selectedPointIndex != m_selectedPointIndices[innerBucketIndex]);
+		m_selectedPointIndices[innerBucketIndex] = selectedPointIndex;
+	}
+
+	destPoints.push_back(sourcePoints[0]);
+	for (int selectedPointIndex : m_selectedPointIndices)
+		destPoints.push_back(sourcePoints[selectedPointIndex]);
+	destPoints.push_back(sourcePoints[numSourcePoints - 1]);
+
+	// Only keep the points that findShift() compares. These are the first
+	// bucket (plus the points that may get dropped before it) and the last
+	// inner bucket, which is where appended points go. This way, the cost
+	// of an update does not depend on the length of the series.
+	int headEnd = std::min(m_incrementalBucketBegins[1] + MAX_INCREMENTAL_SHIFT, numSourcePoints);
+	m_previousTailBegin = m_incrementalBucketBegins[numInnerBuckets - 1];
+	m_previousHeadPoints.assign(sourcePoints, sourcePoints + headEnd);
+	m_previousTailPoints.assign(sourcePoints + m_previousTailBegin, sourcePoints + numSourcePoints);
+	m_previousNumSourcePoints = numSourcePoints;
+	m_hasIncrementalState = true;
+}
+
+
+void TimeSeriesSimplifier::simplifyDynamicLTTB(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints)
+{
+	if (handleTrivialCases(sourcePoints, numSourcePoints, numBuckets, destPoints))
+		return;
+
+	initEqualBuckets(numSourcePoints, numBuckets - 2);
+
+	m_prefixSums.resize(numSourcePoints + 1);
+	computePrefixSums(sourcePoints, numSourcePoints, m_prefixSums.data());
+
+	m_prefixRegressionSums.resize(numSourcePoints + 1);
+	RegressionSums sums = { 0.0, 0.0, 0.0 };
+	m_prefixRegressionSums[0] = sums;
+	for (int pointIndex = 0; pointIndex < numSourcePoints; ++pointIndex)
+	{
+		double x = sourcePoints[pointIndex].x();
+		double y = sourcePoints[pointIndex].y();
+		sums.m_xx += x * x;
+		sums.m_xy += x * y;
+		sums.m_yy += y * y;
+		m_prefixRegressionSums[pointIndex + 1] = sums;
+	}
+
+	adjustBucketsDynamically(numSourcePoints);
+
+	selectLargestTrianglePoints(sourcePoints, numSourcePoints, destPoints);
+}
+
+
+void TimeSeriesSimplifier::simplifyMinMax(QPointF const *sourcePoints, int numSourcePoints, double columnWidth, std::vector<QPointF> &destPoints)
+{
+	destPoints.clear();
+
+	if (numSourcePoints == 0)
+		return;
+
+	if (!(columnWidth > 0.0))
+	{
+		destPoints.assign(sourcePoints, sourcePoints + numSourcePoints);
+		return;
+	}
+
+	int columnBegin = 0;
+	int minPointIndex = 0;
+	int maxPointIndex = 0;
+	double column = std::floor(sourcePoints[0].x() / columnWidth);
+
+	for (int pointIndex = 1; pointIndex <= numSourcePoints; ++pointIndex)
+	{
+		double pointColumn = (pointIndex < numSourcePoints) ? std::floor(sourcePoints[pointIndex].x() / columnWidth) : column;
+
+		if ((pointIndex == numSourcePoints) || (pointColumn != column))
+		{
+			// Column is complete. Store its points in their original order,
+			// omitting duplicates (the first point may for example also
+			// be the lowest one). Since first <= min, max <= last,
+			// only min and max need to be ordered.
+			int firstPointIndex = columnBegin;
+			int lastPointIndex = pointIndex - 1;
+			int middlePointIndex1 = std::min(minPointIndex, maxPointIndex);
+			int middlePointIndex2 = std::max(minPointIndex, maxPointIndex);
+
+			destPoints.push_back(sourcePoints[firstPointIndex]);
+			if (middlePointIndex1 > firstPointIndex)
+				destPoints.push_back(sourcePoints[middlePointIndex1]);
+			if (middlePointIndex2 > middlePointIndex1)
+				destPoints.push_back(sourcePoints[middlePointIndex2]);
+			if (lastPointIndex > middlePointIndex2)
+				destPoints.push_back(sourcePoints[lastPointIndex]);
+
+			if (pointIndex == numSourcePoints)
+				break;
+
+			column = pointColumn;
+			columnBegin = minPointIndex = maxPointIndex = pointIndex;
+			continue;
+		}
+
+		double y = sourcePoints[pointIndex].y();
+		if (y < sourcePoints[minPointIndex].y())
+			minPointIndex = pointIndex;
+		if (y > sourcePoints[maxPointIndex].y())
+			maxPointIndex = pointIndex;
+	}
+}
+
+
+void TimeSeriesSimplifier::setMaxNumThreads(int maxNumThreads)
+{
+	m_maxNumThreads = maxNumThreads;
+}
+
+
+int TimeSeriesSimplifier::maxNumThreads() const
+{
+	return m_maxNumThreads;
+}
+
+
+bool TimeSeriesSimplifier::handleTrivialCases(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints)
+{
+	destPoints.clear();
+
+	// Check for the special case where there are enough buckets to accomodate
+	// for all source series data points. If so, then just return all source points.
+	if ((numBuckets >= numSourcePoints) || (numSourcePoints <= 2))
+	{
+		destPoints.assign(sourcePoints, sourcePoints + numSourcePoints);
+		return true;
+	}
+
+	// With fewer than 3 buckets, there are no inner buckets,
+	// so only the first and last point remain.
+	if (numBuckets < 3)
+	{
+		destPoints.push_back(sourcePoints[0]);
+		destPoints.push_back(sourcePoints[numSourcePoints - 1]);
+		return true;
+	}
+
+	return false;
+}
+
+
+void TimeSeriesSimplifier::initEqualBuckets(int numSourcePoints, int numInnerBuckets)
+{
+	// Using 64-bit integers, since the product below can
+	// exceed the 32-bit range with very large series.
+	qint64 numInnerPoints = numSourcePoints - 2;
+
+	// Reserve one extra entry, since the dynamic variant temporarily
+	// has one more bucket when it splits a bucket before merging two.
+	m_innerBucketBegins.reserve(numInnerBuckets + 2);
+	m_innerBucketBegins.resize(numInnerBuckets + 1);
+
+	for (qint64 innerBucketIndex = 0; innerBucketIndex <= numInnerBuckets; ++innerBucketIndex)
+		m_innerBucketBegins[innerBucketIndex] = int(1 + (innerBucketIndex * numInnerPoints + (numInnerBuckets - 1)) / numInnerBuckets);
+}
+
+
+void TimeSeriesSimplifier::adjustBucketsDynamically(int numSourcePoints)
+{
+	// The dynamic variant starts with equally sized buckets. Then, in each
+	// iteration, the bucket whose points deviate the most from a straight
+	// line (measured by the sum of squared errors, SSE, of a linear
+	// regression) is split in two, and the two adjacent buckets with
+	// the lowest combined SSE are merged, keeping the number of
+	// buckets constant. This way, more buckets end up in parts of
+	// the series that change a lot, and fewer in flat parts.
+
+	int numInnerBuckets = int(m_innerBucketBegins.size()) - 1;
+
+	// Splitting one bucket and merging two others requires at least 3 buckets.
+	if (numInnerBuckets < 3)
+		return;
+
+	int numIterations = (numSourcePoints / (numInnerBuckets + 2)) * DYNAMIC_LTTB_ITERATIONS_PER_BUCKET_POINT;
+
+	m_innerBucketErrors.resize(numInnerBuckets);
+
+	for (int iteration = 0; iteration < numIterations; ++iteration)
+	{
+		for (int innerBucketIndex = 0; innerBucketIndex < numInnerBuckets; ++innerBucketIndex)
+			m_innerBucketErrors[innerBucketIndex] = bucketError(innerBucketIndex);
+
+		int splitBucketIndex = -1;
+		for (int innerBucketIndex = 0; innerBucketIndex < numInnerBuckets; ++innerBucketIndex)
+		{
+			int bucketSize = m_innerBucketBegins[innerBucketIndex + 1] - m_innerBucketBegins[innerBucketIndex];
+			if ((bucketSize >= 2) && ((splitBucketIndex < 0) || (m_innerBucketErrors[innerBucketIndex] > m_innerBucketErrors[splitBucketIndex])))
+				splitBucketIndex = innerBucketIndex;
+		}
+
+		if (splitBucketIndex < 0)
+			break;
+
+		int mergeBucketIndex = -1;
+		double lowestMergedError = 0.0;
+		for (int innerBucketIndex = 0; innerBucketIndex < (numInnerBuckets - 1); ++innerBucketIndex)
+		{
+			if ((innerBucketIndex == splitBucketIndex) || ((innerBucketIndex + 1) == splitBucketIndex))
+				continue;
+
+			double mergedError = m_innerBucketErrors[innerBucketIndex] + m_innerBucketErrors[innerBucketIndex + 1];
+			if ((mergeBucketIndex < 0) || (mergedError < lowestMergedError))
+			{
+				mergeBucketIndex = innerBucketIndex;
+				lowestMergedError = mergedError;
+			}
+		}
+
+		// Stop once merging would not cost less than splitting gains,
+		// since further iterations would only shuffle buckets around.
+		if ((mergeBucketIndex < 0) || (lowestMergedError >= m_innerBucketErrors[splitBucketIndex]))
+			break;
+
+		int splitBegin = m_innerBucketBegins[splitBucketIndex];
+		int splitEnd = m_innerBucketBegins[splitBucketIndex + 1];
+
+		// Insert the begin of the second half of the split bucket, then remove
+		// the begin of the second merged bucket. The latter's position moves
+		// by one if the insertion happened before it.
+		m_innerBucketBegins.insert(m_innerBucketBegins.begin() + splitBucketIndex + 1, (splitBegin + splitEnd) / 2);
+		int removedBeginIndex = mergeBucketIndex + 1 + ((splitBucketIndex < mergeBucketIndex) ? 1 : 0);
+		m_innerBucketBegins.erase(m_innerBucketBegins.begin() + removedBeginIndex);
+	}
+}
+
+
+double TimeSeriesSimplifier::bucketError(int innerBucketIndex) const
+{
+	// As described in the thesis, the regression includes the last point
+	// of the previous bucket and the first point of the next bucket.
+	int begin = m_innerBucketBegins[innerBucketIndex] - 1;
+	int end = m_innerBucketBegins[innerBucketIndex + 1] + 1;
+
+	double count = end - begin;
+	QPointF sum = m_prefixSums[end] - m_prefixSums[begin];
+	double sumXX = m_prefixRegressionSums[end].m_xx - m_prefixRegressionSums[begin].m_xx;
+	double sumXY = m_prefixRegressionSums[end].m_xy - m_prefixRegressionSums[begin].m_xy;
+	double sumYY = m_prefixRegressionSums[end].m_yy - m_prefixRegressionSums[begin].m_yy;
+
+	// SSE of the least squares line, computed from the sums.
+	double varianceX = sumXX - sum.x() * sum.x() / count;
+	double covarianceXY = sumXY - sum.x() * sum.y() / count;
+	double varianceY = sumYY - sum.y() * sum.y() / count;
+
+	double error = varianceY;
+	if (varianceX > 0.0)
+		error -= covarianceXY * covarianceXY / varianceX;
+
+	// Rounding errors can produce slightly negative values.
+	return std::max(error, 0.0);
+}
+
+
+void TimeSeriesSimplifier::selectLargestTrianglePoints(QPointF const *sourcePoints, int numSourcePoints, std::vector<QPointF> &destPoints)
+{
+	int numInnerBuckets = int(m_innerBucketBegins.size()) - 1;
+
+	destPoints.resize(numInnerBuckets + 2);
+	destPoints[0] = sourcePoints[0];
+	destPoints[numInnerBuckets + 1] = sourcePoints[numSourcePoints - 1];
+
+	int numChunks = 1;
+	if (m_maxNumThreads != 1)
+	{
+		int maxNumThreads = (m_maxNumThreads > 0) ? m_maxNumThreads : QThreadPool::globalInstance()->maxThreadCount();
+		numChunks = std::min({
+			maxNumThreads,
+			numSourcePoints / MIN_PARALLEL_CHUNK_SOURCE_POINTS,
+			numInnerBuckets / MIN_PARALLEL_CHUNK_BUCKETS
+		});
+		numChunks = std::max(numChunks, 1);
+	}
+
+	if (numChunks == 1)
+	{
+		selectLargestTrianglePointsInChunk(sourcePoints, numSourcePoints, 0, numInnerBuckets, sourcePoints[0], destPoints.data() + 1);
+		return;
+	}
+
+	// In LTTB, the point selected in a bucket depends on the point selected
+	// in the previous bucket, so the buckets cannot be processed
+	// independently. To process chunks of buckets in parallel anyway,
+	// each chunk except for the first one is seeded with the average of
+	// the points in the bucket before it instead of that bucket's selected
+	// point. Afterwards, the buckets at the start of each chunk are fixed
+	// up sequentially (see below).
+	QSemaphore doneSemaphore;
+	std::vector<std::unique_ptr<ChunkRunnable>> runnables;
+	runnables.reserve(numChunks - 1);
+
+	for (int chunkIndex = 1; chunkIndex < numChunks; ++chunkIndex)
+	{
+		int firstInnerBucket = int(qint64(chunkIndex) * numInnerBuckets / numChunks);
+		int endInnerBucket = int(qint64(chunkIndex + 1) * numInnerBuckets / numChunks);
+
+		int seedBucketBegin = m_innerBucketBegins[firstInnerBucket - 1];
+		int seedBucketEnd = m_innerBucketBegins[firstInnerBucket];
+		QPointF seedPoint = (m_prefixSums[seedBucketEnd] - m_prefixSums[seedBucketBegin]) / double(seedBucketEnd - seedBucketBegin);
+
+		QPointF *chunkDestPoints = destPoints.data() + 1 + firstInnerBucket;
+		runnables.emplace_back(new ChunkRunnable([=]() {
+			selectLargestTrianglePointsInChunk(sourcePoints, numSourcePoints, firstInnerBucket, endInnerBucket, seedPoint, chunkDestPoints);
+		}, doneSemaphore));
+
+		// If the pool has no free thread, run the chunk here instead of
+		// queuing it. This way, the caller never waits for unrelated work.
+		if (!QThreadPool::globalInstance()->tryStart(runnables.back().get()))
+			runnables.back()->run();
+	}
+
+	// The first chunk is processed by the calling thread.
+	selectLargestTrianglePointsInChunk(sourcePoints, numSourcePoints, 0, numInnerBuckets / numChunks, sourcePoints[0], destPoints.data() + 1);
+
+	doneSemaphore.acquire(numChunks - 1);
+
+	// Now that the last selected point of the previous chunk is known,
+	// redo the selection at the start of each chunk until it agrees with
+	// the seeded one. From that bucket on, both selections are identical,
+	// since each selection only depends on the previous selected point.
+	// This usually takes a few buckets, and makes the result identical
+	// to that of the sequential selection. The coordinates are compared
+	// exactly, since QPointF's operator== is fuzzy and would consider
+	// nearby points equal, ending the fixup too early.
+	int fixupInnerBucket = 0;
+	for (int chunkIndex = 1; chunkIndex < numChunks; ++chunkIndex)
+	{
+		fixupInnerBucket = std::max(fixupInnerBucket, int(qint64(chunkIndex) * numInnerBuckets / numChunks));
+
+		for (; fixupInnerBucket < numInnerBuckets; ++fixupInnerBucket)
+		{
+			// destPoints[i + 1] is the point selected in inner bucket #i.
+			QPointF const &previousSelectedPoint = destPoints[fixupInnerBucket];
+			QPointF const &selectedPoint = sourcePoints[selectLargestTrianglePoint(sourcePoints, numSourcePoints, fixupInnerBucket, previousSelectedPoint)];
+			QPointF const &seededSelectedPoint = destPoints[fixupInnerBucket + 1];
+			if ((selectedPoint.x() == seededSelectedPoint.x()) && (selectedPoint.y() == seededSelectedPoint.y()))
+				break;
+			destPoints[fixupInnerBucket + 1] = selectedPoint;
+		}
+	}
+}
+
+
+void TimeSeriesSimplifier::selectLargestTrianglePointsInChunk(QPointF const *sourcePoints, int numSourcePoints, int firstInnerBucket, int endInnerBucket, QPointF previousSelectedPoint, QPointF *destPoints) const
+{
+	for (int innerBucketIndex = firstInnerBucket; innerBucketIndex < endInnerBucket; ++innerBucketIndex)
+	{
+		int selectedPointIndex = selectLargestTrianglePoint(sourcePoints, numSourcePoints, innerBucketIndex, previousSelectedPoint);
+		*destPoints++ = sourcePoints[selectedPointIndex];
+		previousSelectedPoint = sourcePoints[selectedPointIndex];
+	}
+}
+
+
+int TimeSeriesSimplifier::selectLargestTrianglePoint(QPointF const *sourcePoints, int numSourcePoints, int innerBucketIndex, QPointF const &previousSelectedPoint) const
+{
+	int numInnerBuckets = int(m_innerBucketBegins.size()) - 1;
+
+	// Returns the index of the first source point in the given inner bucket.
+	// Inner bucket #numInnerBuckets is the last bucket, which only contains
+	// the last source point.
+	auto innerBucketBegin = [&](int index) -> int {
+		return (index <= numInnerBuckets) ? m_innerBucketBegins[index] : numSourcePoints;
+	};
+
+	int bucketBegin = innerBucketBegin(innerBucketIndex);
+	int bucketEnd = innerBucketBegin(innerBucketIndex + 1);
+	int nextBucketEnd = innerBucketBegin(innerBucketIndex + 2);
+
+	double numNextBucketPoints = nextBucketEnd - bucketEnd;
+	QPointF nextAveragePoint = (m_prefixSums[nextBucketEnd] - m_prefixSums[bucketEnd]) / numNextBucketPoints;
+
+	return findLargestTriangle(
+		sourcePoints, bucketBegin, bucketEnd,
+		previousSelectedPoint, nextAveragePoint
+	);
+}
+
+
+int TimeSeriesSimplifier::findShift(QPointF const *sourcePoints, int numSourcePoints) const
+{
+	// Look for the smallest number of dropped points for which the
+	// remaining previous points match the first new points. Only the
+	// start of the series and its last bucket are compared; the points
+	// in between are assumed to be unchanged if these match.
+
+	int maxNumDroppedPoints = std::min(MAX_INCREMENTAL_SHIFT, m_previousNumSourcePoints - 2);
+
+	for (int numDroppedPoints = 0; numDroppedPoints <= maxNumDroppedPoints; ++numDroppedPoints)
+	{
+		int numRetainedPoints = m_previousNumSourcePoints - numDroppedPoints;
+		if (numRetainedPoints > numSourcePoints)
+			continue;
+
+		double timeShift = m_previousHeadPoints[numDroppedPoints].x() - sourcePoints[0].x();
+
+		int numHeadPoints = int(m_previousHeadPoints.size()) - numDroppedPoints;
+		if (!shiftedPointsMatch(m_previousHeadPoints.data() + numDroppedPoints, sourcePoints, numHeadPoints, timeShift))
+			continue;
+
+		int tailBegin = std::max(m_previousTailBegin, numDroppedPoints);
+		int numTailPoints = m_previousNumSourcePoints - tailBegin;
+		if (!shiftedPointsMatch(m_previousTailPoints.data() + (tailBegin - m_previousTailBegin), sourcePoints + (tailBegin - numDroppedPoints), numTailPoints, timeShift))
+			continue;
+
+		return numDroppedPoints;
+	}
+
+	return -1;
+}
+
+
+bool TimeSeriesSimplifier::updateIncrementalBuckets(int numDroppedPoints, int numSourcePoints, int &numDirtyHeadBuckets, int &firstDirtyTailBucket)
+{
+	int lastRetainedPointIndex = m_previousNumSourcePoints - 1 - numDroppedPoints;
+	int roundedBucketSize = std::max(int(std::lround(m_incrementalBucketSize)), 1);
+
+	// Move the buckets along with the points they contain.
+	for (int &bucketBegin : m_incrementalBucketBegins)
+		bucketBegin -= numDroppedPoints;
+	for (int &selectedPointIndex : m_selectedPointIndices)
+		selectedPointIndex -= numDroppedPoints;
+
+	numDirtyHeadBuckets = 0;
+
+	if (numDroppedPoints > 0)
+	{
+		// Remove the buckets whose points were all dropped, or which
+		// only contain the point that is now the first point.
+		int numRemovedBuckets = 0;
+		while (((numRemovedBuckets + 1) < int(m_incrementalBucketBegins.size())) && (m_incrementalBucketBegins[numRemovedBuckets + 1] <= 1))
+			++numRemovedBuckets;
+
+		if ((numRemovedBuckets + 1) >= int(m_incrementalBucketBegins.size()))
+			return false;
+
+		m_incrementalBucketBegins.erase(m_incrementalBucketBegins.begin(), m_incrementalBucketBegins.begin() + numRemovedBuckets);
+		m_selectedPointIndices.erase(m_selectedPointIndices.begin(), m_selectedPointIndices.begin() + numRemovedBuckets);
+		m_incrementalBucketBegins[0] = 1;
+
+		// Merge what is left of the first bucket into the second one if
+		// it became too small, to not end up with tiny buckets at the start.
+		int firstBucketSize = m_incrementalBucketBegins[1] - m_incrementalBucketBegins[0];
+		if (((firstBucketSize * 2) < roundedBucketSize) && (m_incrementalBucketBegins.size() > 2))
+		{
+			m_incrementalBucketBegins.erase(m_incrementalBucketBegins.begin() + 1);
+			m_selectedPointIndices.erase(m_selectedPointIndices.begin() + 1);
+		}
+
+		numDirtyHeadBuckets = 1;
+	}
+
+	int numInnerBuckets = int(m_incrementalBucketBegins.size()) - 1;
+	firstDirtyTailBucket = numInnerBuckets + 1;
+
+	if ((numSourcePoints - 1) > lastRetainedPointIndex)
+	{
+		// Points were appended. The previous last point becomes an inner
+		// point, and goes into the last inner bucket along with the new
+		// points. If that bucket becomes too large, split it up.
+		firstDirtyTailBucket = numInnerBuckets - 1;
+		m_incrementalBucketBegins.back() = numSourcePoints - 1;
+
+		while ((m_incrementalBucketBegins.back() - m_incrementalBucketBegins[m_incrementalBucketBegins.size() - 2]) >= (roundedBucketSize * 2))
+		{
+			int newBucketBegin = m_incrementalBucketBegins[m_incrementalBucketBegins.size() - 2] + roundedBucketSize;
+			m_incrementalBucketBegins.insert(m_incrementalBucketBegins.end() - 1, newBucketBegin);
+			m_selectedPointIndices.push_back(-1);
+		}
+	}
+
+	numInnerBuckets = int(m_incrementalBucketBegins.size()) - 1;
+	int requestedNumInnerBuckets = m_incrementalNumBuckets - 2;
+	int maxDeviation = std::max(int(requestedNumInnerBuckets * MAX_INCREMENTAL_BUCKET_COUNT_DEVIATION), 2);
+
+	return std::abs(numInnerBuckets - requestedNumInnerBuckets) <= maxDeviation;
+}
@@ -0,0 +1,160 @@
+#ifndef TIMESERIESSIMPLIFIER_HPP
+#define TIMESERIESSIMPLIFIER_HPP
+
+#include <vector>
+#include <QPointF>
+
+
+/*!
+	\class TimeSeriesSimplifier
+	\brief Downsamples time series for display.
+
+	These downsampling algorithms are available:
+
+	\list
+		\li Sveinn Steinarsson’s Largest-Triangle-Three-Buckets (LTTB) algorithm.
+		\li Its dynamic variant, which uses smaller buckets where the series
+			changes a lot and larger ones where it is mostly flat.
+		\li Min-max downsampling (also known as M4), which keeps the first,
+			last, lowest and highest point in each column. Unlike LTTB, this
+			never drops extreme values.
+	\endlist
+
+	The simplifier works on contiguous arrays of points and keeps its scratch
+	buffers between calls. All algorithms share these buffers. After they have
+	grown to the size of the largest series that was simplified so far,
+	simplification does not allocate any memory anymore (provided that the
+	caller also reuses the destination vector). For this reason, an instance
+	should be kept around for as long as series are simplified, instead of
+	creating one per call.
+
+	In all cases, the source points must be sorted by their timestamps
+	(x coordinates).
+
+	For very large series (week- or month-long histories), the point
+	selection of \c simplifyLTTB() and \c simplifyDynamicLTTB() is split
+	into chunks of buckets that are processed in parallel by the global
+	QThreadPool. This happens automatically once there are enough source
+	points per chunk; see \c setMaxNumThreads().
+*/
+class TimeSeriesSimplifier
+{
+public:
+	/*!
+		\fn TimeSeriesSimplifier::simplifyLTTB(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints)
+
+		Simplifies the source points to \c numBuckets points with LTTB, which
+		are stored in \c destPoints. If \c numBuckets is not smaller than
+		\c numSourcePoints, all source points are copied unchanged.
+	*/
+	void simplifyLTTB(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints);
+
+	/*!
+		\fn TimeSeriesSimplifier::simplifyLTTBIncrementally(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints)
+
+		Like \c simplifyLTTB(), except that the result of the previous call
+		is reused if possible. This is the case if the new source points are
+		the previous ones shifted in time, with points dropped at the start
+		and/or new points appended at the end, which is what happens when a
+		new reading arrives. Then, only the buckets at the start and end are
+		updated, and the buckets in between keep their selected points.
+
+		To make this possible, the buckets stay anchored to the points they
+		were created for instead of being redistributed equally every time.
+		The number of buckets may therefore temporarily differ slightly from
+		\c numBuckets. If it deviates too much, or if \c numBuckets changes,
+		all buckets are recreated.
+
+		To keep the cost of an update proportional to the number of changed
+		points, only the start of the series and its last bucket are compared
+		with the previous source points. Points in between that change while
+		these stay the same are not detected. Series that only lose points at
+		the start and gain points at the end are not affected by this.
+	*/
+	void simplifyLTTBIncrementally(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints);
+
+	/*!
+		\fn TimeSeriesSimplifier::simplifyDynamicLTTB(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints)
+
+		Like \c simplifyLTTB(), except that the bucket sizes are adjusted
+		to the series before the points are selected.
+	*/
+	void simplifyDynamicLTTB(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints);
+
+	/*!
+		\fn TimeSeriesSimplifier::simplifyMinMax(QPointF const *sourcePoints, int numSourcePoints, double columnWidth, std::vector<QPointF> &destPoints)
+
+		Simplifies the source points with min-max downsampling. Points whose x
+		coordinates lie in the same multiple of \c columnWidth form a column.
+		Up to 4 points of each column are stored in \c destPoints: the first,
+		the last, and the ones with the lowest and highest y coordinate.
+	*/
+	void simplifyMinMax(QPointF const *sourcePoints, int numSourcePoints, double columnWidth, std::vector<QPointF> &destPoints);
+
+	/*!
+		\fn TimeSeriesSimplifier::setMaxNumThreads(int maxNumThreads)
+
+		Limits the number of threads (including the calling one) that
+		LTTB point selection may use. 0 means that the maximum thread
+		count of the global QThreadPool is used, which is the default.
+		1 disables parallel processing.
+
+		The selected points are the same with and without parallel
+		processing.
+	*/
+	void setMaxNumThreads(int maxNumThreads);
+	int maxNumThreads() const;
+
+private:
+	// Sums of products of the coordinates, used for the linear
+	// regressions that the dynamic LTTB variant performs.
+	struct RegressionSums
+	{
+		double m_xx;
+		double m_xy;
+		double m_yy;
+	};
+
+	bool handleTrivialCases(QPointF const *sourcePoints, int numSourcePoints, int numBuckets, std::vector<QPointF> &destPoints);
+	void initEqualBuckets(int numSourcePoints, int numInnerBuckets);
+	void adjustBucketsDynamically(int numSourcePoints);
+	double bucketError(int innerBucketIndex) const;
+	void selectLargestTrianglePoints(QPointF const *sourcePoints, int numSourcePoints, std::vector<QPointF> &destPoints);
+	void selectLargestTrianglePointsInChunk(QPointF const *sourcePoints, int numSourcePoints, int firstInnerBucket, int endInnerBucket, QPointF previousSelectedPoint, QPointF *destPoints) const;
+	int selectLargestTrianglePoint(QPointF const *sourcePoints, int numSourcePoints, int innerBucketIndex, QPointF const &previousSelectedPoint) const;
+	int findShift(QPointF const *sourcePoints, int numSourcePoints) const;
+	bool updateIncrementalBuckets(int numDroppedPoints, int numSourcePoints, int &numDirtyHeadBuckets, int &firstDirtyTailBucket);
+
+	// m_prefixSums[i] contains the sum of the first i source points.
+	// This allows for computing the average of any range of points in O(1).
+	std::vector<QPointF> m_prefixSums;
+	// Same as m_prefixSums, but for the products of the coordinates.
+	// These are only filled by the dynamic LTTB variant.
+	std::vector<RegressionSums> m_prefixRegressionSums;
+
+	// m_innerBucketBegins[i] is the index of the first source point in
+	// inner bucket #i. The last entry is the index of the last source
+	// point, which is the only point in the last bucket.
+	std::vector<int> m_innerBucketBegins;
+	std::vector<double> m_innerBucketErrors;
+
+	// State of the incremental LTTB variant. This is kept separate from
+	// m_innerBucketBegins, since the other variants overwrite the latter.
+	// m_incrementalBucketBegins and m_selectedPointIndices contain
+	// indices into the previous source points. Of these, only the
+	// first ones and the ones from m_previousTailBegin on are kept.
+	bool m_hasIncrementalState = false;
+	int m_incrementalNumBuckets = 0;
+	double m_incrementalBucketSize = 0.0;
+	std::vector<int> m_incrementalBucketBegins;
+	std::vector<int> m_selectedPointIndices;
+	int m_previousNumSourcePoints = 0;
+	int m_previousTailBegin = 0;
+	std::vector<QPointF> m_previousHeadPoints;
+	std::vector<QPointF> m_previousTailPoints;
+
+	int m_maxNumThreads = 0;
+};
+
+
+#endif // TIMESERIESSIMPLIFIER_HPP
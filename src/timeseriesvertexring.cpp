@@ -0,0 +1,301 @@
+#include <algorithm>
+#include "timeseriesvertexring.hpp"
+
+
+namespace
+{
+
+
+// How many points at the start of the new series, and how many points
+// beyond that in the previous series, are searched for the first point
+// that both have in common. New readings only drop a few points at the
+// start, and LTTB only selects different points in the first few buckets,
+// so the common points are found close to the start.
+int const MAX_CHANGED_HEAD_POINTS = 8;
+int const MAX_DROPPED_HEAD_POINTS = 24;
+
+// Headroom for growing series, so that a series that grows by
+// a few points does not immediately require a rebuild.
+int const MIN_NUM_SPARE_SLOTS = 16;
+
+
+qint16 wrapToInt16(int value)
+{
+	return qint16(quint16(value & 0xFFFF));
+}
+
+
+// Returns true if the segment that ends at the given point spans a gap.
+bool isGapBefore(std::vector<int> const &gapIndices, int pointIndex)
+{
+	return std::binary_search(gapIndices.begin(), gapIndices.end(), pointIndex);
+}
+
+
+// Merges the range with the last one if they are adjacent, which is
+// the common case when several segments are appended.
+void appendVertexRange(std::vector<TimeSeriesVertexRing::VertexRange> &ranges, int begin, int end)
+{
+	if (!ranges.empty() && (ranges.back().m_end == begin))
+		ranges.back().m_end = end;
+	else
+		ranges.push_back({ begin, end });
+}
+
+
+} // unnamed namespace end
+
+
+void TimeSeriesVertexRing::update(std::vector<Vertex> const &points, std::vector<int> const &gapIndices)
+{
+	m_isFullyDirty = false;
+	m_dirtyVertexRanges.clear();
+
+	int numSegments = std::max(int(points.size()) - 1, 0);
+
+	int firstOldPointIndex, firstNewPointIndex, numRunPoints, timeShift;
+	if ((numSegments > m_numSlots) || !findRetainedRun(points, gapIndices, firstOldPointIndex, firstNewPointIndex, numRunPoints, timeShift))
+	{
+		rebuild(points, gapIndices);
+		return;
+	}
+
+	// Timestamps of retained points decrease by timeShift. Growing the
+	// offset by the same amount moves their segments along without
+	// rewriting them. New segments are stored with the new offset.
+	m_timeOffset = (m_timeOffset + timeShift) & 0xFFFF;
+
+	// Old segments before and after the retained run are freed. The run
+	// consists of segments firstOldPointIndex to firstOldPointIndex +
+	// numRunPoints - 2 (in the order of the old series).
+	int numOldSegments = m_numUsedSlots;
+	int numFreedHeadSegments = firstOldPointIndex;
+	int numFreedTailSegments = numOldSegments - numFreedHeadSegments - (numRunPoints - 1);
+
+	for (int i = 0; i < numFreedHeadSegments; ++i)
+		clearSlot((m_firstUsedSlot + i) % m_numSlots);
+	for (int i = 0; i < numFreedTailSegments; ++i)
+		clearSlot((m_firstUsedSlot + numOldSegments - 1 - i) % m_numSlots);
+
+	m_firstUsedSlot = (m_firstUsedSlot + numFreedHeadSegments) % m_numSlots;
+	m_numUsedSlots = numRunPoints - 1;
+
+	// New segments before the run are prepended (in reverse order,
+	// since each one goes before the previous one), and new segments
+	// after the run are appended.
+	for (int pointIndex = firstNewPointIndex - 1; pointIndex >= 0; --pointIndex)
+	{
+		m_firstUsedSlot = (m_firstUsedSlot + m_numSlots - 1) % m_numSlots;
+		++m_numUsedSlots;
+		writeSegment(m_firstUsedSlot, points[pointIndex], points[pointIndex + 1], isGapBefore(gapIndices, pointIndex + 1));
+	}
+
+	for (int pointIndex = firstNewPointIndex + numRunPoints - 1; pointIndex < numSegments; ++pointIndex)
+	{
+		writeSegment((m_firstUsedSlot + m_numUsedSlots) % m_numSlots, points[pointIndex], points[pointIndex + 1], isGapBefore(gapIndices, pointIndex + 1));
+		++m_numUsedSlots;
+	}
+
+	m_points = points;
+	m_gapIndices = gapIndices;
+}
+
+
+void TimeSeriesVertexRing::clear()
+{
+	m_vertices.clear();
+	m_numSlots = 0;
+	m_firstUsedSlot = 0;
+	m_numUsedSlots = 0;
+	m_timeOffset = 0;
+	m_points.clear();
+	m_gapIndices.clear();
+	m_isFullyDirty = true;
+	m_dirtyVertexRanges.clear();
+
+	for (SharedVertices &sharedVertices : m_sharedVertices)
+		sharedVertices = SharedVertices();
+	m_lastPublishedIndex = -1;
+}
+
+
+std::vector<TimeSeriesVertexRing::Vertex> const & TimeSeriesVertexRing::vertices() const
+{
+	return m_vertices;
+}
+
+
+int TimeSeriesVertexRing::timeOffset() const
+{
+	return m_timeOffset;
+}
+
+
+bool TimeSeriesVertexRing::isFullyDirty() const
+{
+	return m_isFullyDirty;
+}
+
+
+std::vector<TimeSeriesVertexRing::VertexRange> const & TimeSeriesVertexRing::dirtyVertexRanges() const
+{
+	return m_dirtyVertexRanges;
+}
+
+
+std::shared_ptr<std::vector<TimeSeriesVertexRing::Vertex> const> TimeSeriesVertexRing::publishVertices()
+{
+	// The buffer that was published last is still in use, since it is
+	// referenced by the current render data, so the other one is filled.
+	// Once the render thread has picked up the newer render data, nothing
+	// references the other buffer anymore, and it can be updated in place.
+	// If it is still referenced (for example because the GUI thread
+	// publishes several times in between two syncs), a new one is used.
+	int index = (m_lastPublishedIndex == 0) ? 1 : 0;
+	SharedVertices &sharedVertices = m_sharedVertices[index];
+
+	if (!sharedVertices.m_vertices || (sharedVertices.m_vertices.use_count() > 1))
+	{
+		sharedVertices.m_vertices = std::make_shared<std::vector<Vertex>>(m_vertices);
+	}
+	else if (sharedVertices.m_isFullyDirty || (sharedVertices.m_vertices->size() != m_vertices.size()))
+	{
+		*(sharedVertices.m_vertices) = m_vertices;
+	}
+	else
+	{
+		std::vector<Vertex> &destVertices = *(sharedVertices.m_vertices);
+		for (VertexRange const &range : sharedVertices.m_dirtyVertexRanges)
+			std::copy(m_vertices.begin() + range.m_begin, m_vertices.begin() + range.m_end, destVertices.begin() + range.m_begin);
+	}
+
+	sharedVertices.m_isFullyDirty = false;
+	sharedVertices.m_dirtyVertexRanges.clear();
+	m_lastPublishedIndex = index;
+
+	return sharedVertices.m_vertices;
+}
+
+
+void TimeSeriesVertexRing::rebuild(std::vector<Vertex> const &points, std::vector<int> const &gapIndices)
+{
+	int numSegments = std::max(int(points.size()) - 1, 0);
+
+	// Keep the number of slots if possible, so that the
+	// geometry does not have to be reallocated.
+	if (numSegments > m_numSlots)
+		m_numSlots = numSegments + std::max(numSegments / 4, MIN_NUM_SPARE_SLOTS);
+
+	m_vertices.assign(m_numSlots * 2, Vertex { 0, 0 });
+	m_firstUsedSlot = 0;
+	m_numUsedSlots = numSegments;
+	m_timeOffset = 0;
+
+	// Set before writing the segments, so that
+	// they do not get listed as dirty ranges.
+	m_isFullyDirty = true;
+	m_dirtyVertexRanges.clear();
+	markAllSharedVerticesDirty();
+
+	for (int segmentIndex = 0; segmentIndex < numSegments; ++segmentIndex)
+		writeSegment(segmentIndex, points[segmentIndex], points[segmentIndex + 1], isGapBefore(gapIndices, segmentIndex + 1));
+
+	m_points = points;
+	m_gapIndices = gapIndices;
+}
+
+
+bool TimeSeriesVertexRing::findRetainedRun(std::vector<Vertex> const &points, std::vector<int> const &gapIndices, int &firstOldPointIndex, int &firstNewPointIndex, int &numRunPoints, int &timeShift) const
+{
+	// Find the longest run of consecutive points that exist in both the old
+	// and the new series, with identical values, timestamps that differ
+	// by the same amount, and gaps in the same places. Only the first
+	// points of both series are tried as the start of the run; see
+	// MAX_CHANGED_HEAD_POINTS for why.
+
+	int numOldPoints = m_points.size();
+	int numNewPoints = points.size();
+
+	numRunPoints = 0;
+
+	for (int newPointIndex = 0; newPointIndex < std::min(numNewPoints, MAX_CHANGED_HEAD_POINTS); ++newPointIndex)
+	{
+		int maxOldPointIndex = std::min(numOldPoints, newPointIndex + MAX_DROPPED_HEAD_POINTS);
+
+		for (int oldPointIndex = 0; oldPointIndex < maxOldPointIndex; ++oldPointIndex)
+		{
+			if (m_points[oldPointIndex].m_value != points[newPointIndex].m_value)
+				continue;
+
+			int candidateTimeShift = m_points[oldPointIndex].m_timestamp - points[newPointIndex].m_timestamp;
+
+			int length = 1;
+			while (((oldPointIndex + length) < numOldPoints) && ((newPointIndex + length) < numNewPoints))
+			{
+				Vertex const &oldPoint = m_points[oldPointIndex + length];
+				Vertex const &newPoint = points[newPointIndex + length];
+				if ((oldPoint.m_value != newPoint.m_value) || ((oldPoint.m_timestamp - newPoint.m_timestamp) != candidateTimeShift))
+					break;
+				if (isGapBefore(m_gapIndices, oldPointIndex + length) != isGapBefore(gapIndices, newPointIndex + length))
+					break;
+				++length;
+			}
+
+			if (length > numRunPoints)
+			{
+				firstOldPointIndex = oldPointIndex;
+				firstNewPointIndex = newPointIndex;
+				numRunPoints = length;
+				timeShift = candidateTimeShift;
+			}
+		}
+	}
+
+	// A run must contain at least one segment to be of any use.
+	return (numRunPoints >= 2);
+}
+
+
+void TimeSeriesVertexRing::writeSegment(int slot, Vertex const &start, Vertex const &end, bool isGap)
+{
+	// Segments across gaps are stored with zero length, like free slots.
+	Vertex const &actualEnd = isGap ? start : end;
+	m_vertices[slot * 2 + 0] = { wrapToInt16(start.m_timestamp + m_timeOffset), start.m_value };
+	m_vertices[slot * 2 + 1] = { wrapToInt16(actualEnd.m_timestamp + m_timeOffset), actualEnd.m_value };
+	markSlotDirty(slot);
+}
+
+
+void TimeSeriesVertexRing::clearSlot(int slot)
+{
+	// A zero-length segment produces no fragments.
+	m_vertices[slot * 2 + 1] = m_vertices[slot * 2];
+	markSlotDirty(slot);
+}
+
+
+void TimeSeriesVertexRing::markSlotDirty(int slot)
+{
+	int vertexIndex = slot * 2;
+
+	if (!m_isFullyDirty)
+		appendVertexRange(m_dirtyVertexRanges, vertexIndex, vertexIndex + 2);
+
+	// The shared buffers collect the changes of all updates
+	// since they were last filled by publishVertices().
+	for (SharedVertices &sharedVertices : m_sharedVertices)
+	{
+		if (!sharedVertices.m_isFullyDirty)
+			appendVertexRange(sharedVertices.m_dirtyVertexRanges, vertexIndex, vertexIndex + 2);
+	}
+}
+
+
+void TimeSeriesVertexRing::markAllSharedVerticesDirty()
+{
+	for (SharedVertices &sharedVertices : m_sharedVertices)
+	{
+		sharedVertices.m_isFullyDirty = true;
+		sharedVertices.m_dirtyVertexRanges.clear();
+	}
+}
@@ -0,0 +1,125 @@
+#ifndef TIMESERIESVERTEXRING_HPP
+#define TIMESERIESVERTEXRING_HPP
+
+#include <memory>
+#include <vector>
+#include "timeseriesmaterial.hpp"
+
+
+/*!
+	\class TimeSeriesVertexRing
+	\brief Keeps the line segments of a scrolling time series in a ring buffer.
+
+	Over time, a BG time series mostly scrolls to the left: the oldest
+	points are dropped, a new point is appended, and the timestamps of
+	all other points decrease by the same amount. Rewriting all vertices
+	every time is wasteful in that case.
+
+	This class stores the series as individual line segments (2 vertices
+	each, to be drawn with DrawLines) in a fixed number of slots. The
+	slots that are in use form a contiguous range in a ring. When the
+	series is updated, segments that are still present are left alone.
+	Dropped segments at the start free their slots, and new segments are
+	written into free slots before or after the retained ones. Unused
+	slots contain zero-length segments, which are not drawn. The same is
+	used for gaps in the series: the segment that would connect the
+	points on either side of a gap is stored as a zero-length segment,
+	so all parts of the series are still drawn with one draw call.
+
+	Timestamps are stored relative to a time offset that grows as the
+	series scrolls, with int16 wraparound. The renderer subtracts
+	\c timeOffset() (see \c TimeSeriesMaterial::setTimeOffset()), so
+	retained segments move left without being rewritten.
+
+	After each update, \c dirtyVertexRanges() lists the vertices that
+	were written, unless \c isFullyDirty() is true, in which case
+	all vertices were rewritten.
+
+	\c publishVertices() hands the vertices to the render thread. To not
+	copy the whole ring every time, it alternates between two buffers,
+	and only rewrites the vertices that changed since the buffer was
+	published last. A buffer is only reused once the render thread no
+	longer references it.
+*/
+class TimeSeriesVertexRing
+{
+public:
+	typedef TimeSeriesMaterial::Vertex Vertex;
+
+	struct VertexRange
+	{
+		int m_begin;
+		int m_end;
+	};
+
+	/*!
+		\fn TimeSeriesVertexRing::update(std::vector<Vertex> const &points, std::vector<int> const &gapIndices)
+
+		Updates the ring to contain the segments between consecutive
+		\c points, which are raw (not offset) timestamp/value pairs.
+		\c gapIndices contains the indices of the points that follow a gap,
+		in ascending order. These points are not connected to the ones
+		before them.
+	*/
+	void update(std::vector<Vertex> const &points, std::vector<int> const &gapIndices);
+
+	/*!
+		\fn TimeSeriesVertexRing::clear()
+
+		Removes all segments and releases the vertices.
+	*/
+	void clear();
+
+	std::vector<Vertex> const & vertices() const;
+	int timeOffset() const;
+	bool isFullyDirty() const;
+	std::vector<VertexRange> const & dirtyVertexRanges() const;
+
+	/*!
+		\fn TimeSeriesVertexRing::publishVertices()
+
+		Returns a copy of the vertices that is not modified afterwards,
+		as long as the caller holds a reference to it. The copy shares
+		memory with previously published ones once those are released.
+	*/
+	std::shared_ptr<std::vector<Vertex> const> publishVertices();
+
+private:
+	// One of the two buffers that publishVertices() alternates between,
+	// together with the vertices that changed since it was last filled.
+	struct SharedVertices
+	{
+		std::shared_ptr<std::vector<Vertex>> m_vertices;
+		bool m_isFullyDirty = true;
+		std::vector<VertexRange> m_dirtyVertexRanges;
+	};
+
+	void rebuild(std::vector<Vertex> const &points, std::vector<int> const &gapIndices);
+	bool findRetainedRun(std::vector<Vertex> const &points, std::vector<int> const &gapIndices, int &firstOldPointIndex, int &firstNewPointIndex, int &numRunPoints, int &timeShift) const;
+	void writeSegment(int slot, Vertex const &start, Vertex const &end, bool isGap);
+	void clearSlot(int slot);
+	void markSlotDirty(int slot);
+	void markAllSharedVerticesDirty();
+
+	// Slot #i consists of vertices #(2*i) and #(2*i+1).
+	std::vector<Vertex> m_vertices;
+	int m_numSlots = 0;
+	// The segments of the series occupy m_numUsedSlots slots,
+	// starting at m_firstUsedSlot, wrapping around at the end.
+	int m_firstUsedSlot = 0;
+	int m_numUsedSlots = 0;
+	int m_timeOffset = 0;
+
+	// The points and gaps from the last update, with raw timestamps.
+	std::vector<Vertex> m_points;
+	std::vector<int> m_gapIndices;
+
+	bool m_isFullyDirty = false;
+	std::vector<VertexRange> m_dirtyVertexRanges;
+
+	SharedVertices m_sharedVertices[2];
+	int m_lastPublishedIndex = -1;
+};
+
+
+#endif // TIMESERIESVERTEXRING_HPP
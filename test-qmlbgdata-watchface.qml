@@ -32,35 +32,18 @@ Item {
 		}
 	}
 
-	Timer {
-		id: minutesAgoUpdatesTimer
-
-		interval: 30 * 1000
-		running: false
-		repeat: true
-		triggeredOnStart: true
-
-		onTriggered: {
-			var timespans = bgDataReceiver.getTimespansSince(new Date());
-
-			if ((timespans.bgStatusUpdate == null) && (timespans.lastLoopRun == null))
-				stop();
-
-			minutesAgoText.text = "";
-
-			if (timespans.bgStatusUpdate != null)
-				minutesAgoText.text += "lBG: " + parseInt(timespans.bgStatusUpdate / 60) + " ";
-			if (timespans.lastLoopRun != null)
-				minutesAgoText.text += "lLoop: " + parseInt(timespans.lastLoopRun / 60);
-		}
-	}
-
 	BGDataReceiver {
 		id: bgDataReceiver
 
 		onNewDataReceived: {
-			bgTimeSeriesView.bgTimeSeries = bgTimeSeries;
-			minutesAgoUpdatesTimer.restart();
+			bgTimeSeriesView.bgTimeSeriesPoints = bgTimeSeriesPoints;
+			basalTimeSeriesView.basalTimeSeriesPoints = basalTimeSeriesPoints;
+			basalTimeSeriesView.baseBasalTimeSeriesPoints = baseBasalTimeSeriesPoints;
+		}
+
+		// The forecast also changes when forecastHorizon does.
+		onBgForecastTimeSeriesChanged: {
+			bgTimeSeriesView.bgForecastTimeSeries = bgForecastTimeSeries;
 		}
 
 		onUnitChanged: {
@@ -205,6 +188,15 @@ Item {
 			border.width: 1
 			color: "transparent"
 
+			BGBasalTimeSeriesView {
+				id: basalTimeSeriesView
+				anchors.left: parent.left
+				anchors.right: parent.right
+				anchors.bottom: parent.bottom
+				height: parent.height * 0.25
+				color: "blue"
+			}
+
 			BGTimeSeriesView {
 				id: bgTimeSeriesView
 				anchors.fill: parent
@@ -225,7 +217,16 @@ Item {
 			horizontalAlignment: Text.AlignHCenter
 			verticalAlignment: Text.AlignVCenter
 
-			text: "";
+			text: {
+				var s = "";
+
+				if (bgDataReceiver.minutesSinceBgStatus != null)
+					s += "lBG: " + bgDataReceiver.minutesSinceBgStatus + " ";
+				if (bgDataReceiver.minutesSinceLastLoop != null)
+					s += "lLoop: " + bgDataReceiver.minutesSinceLastLoop;
+
+				return s;
+			}
 		}
 	}
 
@@ -0,0 +1,130 @@
+// Checks that nearestPointAt() finds the same point as a brute force
+// search over all points, including in steep sections of the graph,
+// where the nearest point may be far away from the one with the
+// closest timestamp.
+
+#include <random>
+#include <QPointF>
+#include <QPolygonF>
+#include <QtTest>
+#include "bgtimeseriesview.hpp"
+
+
+namespace
+{
+
+
+qreal const ITEM_WIDTH = 200.0;
+qreal const ITEM_HEIGHT = 100.0;
+int const NUM_TAPS = 2000;
+
+
+// Many points per pixel, with sudden jumps, so that the
+// graph has plenty of long, almost vertical sections.
+QPolygonF generateSteepSeries(int numPoints, unsigned int seed)
+{
+	std::mt19937 randomEngine(seed);
+	std::uniform_real_distribution<double> valueDistribution(0.0, 1.0);
+	std::bernoulli_distribution jumpDistribution(0.05);
+	std::normal_distribution<double> stepDistribution(0.0, 0.002);
+
+	QPolygonF points(numPoints);
+	double value = 0.5;
+	for (int i = 0; i < numPoints; ++i)
+	{
+		value = jumpDistribution(randomEngine) ? valueDistribution(randomEngine) : qBound(0.0, value + stepDistribution(randomEngine), 1.0);
+		points[i] = QPointF(double(i) / (numPoints - 1), value);
+	}
+
+	return points;
+}
+
+
+int findNearestIndex(QPolygonF const &points, qreal x, qreal y)
+{
+	int nearestIndex = -1;
+	double nearestDistanceSquared = 0.0;
+
+	for (int i = 0; i < points.size(); ++i)
+	{
+		QPointF delta = QPointF(points[i].x() * ITEM_WIDTH, (1.0 - points[i].y()) * ITEM_HEIGHT) - QPointF(x, y);
+		double distanceSquared = QPointF::dotProduct(delta, delta);
+		if ((nearestIndex < 0) || (distanceSquared < nearestDistanceSquared))
+		{
+			nearestIndex = i;
+			nearestDistanceSquared = distanceSquared;
+		}
+	}
+
+	return nearestIndex;
+}
+
+
+} // unnamed namespace end
+
+
+class TestBGTimeSeriesView
+	: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void nearestPointMatchesBruteForce_data();
+	void nearestPointMatchesBruteForce();
+	void nearestPointOfEmptySeries();
+};
+
+
+void TestBGTimeSeriesView::nearestPointMatchesBruteForce_data()
+{
+	QTest::addColumn<int>("numPoints");
+
+	QTest::newRow("fewer points than pixels") << 50;
+	QTest::newRow("about one point per pixel") << 288;
+	QTest::newRow("many points per pixel") << 8640;
+}
+
+
+void TestBGTimeSeriesView::nearestPointMatchesBruteForce()
+{
+	QFETCH(int, numPoints);
+
+	QPolygonF points = generateSteepSeries(numPoints, 1234);
+
+	BGTimeSeriesView view;
+	view.setWidth(ITEM_WIDTH);
+	view.setHeight(ITEM_HEIGHT);
+	view.setBGTimeSeriesPoints(points);
+
+	// Taps slightly outside of the item are included,
+	// since they may still hit the first or last point.
+	std::mt19937 randomEngine(5678);
+	std::uniform_real_distribution<double> xDistribution(-10.0, ITEM_WIDTH + 10.0);
+	std::uniform_real_distribution<double> yDistribution(-10.0, ITEM_HEIGHT + 10.0);
+
+	for (int tap = 0; tap < NUM_TAPS; ++tap)
+	{
+		qreal x = xDistribution(randomEngine);
+		qreal y = yDistribution(randomEngine);
+
+		QVariantMap nearestPoint = view.nearestPointAt(x, y);
+		int expectedIndex = findNearestIndex(points, x, y);
+
+		QVERIFY2(nearestPoint["index"].toInt() == expectedIndex, qPrintable(QString("tap at %1,%2: got point #%3, expected #%4").arg(x).arg(y).arg(nearestPoint["index"].toInt()).arg(expectedIndex)));
+	}
+}
+
+
+void TestBGTimeSeriesView::nearestPointOfEmptySeries()
+{
+	BGTimeSeriesView view;
+	view.setWidth(ITEM_WIDTH);
+	view.setHeight(ITEM_HEIGHT);
+
+	QVERIFY(view.nearestPointAt(ITEM_WIDTH * 0.5, ITEM_HEIGHT * 0.5).isEmpty());
+}
+
+
+QTEST_MAIN(TestBGTimeSeriesView)
+
+#include "tst_bgtimeseriesview.moc"
@@ -0,0 +1,317 @@
+// Compares the SIMD kernels against straightforward scalar reference
+// implementations. The results must agree bit for bit, so the doubles
+// are compared by their bit patterns instead of by value.
+//
+// This file is built once for every instruction set the platform has
+// (see tests/CMakeLists.txt). EXPECTED_SIMD_INSTRUCTION_SET contains the
+// name of the instruction set the kernels are expected to be built for.
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include <QPointF>
+#include <QtTest>
+#include "simdkernels.hpp"
+
+
+namespace
+{
+
+
+quint64 bitsOf(double value)
+{
+	quint64 bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+
+void referenceUnpackNormalizedInt16Pairs(char const *data, int numPairs, QPointF *points)
+{
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		quint8 const *bytes = reinterpret_cast<quint8 const *>(data + pairIndex * 4);
+		qint16 x = qint16(bytes[0] | (bytes[1] << 8));
+		qint16 y = qint16(bytes[2] | (bytes[3] << 8));
+		points[pairIndex] = QPointF(x / 32767.0, y / 32767.0);
+	}
+}
+
+
+void referenceComputePrefixSums(QPointF const *points, int numPoints, QPointF *prefixSums)
+{
+	double sumX = 0.0, sumY = 0.0;
+	prefixSums[0] = QPointF(sumX, sumY);
+
+	for (int pointIndex = 0; pointIndex < numPoints; ++pointIndex)
+	{
+		sumX += points[pointIndex].x();
+		sumY += points[pointIndex].y();
+		prefixSums[pointIndex + 1] = QPointF(sumX, sumY);
+	}
+}
+
+
+int referenceFindLargestTriangle(QPointF const *points, int begin, int end, QPointF const &firstPoint, QPointF const &thirdPoint)
+{
+	double x1 = firstPoint.x(), y1 = firstPoint.y();
+	double x3 = thirdPoint.x(), y3 = thirdPoint.y();
+
+	double bestArea = -1.0;
+	int bestIndex = begin;
+
+	for (int pointIndex = begin; pointIndex < end; ++pointIndex)
+	{
+		double x2 = points[pointIndex].x(), y2 = points[pointIndex].y();
+		double area = std::abs(x1 * (y2 - y3) + x2 * (y3 - y1) + x3 * (y1 - y2));
+		if (area > bestArea)
+		{
+			bestArea = area;
+			bestIndex = pointIndex;
+		}
+	}
+
+	return bestIndex;
+}
+
+
+// Sizes that cover empty inputs, inputs that are shorter than one
+// vector, and all possible tail lengths after the vectorized part.
+std::vector<int> testSizes()
+{
+	std::vector<int> sizes;
+	for (int size = 0; size <= 40; ++size)
+		sizes.push_back(size);
+	sizes.push_back(1000);
+	sizes.push_back(1001);
+	sizes.push_back(1003);
+	return sizes;
+}
+
+
+} // unnamed namespace end
+
+
+class TestSimdKernels
+	: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void unpackNormalizedInt16Pairs_random();
+	void unpackNormalizedInt16Pairs_edgeCases();
+	void computePrefixSums_random();
+	void computePrefixSums_edgeCases();
+	void findLargestTriangle_random();
+	void findLargestTriangle_edgeCases();
+
+private:
+	void checkUnpack(std::vector<char> const &data, int offset, int numPairs);
+	void checkPrefixSums(std::vector<QPointF> const &points);
+	void checkLargestTriangle(std::vector<QPointF> const &points, int begin, int end, QPointF const &firstPoint, QPointF const &thirdPoint);
+
+	std::mt19937 m_randomEngine{ 20240601 };
+};
+
+
+void TestSimdKernels::initTestCase()
+{
+	QCOMPARE(QString(simdInstructionSet()), QString(EXPECTED_SIMD_INSTRUCTION_SET));
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	if ((std::strcmp(EXPECTED_SIMD_INSTRUCTION_SET, "AVX2") == 0) && !__builtin_cpu_supports("avx2"))
+		QSKIP("This CPU does not support AVX2");
+#endif
+}
+
+
+void TestSimdKernels::checkUnpack(std::vector<char> const &data, int offset, int numPairs)
+{
+	std::vector<QPointF> expected(numPairs), actual(numPairs);
+	referenceUnpackNormalizedInt16Pairs(data.data() + offset, numPairs, expected.data());
+	unpackNormalizedInt16Pairs(data.data() + offset, numPairs, actual.data());
+
+	for (int i = 0; i < numPairs; ++i)
+	{
+		QVERIFY2(bitsOf(actual[i].x()) == bitsOf(expected[i].x()), qPrintable(QString("x of pair #%1 of %2 differs").arg(i).arg(numPairs)));
+		QVERIFY2(bitsOf(actual[i].y()) == bitsOf(expected[i].y()), qPrintable(QString("y of pair #%1 of %2 differs").arg(i).arg(numPairs)));
+	}
+}
+
+
+void TestSimdKernels::unpackNormalizedInt16Pairs_random()
+{
+	std::uniform_int_distribution<int> byteDistribution(0, 255);
+
+	for (int numPairs : testSizes())
+	{
+		// One extra byte, so that the data can also be read
+		// from an address that is not aligned to 2 bytes.
+		std::vector<char> data(numPairs * 4 + 1);
+		for (auto & byte : data)
+			byte = char(byteDistribution(m_randomEngine));
+
+		checkUnpack(data, 0, numPairs);
+		checkUnpack(data, 1, numPairs);
+	}
+}
+
+
+void TestSimdKernels::unpackNormalizedInt16Pairs_edgeCases()
+{
+	qint16 const edgeValues[] = { -32768, -32767, -16384, -1, 0, 1, 16383, 32766, 32767 };
+	int const numEdgeValues = sizeof(edgeValues) / sizeof(edgeValues[0]);
+
+	// Combine every edge value with every other edge value.
+	int const numPairs = numEdgeValues * numEdgeValues;
+	std::vector<char> data(numPairs * 4 + 1);
+
+	for (int i = 0; i < numPairs; ++i)
+	{
+		quint16 x = quint16(edgeValues[i / numEdgeValues]);
+		quint16 y = quint16(edgeValues[i % numEdgeValues]);
+		char *pair = data.data() + i * 4;
+		pair[0] = char(x & 0xFF);
+		pair[1] = char(x >> 8);
+		pair[2] = char(y & 0xFF);
+		pair[3] = char(y >> 8);
+	}
+
+	for (int count = 0; count <= numPairs; ++count)
+		checkUnpack(data, 0, count);
+}
+
+
+void TestSimdKernels::checkPrefixSums(std::vector<QPointF> const &points)
+{
+	int numPoints = int(points.size());
+	std::vector<QPointF> expected(numPoints + 1), actual(numPoints + 1);
+	referenceComputePrefixSums(points.data(), numPoints, expected.data());
+	computePrefixSums(points.data(), numPoints, actual.data());
+
+	for (int i = 0; i <= numPoints; ++i)
+	{
+		QVERIFY2(bitsOf(actual[i].x()) == bitsOf(expected[i].x()), qPrintable(QString("x of prefix sum #%1 of %2 differs").arg(i).arg(numPoints)));
+		QVERIFY2(bitsOf(actual[i].y()) == bitsOf(expected[i].y()), qPrintable(QString("y of prefix sum #%1 of %2 differs").arg(i).arg(numPoints)));
+	}
+}
+
+
+void TestSimdKernels::computePrefixSums_random()
+{
+	std::uniform_real_distribution<double> coordinateDistribution(0.0, 1.0);
+
+	for (int numPoints : testSizes())
+	{
+		std::vector<QPointF> points(numPoints);
+		for (auto & point : points)
+			point = QPointF(coordinateDistribution(m_randomEngine), coordinateDistribution(m_randomEngine));
+
+		checkPrefixSums(points);
+	}
+}
+
+
+void TestSimdKernels::computePrefixSums_edgeCases()
+{
+	double const denormal = std::numeric_limits<double>::denorm_min();
+	double const huge = std::numeric_limits<double>::max();
+	double const infinity = std::numeric_limits<double>::infinity();
+
+	// Values whose sums round differently depending on the order
+	// of the additions, plus overflows, signed zeros and denormals.
+	checkPrefixSums({ QPointF(1.0, 1e-17), QPointF(1e-17, 1.0), QPointF(-1.0, 1e17), QPointF(1e-17, -1e17) });
+	checkPrefixSums({ QPointF(-0.0, -0.0), QPointF(-0.0, 0.0), QPointF(0.0, -0.0) });
+	checkPrefixSums({ QPointF(denormal, -denormal), QPointF(denormal, denormal), QPointF(-denormal, denormal) });
+	checkPrefixSums({ QPointF(huge, -huge), QPointF(huge, -huge), QPointF(-huge, huge) });
+	checkPrefixSums({ QPointF(infinity, 1.0), QPointF(-infinity, 2.0), QPointF(3.0, 4.0) });
+}
+
+
+void TestSimdKernels::checkLargestTriangle(std::vector<QPointF> const &points, int begin, int end, QPointF const &firstPoint, QPointF const &thirdPoint)
+{
+	int expected = referenceFindLargestTriangle(points.data(), begin, end, firstPoint, thirdPoint);
+	int actual = findLargestTriangle(points.data(), begin, end, firstPoint, thirdPoint);
+	QVERIFY2(actual == expected, qPrintable(QString("range [%1, %2): expected index %3, got %4").arg(begin).arg(end).arg(expected).arg(actual)));
+}
+
+
+void TestSimdKernels::findLargestTriangle_random()
+{
+	std::uniform_real_distribution<double> coordinateDistribution(0.0, 1.0);
+
+	for (int numPoints : testSizes())
+	{
+		std::vector<QPointF> points(numPoints);
+		for (auto & point : points)
+			point = QPointF(coordinateDistribution(m_randomEngine), coordinateDistribution(m_randomEngine));
+
+		QPointF firstPoint(-0.1, coordinateDistribution(m_randomEngine));
+		QPointF thirdPoint(1.1, coordinateDistribution(m_randomEngine));
+
+		// Subranges with all possible alignments at the start and end.
+		for (int begin = 0; begin <= std::min(numPoints, 5); ++begin)
+		{
+			for (int end = std::max(begin, numPoints - 5); end <= numPoints; ++end)
+				checkLargestTriangle(points, begin, end, firstPoint, thirdPoint);
+		}
+	}
+}
+
+
+void TestSimdKernels::findLargestTriangle_edgeCases()
+{
+	double const nan = std::numeric_limits<double>::quiet_NaN();
+	QPointF const firstPoint(0.0, 0.0);
+	QPointF const thirdPoint(1.0, 0.0);
+
+	for (int numPoints : testSizes())
+	{
+		if (numPoints > 40)
+			continue;
+
+		// All points form triangles with the same area.
+		// The first point of the range must win.
+		std::vector<QPointF> samePoints(numPoints, QPointF(0.5, 0.5));
+		for (int begin = 0; begin <= std::min(numPoints, 5); ++begin)
+			checkLargestTriangle(samePoints, begin, numPoints, firstPoint, thirdPoint);
+
+		// All points are collinear with the first and third point,
+		// so all areas are zero (some of them negative zero).
+		std::vector<QPointF> collinearPoints(numPoints);
+		for (int i = 0; i < numPoints; ++i)
+			collinearPoints[i] = QPointF(double(i) / 40.0, (i % 2) ? -0.0 : 0.0);
+		checkLargestTriangle(collinearPoints, 0, numPoints, firstPoint, thirdPoint);
+
+		// All areas are NaN. No point is larger than the initial
+		// area, so the start of the range is returned.
+		std::vector<QPointF> nanPoints(numPoints, QPointF(nan, nan));
+		checkLargestTriangle(nanPoints, 0, numPoints, firstPoint, thirdPoint);
+
+		// The largest area occurs twice, in every combination of
+		// positions, so that the duplicates end up in the same lane,
+		// in different lanes, and in the scalar tail.
+		for (int first = 0; first < numPoints; ++first)
+		{
+			for (int second = first + 1; second < numPoints; ++second)
+			{
+				std::vector<QPointF> points(numPoints, QPointF(0.5, 0.25));
+				points[first] = QPointF(0.3, 0.75);
+				points[second] = QPointF(0.7, 0.75);
+				// NaN areas in between must not affect the result.
+				if (second + 1 < numPoints)
+					points[second + 1] = QPointF(nan, 0.5);
+				checkLargestTriangle(points, 0, numPoints, firstPoint, thirdPoint);
+				checkLargestTriangle(points, first, numPoints, firstPoint, thirdPoint);
+			}
+		}
+	}
+}
+
+
+QTEST_APPLESS_MAIN(TestSimdKernels)
+
+#include "tst_simdkernels.moc"
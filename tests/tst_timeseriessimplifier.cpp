@@ -0,0 +1,200 @@
+// Checks that the parallel LTTB point selection produces exactly the
+// same points as the serial one, for 1 to 8 threads, and that the
+// incremental LTTB variant produces the same points as a full run.
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <QPointF>
+#include <QThreadPool>
+#include <QtTest>
+#include "timeseriessimplifier.hpp"
+
+
+namespace
+{
+
+
+// Large enough for the selection to be split into 8 chunks
+// (see MIN_PARALLEL_CHUNK_SOURCE_POINTS in timeseriessimplifier.cpp).
+int const NUM_SOURCE_POINTS = 300000;
+int const MAX_NUM_THREADS = 8;
+int const NUM_INCREMENTAL_BUCKETS = 50;
+
+
+std::vector<QPointF> generateRandomWalk(int numPoints, double xScale, double yScale, bool quantize, unsigned int seed)
+{
+	std::mt19937 randomEngine(seed);
+	std::normal_distribution<double> stepDistribution(0.0, 0.01);
+
+	std::vector<QPointF> points(numPoints);
+	double value = 0.5;
+	for (int i = 0; i < numPoints; ++i)
+	{
+		value = qBound(0.0, value + stepDistribution(randomEngine), 1.0);
+		// BGDataReceiver series are normalized int16 values, so
+		// neighbouring readings often have the exact same value.
+		double y = quantize ? (std::round(value * 400.0) / 400.0) : value;
+		points[i] = QPointF(i * xScale / (numPoints - 1), y * yScale);
+	}
+
+	return points;
+}
+
+
+} // unnamed namespace end
+
+
+class TestTimeSeriesSimplifier
+	: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void parallelSelectionMatchesSerial_data();
+	void parallelSelectionMatchesSerial();
+	void incrementalMatchesFullRecompute_data();
+	void incrementalMatchesFullRecompute();
+};
+
+
+void TestTimeSeriesSimplifier::initTestCase()
+{
+	// Make sure that there are worker threads for all chunks
+	// even on machines with fewer cores.
+	QThreadPool::globalInstance()->setMaxThreadCount(MAX_NUM_THREADS);
+}
+
+
+void TestTimeSeriesSimplifier::parallelSelectionMatchesSerial_data()
+{
+	QTest::addColumn<bool>("dynamic");
+	QTest::addColumn<int>("numBuckets");
+	QTest::addColumn<double>("xScale");
+	QTest::addColumn<double>("yScale");
+	QTest::addColumn<bool>("quantize");
+
+	for (bool dynamic : { false, true })
+	{
+		char const *mode = dynamic ? "dynamic LTTB" : "LTTB";
+		for (int numBuckets : { 600, 5000 })
+		{
+			QTest::newRow(qPrintable(QString("%1, %2 buckets").arg(mode).arg(numBuckets))) << dynamic << numBuckets << 1.0 << 1.0 << false;
+			QTest::newRow(qPrintable(QString("%1, %2 buckets, quantized").arg(mode).arg(numBuckets))) << dynamic << numBuckets << 1.0 << 1.0 << true;
+			// Coordinates that are so close together that a fuzzy
+			// comparison considers different points to be equal.
+			QTest::newRow(qPrintable(QString("%1, %2 buckets, tiny scale").arg(mode).arg(numBuckets))) << dynamic << numBuckets << 1e-9 << 1e-13 << false;
+		}
+	}
+}
+
+
+void TestTimeSeriesSimplifier::parallelSelectionMatchesSerial()
+{
+	QFETCH(bool, dynamic);
+	QFETCH(int, numBuckets);
+	QFETCH(double, xScale);
+	QFETCH(double, yScale);
+	QFETCH(bool, quantize);
+
+	std::vector<QPointF> sourcePoints = generateRandomWalk(NUM_SOURCE_POINTS, xScale, yScale, quantize, 1234);
+
+	auto simplify = [&](int maxNumThreads) {
+		TimeSeriesSimplifier simplifier;
+		simplifier.setMaxNumThreads(maxNumThreads);
+		std::vector<QPointF> destPoints;
+		if (dynamic)
+			simplifier.simplifyDynamicLTTB(sourcePoints.data(), int(sourcePoints.size()), numBuckets, destPoints);
+		else
+			simplifier.simplifyLTTB(sourcePoints.data(), int(sourcePoints.size()), numBuckets, destPoints);
+		return destPoints;
+	};
+
+	std::vector<QPointF> serialPoints = simplify(1);
+
+	for (int numThreads = 2; numThreads <= MAX_NUM_THREADS; ++numThreads)
+	{
+		std::vector<QPointF> parallelPoints = simplify(numThreads);
+		QCOMPARE(parallelPoints.size(), serialPoints.size());
+
+		for (std::size_t i = 0; i < serialPoints.size(); ++i)
+		{
+			bool samePoint = (parallelPoints[i].x() == serialPoints[i].x()) && (parallelPoints[i].y() == serialPoints[i].y());
+			QVERIFY2(samePoint, qPrintable(QString("%1 threads: point #%2 differs").arg(numThreads).arg(int(i))));
+		}
+	}
+}
+
+
+void TestTimeSeriesSimplifier::incrementalMatchesFullRecompute_data()
+{
+	QTest::addColumn<int>("bucketSize");
+	QTest::addColumn<int>("numDroppedPoints");
+	QTest::addColumn<int>("numAppendedPoints");
+	QTest::addColumn<int>("numUpdates");
+
+	// Dropping and appending whole buckets keeps the anchored buckets of the
+	// incremental variant equally sized, so they are then exactly the
+	// buckets that a full LTTB run with the same bucket size uses.
+	for (int bucketSize : { 2, 5, 16 })
+	{
+		QTest::newRow(qPrintable(QString("bucket size %1, shift").arg(bucketSize))) << bucketSize << bucketSize << bucketSize << 30;
+		QTest::newRow(qPrintable(QString("bucket size %1, append").arg(bucketSize))) << bucketSize << 0 << bucketSize << 3;
+		QTest::newRow(qPrintable(QString("bucket size %1, drop").arg(bucketSize))) << bucketSize << bucketSize << 0 << 3;
+	}
+
+	QTest::newRow("bucket size 8, shift by 2 buckets") << 8 << 16 << 16 << 10;
+}
+
+
+void TestTimeSeriesSimplifier::incrementalMatchesFullRecompute()
+{
+	QFETCH(int, bucketSize);
+	QFETCH(int, numDroppedPoints);
+	QFETCH(int, numAppendedPoints);
+	QFETCH(int, numUpdates);
+
+	int numInitialPoints = 2 + bucketSize * (NUM_INCREMENTAL_BUCKETS - 2);
+	int numAllPoints = numInitialPoints + numUpdates * numAppendedPoints;
+	std::vector<QPointF> allPoints = generateRandomWalk(numAllPoints, numAllPoints / 1000.0, 1.0, false, 5678);
+
+	// Like the series from BGDataReceiver, each series
+	// starts at timestamp 0 and is shifted accordingly.
+	auto getSeries = [&](int begin, int end) {
+		std::vector<QPointF> series(allPoints.begin() + begin, allPoints.begin() + end);
+		double firstTimestamp = series.front().x();
+		for (QPointF &point : series)
+			point.rx() -= firstTimestamp;
+		return series;
+	};
+
+	TimeSeriesSimplifier incrementalSimplifier;
+	std::vector<QPointF> incrementalPoints;
+	std::vector<QPointF> series = getSeries(0, numInitialPoints);
+	incrementalSimplifier.simplifyLTTBIncrementally(series.data(), int(series.size()), NUM_INCREMENTAL_BUCKETS, incrementalPoints);
+
+	for (int update = 1; update <= numUpdates; ++update)
+	{
+		series = getSeries(update * numDroppedPoints, numInitialPoints + update * numAppendedPoints);
+		incrementalSimplifier.simplifyLTTBIncrementally(series.data(), int(series.size()), NUM_INCREMENTAL_BUCKETS, incrementalPoints);
+
+		TimeSeriesSimplifier fullSimplifier;
+		std::vector<QPointF> fullPoints;
+		int numFullBuckets = 2 + (int(series.size()) - 2) / bucketSize;
+		fullSimplifier.simplifyLTTB(series.data(), int(series.size()), numFullBuckets, fullPoints);
+
+		QCOMPARE(incrementalPoints.size(), fullPoints.size());
+
+		for (std::size_t i = 0; i < fullPoints.size(); ++i)
+		{
+			bool samePoint = (incrementalPoints[i].x() == fullPoints[i].x()) && (incrementalPoints[i].y() == fullPoints[i].y());
+			QVERIFY2(samePoint, qPrintable(QString("update %1: point #%2 differs").arg(update).arg(int(i))));
+		}
+	}
+}
+
+
+QTEST_APPLESS_MAIN(TestTimeSeriesSimplifier)
+
+#include "tst_timeseriessimplifier.moc"